@@ -0,0 +1,275 @@
+#include "Sampler.h"
+#include "RandomSampler.h"
+#include "CMJSampler.h"
+#include "SobolSampler.h"
+#include "ZSobolSampler.h"
+#include "MathUtils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Measures the cost of every sampler per call and the quality of its 2D
+// samples: the star discrepancy and the RMSE of a few analytic integrands over
+// many pixels, for powers of 4 samples per pixel. Usage: SamplerBenchmark [maxSpp]
+
+namespace {
+
+constexpr uint32_t filmSize = 256; // For the pixel indices of the Z-order sampler
+constexpr uint32_t seed = 7;
+
+constexpr uint32_t speedSamplesPerPixel = 64;
+constexpr uint32_t speedPixels = 4096;
+constexpr uint32_t speedCalls = 16; // Per sample
+constexpr uint64_t totalSpeedCalls = uint64_t(speedPixels) * speedSamplesPerPixel * speedCalls;
+
+struct CallCosts {
+    double get1D;
+    double get2D;
+};
+
+struct SamplerType {
+    std::string name;
+    std::function<std::unique_ptr<pt::Sampler>(uint32_t samplesPerPixel)> create;
+    // Calls on the concrete class, which is final, like in the render loop
+    std::function<CallCosts(pt::Sampler& sampler, float& sum)> measureDirectCalls;
+};
+
+struct Integrand {
+    std::string name;
+    std::function<double(double x, double y)> f;
+    double integral;
+};
+
+// Pixels spread over the film, so the Z-order sampler doesn't only see one block
+uint32_t getPixelIndex(uint32_t pixel) {
+    return (pixel * 2654435761u) % (filmSize * filmSize);
+}
+
+template <typename Function>
+double measureNanoseconds(uint64_t numCalls, Function function) {
+    auto start = std::chrono::steady_clock::now();
+    function();
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / numCalls;
+}
+
+// The sum keeps the calls from being optimized away
+template <typename SamplerClass>
+CallCosts measureCalls(SamplerClass& sampler, float& sum) {
+    CallCosts costs;
+    costs.get1D = measureNanoseconds(totalSpeedCalls, [&] {
+        for (uint32_t pixel = 0; pixel < speedPixels; pixel++) {
+            sampler.startPixel(getPixelIndex(pixel));
+            for (uint32_t s = 0; s < speedSamplesPerPixel; s++) {
+                for (uint32_t i = 0; i < speedCalls; i++) {
+                    sum += sampler.get1D();
+                }
+                sampler.startNextSample();
+            }
+        }
+    });
+    costs.get2D = measureNanoseconds(totalSpeedCalls, [&] {
+        for (uint32_t pixel = 0; pixel < speedPixels; pixel++) {
+            sampler.startPixel(getPixelIndex(pixel));
+            for (uint32_t s = 0; s < speedSamplesPerPixel; s++) {
+                for (uint32_t i = 0; i < speedCalls; i++) {
+                    sum += sampler.get2D().y;
+                }
+                sampler.startNextSample();
+            }
+        }
+    });
+    return costs;
+}
+
+template <typename SamplerClass>
+SamplerType makeSamplerType(const std::string& name,
+        std::function<std::unique_ptr<pt::Sampler>(uint32_t samplesPerPixel)> create) {
+    return { name, create, [](pt::Sampler& sampler, float& sum) {
+        return measureCalls(static_cast<SamplerClass&>(sampler), sum);
+    } };
+}
+
+std::vector<SamplerType> getSamplerTypes() {
+    return {
+        makeSamplerType<pt::RandomSampler>("random",
+            [](uint32_t spp) { return std::make_unique<pt::RandomSampler>(spp, seed); }),
+        makeSamplerType<pt::CMJSampler>("cmj",
+            [](uint32_t spp) { return std::make_unique<pt::CMJSampler>(spp, seed); }),
+        makeSamplerType<pt::SobolSampler>("sobol",
+            [](uint32_t spp) { return std::make_unique<pt::SobolSampler>(spp, seed); }),
+        makeSamplerType<pt::ZSobolSampler>("zsobol",
+            [](uint32_t spp) { return std::make_unique<pt::ZSobolSampler>(spp, filmSize, filmSize, seed); })
+    };
+}
+
+std::vector<Integrand> getIntegrands() {
+    // Disk of radius 1 around the origin, an isotropic Gaussian in the center
+    // and a step along x that doesn't line up with any power of two strata
+    constexpr double sigma = 0.2;
+    const double gaussian1D = std::sqrt(2.0 * pt::pi<double>) * sigma * std::erf(0.5 / (std::sqrt(2.0) * sigma));
+    return {
+        { "disk", [](double x, double y) { return x * x + y * y < 1.0 ? 1.0 : 0.0; }, pt::pi<double> / 4.0 },
+        { "gaussian", [=](double x, double y) {
+            return std::exp(-((x - 0.5) * (x - 0.5) + (y - 0.5) * (y - 0.5)) / (2.0 * sigma * sigma));
+        }, gaussian1D * gaussian1D },
+        { "step", [](double x, double) { return x < 1.0 / 3.0 ? 1.0 : 0.0; }, 1.0 / 3.0 }
+    };
+}
+
+// The 2D samples of the given call of every sample of a pixel, the calls before
+// it are 1D and 2D in turn like the bounces of a path
+std::vector<pt::Vec2> getPoints(pt::Sampler& sampler, uint32_t pixel, uint32_t call) {
+    std::vector<pt::Vec2> points;
+    sampler.startPixel(getPixelIndex(pixel));
+    for (uint32_t s = 0; s < sampler.getSamplesPerPixel(); s++) {
+        for (uint32_t i = 0; i < call; i++) {
+            if (i % 2 == 0) {
+                sampler.get1D();
+            }
+            else {
+                sampler.get2D();
+            }
+        }
+        points.push_back(sampler.get2D());
+        sampler.startNextSample();
+    }
+    return points;
+}
+
+// Exact L-infinity star discrepancy in O(N^2), the max over the anchored boxes
+// with corners at the point coordinates.
+// See: On the Computation of the Star Discrepancy (1993), Peter Bundschuh and Yanchun Zhu
+double computeStarDiscrepancy(std::vector<pt::Vec2> points) {
+    std::sort(points.begin(), points.end(), [](pt::Vec2 a, pt::Vec2 b) { return a.x < b.x; });
+    const size_t n = points.size();
+    std::vector<double> sortedY = { 0.0, 1.0 }; // y of the first i points between 0 and 1
+    double discrepancy = 0.0;
+    for (size_t i = 0; i <= n; i++) {
+        if (i > 0) {
+            sortedY.insert(std::upper_bound(sortedY.begin() + 1, sortedY.end() - 1, points[i - 1].y),
+                points[i - 1].y);
+        }
+        double x = i > 0 ? points[i - 1].x : 0.0;
+        double nextX = i < n ? points[i].x : 1.0;
+        for (size_t k = 0; k <= i; k++) {
+            double fraction = static_cast<double>(k) / n;
+            discrepancy = std::max(discrepancy, std::max(fraction - x * sortedY[k], nextX * sortedY[k + 1] - fraction));
+        }
+    }
+    return discrepancy;
+}
+
+void benchmarkSpeed(const std::vector<SamplerType>& samplerTypes) {
+    std::cout << "Nanoseconds per call (" << speedSamplesPerPixel << " spp, " << speedCalls << " calls per sample), "
+        "through the virtual interface, on the concrete class and batched with generateSamples()\n";
+    std::cout << std::left << std::setw(10) << "sampler" << std::right
+        << std::setw(10) << "get1D" << std::setw(10) << "get2D"
+        << std::setw(12) << "direct 1D" << std::setw(12) << "direct 2D"
+        << std::setw(12) << "batch 1D" << std::setw(12) << "batch 2D" << "\n";
+
+    float sum = 0.0f;
+    for (const SamplerType& type : samplerTypes) {
+        std::unique_ptr<pt::Sampler> sampler = type.create(speedSamplesPerPixel);
+        CallCosts virtualCosts = measureCalls<pt::Sampler>(*sampler, sum);
+        CallCosts directCosts = type.measureDirectCalls(*sampler, sum);
+
+        double batched[2];
+        for (uint32_t size = 1; size <= 2; size++) {
+            pt::SampleLayout layout;
+            for (uint32_t i = 0; i < speedCalls; i++) {
+                size == 1 ? layout.add1D() : layout.add2D();
+            }
+            std::vector<float> samples(speedSamplesPerPixel * layout.getNumFloats());
+            batched[size - 1] = measureNanoseconds(totalSpeedCalls, [&] {
+                for (uint32_t pixel = 0; pixel < speedPixels; pixel++) {
+                    sampler->startPixel(getPixelIndex(pixel));
+                    sampler->generateSamples(layout, 0, speedCalls, 0, speedSamplesPerPixel, samples.data(), speedSamplesPerPixel);
+                    sum += samples[pixel % samples.size()];
+                }
+            });
+        }
+
+        std::cout << std::left << std::setw(10) << type.name << std::right << std::fixed << std::setprecision(2)
+            << std::setw(10) << virtualCosts.get1D << std::setw(10) << virtualCosts.get2D
+            << std::setw(12) << directCosts.get1D << std::setw(12) << directCosts.get2D
+            << std::setw(12) << batched[0] << std::setw(12) << batched[1] << "\n";
+    }
+    std::cout << "(checksum " << sum << ")\n\n";
+}
+
+void benchmarkQuality(const std::vector<SamplerType>& samplerTypes, uint32_t maxSamplesPerPixel) {
+    const std::vector<Integrand> integrands = getIntegrands();
+    const uint32_t calls[] = { 0, 21 }; // The first 2D samples and those of a deep bounce
+
+    std::cout << "Quality of the 2D samples of a call, averaged over pixels: star discrepancy and the "
+        "RMSE of the pixel estimates of the integrands\n";
+    std::cout << std::left << std::setw(10) << "sampler" << std::right << std::setw(6) << "spp"
+        << std::setw(6) << "call" << std::setw(12) << "D*";
+    for (const Integrand& integrand : integrands) {
+        std::cout << std::setw(12) << integrand.name;
+    }
+    std::cout << "\n";
+
+    for (const SamplerType& type : samplerTypes) {
+        for (uint32_t samplesPerPixel = 1; samplesPerPixel <= maxSamplesPerPixel; samplesPerPixel *= 4) {
+            std::unique_ptr<pt::Sampler> sampler = type.create(samplesPerPixel);
+            // Enough pixels for stable errors, fewer for the quadratic discrepancy
+            const uint32_t numErrorPixels = std::max(64u, 65536u / samplesPerPixel);
+            const uint32_t numDiscrepancyPixels = pt::clamp(4096u / samplesPerPixel, 4u, 64u);
+
+            for (uint32_t call : calls) {
+                double discrepancy = 0.0;
+                std::vector<double> squaredErrors(integrands.size(), 0.0);
+                for (uint32_t pixel = 0; pixel < numErrorPixels; pixel++) {
+                    std::vector<pt::Vec2> points = getPoints(*sampler, pixel, call);
+                    for (size_t i = 0; i < integrands.size(); i++) {
+                        double estimate = 0.0;
+                        for (pt::Vec2 point : points) {
+                            estimate += integrands[i].f(point.x, point.y);
+                        }
+                        double error = estimate / points.size() - integrands[i].integral;
+                        squaredErrors[i] += error * error;
+                    }
+                    if (pixel < numDiscrepancyPixels) {
+                        discrepancy += computeStarDiscrepancy(points);
+                    }
+                }
+
+                std::cout << std::left << std::setw(10) << type.name << std::right
+                    << std::setw(6) << sampler->getSamplesPerPixel() << std::setw(6) << call
+                    << std::scientific << std::setprecision(3) << std::setw(12) << discrepancy / numDiscrepancyPixels;
+                for (double squaredError : squaredErrors) {
+                    std::cout << std::setw(12) << std::sqrt(squaredError / numErrorPixels);
+                }
+                std::cout << "\n";
+            }
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    uint32_t maxSamplesPerPixel = 4096;
+    if (argc > 1) {
+        maxSamplesPerPixel = static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10));
+        if (maxSamplesPerPixel == 0) {
+            std::cout << "[ERROR]: Usage: SamplerBenchmark [maxSpp]\n";
+            return 1;
+        }
+    }
+
+    std::vector<SamplerType> samplerTypes = getSamplerTypes();
+    benchmarkSpeed(samplerTypes);
+    benchmarkQuality(samplerTypes, maxSamplesPerPixel);
+    return 0;
+}
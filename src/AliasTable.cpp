@@ -0,0 +1,49 @@
+#include "AliasTable.h"
+
+namespace pt {
+
+AliasTable::AliasTable(const std::vector<float>& weights)
+    : bins_(weights.size())
+{
+    const size_t n = weights.size();
+    double sum = 0.0;
+    for (float weight : weights) {
+        sum += weight;
+    }
+
+    // Scaled probabilities, the average bin holds 1
+    std::vector<double> scaled(n);
+    std::vector<uint32_t> small;
+    std::vector<uint32_t> large;
+    for (size_t i = 0; i < n; i++) {
+        double probability = sum > 0.0 ? weights[i] / sum : 1.0 / n;
+        bins_[i].probability = static_cast<float>(probability);
+        bins_[i].alias = static_cast<uint32_t>(i);
+        scaled[i] = probability * n;
+        (scaled[i] < 1.0 ? small : large).push_back(static_cast<uint32_t>(i));
+    }
+
+    // Fill up every small bin with a large one
+    while (!small.empty() && !large.empty()) {
+        uint32_t s = small.back();
+        small.pop_back();
+        uint32_t l = large.back();
+        bins_[s].threshold = static_cast<float>(scaled[s]);
+        bins_[s].alias = l;
+        scaled[l] -= 1.0 - scaled[s];
+        if (scaled[l] < 1.0) {
+            large.pop_back();
+            small.push_back(l);
+        }
+    }
+
+    // The rest only differ from 1 by rounding
+    for (uint32_t i : large) {
+        bins_[i].threshold = 1.0f;
+    }
+    for (uint32_t i : small) {
+        bins_[i].threshold = 1.0f;
+    }
+}
+
+} // namespace pt
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace pt {
+
+// Samples an index of a discrete distribution in constant time with a single
+// uniform sample. Every bin holds the probability of its own index and an
+// alias that takes the rest of the bin.
+// See: A Linear Algorithm for Generating Random Numbers With a Given Distribution (1991), Michael Vose
+class AliasTable {
+public:
+    AliasTable() = default;
+    // The weights don't have to be normalized, if all of them are zero the
+    // distribution is uniform
+    explicit AliasTable(const std::vector<float>& weights);
+
+    // Returns the index for u in [0, 1) and its probability
+    size_t sample(float u, float* probability = nullptr) const {
+        float scaled = u * bins_.size();
+        size_t index = static_cast<size_t>(scaled);
+        index = index < bins_.size() ? index : bins_.size() - 1;
+        const Bin& bin = bins_[index];
+        if (scaled - index >= bin.threshold) {
+            index = bin.alias;
+        }
+        if (probability) {
+            *probability = bins_[index].probability;
+        }
+        return index;
+    }
+
+    float getProbability(size_t index) const { return bins_[index].probability; }
+    size_t size() const { return bins_.size(); }
+    bool isEmpty() const { return bins_.empty(); }
+
+private:
+    struct Bin {
+        float threshold; // Below it the bin samples its own index
+        uint32_t alias;
+        float probability;
+    };
+
+    std::vector<Bin> bins_;
+};
+
+} // namespace pt
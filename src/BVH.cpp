@@ -1,5 +1,6 @@
 #include "BVH.h"
 #include "Shape.h"
+#include "RayStream.h"
 
 #include <algorithm>
 #include <cassert>
@@ -13,6 +14,38 @@ struct SplitBin {
     BoundingBox bounds = BoundingBox(Vec3(inf<float>), Vec3(-inf<float>));
 };
 
+// Moves the rays that hit the box to the front of the list and returns their
+// number. The box tests of a chunk of rays are done first in a loop that can
+// be vectorized, like testIntersection() for every ray.
+uint32_t partitionRays(const RayStream& stream, const BoundingBox& box, uint32_t* rays, uint32_t numRays) {
+    constexpr uint32_t chunkSize = 64;
+    bool hits[chunkSize];
+    uint32_t numHits = 0;
+    for (uint32_t chunkStart = 0; chunkStart < numRays; chunkStart += chunkSize) {
+        uint32_t chunkEnd = min(chunkStart + chunkSize, numRays);
+        for (uint32_t i = chunkStart; i < chunkEnd; i++) {
+            uint32_t ray = rays[i];
+            float t0x = (box.min.x - stream.origins.x[ray]) * stream.invDirections.x[ray];
+            float t0y = (box.min.y - stream.origins.y[ray]) * stream.invDirections.y[ray];
+            float t0z = (box.min.z - stream.origins.z[ray]) * stream.invDirections.z[ray];
+            float t1x = (box.max.x - stream.origins.x[ray]) * stream.invDirections.x[ray];
+            float t1y = (box.max.y - stream.origins.y[ray]) * stream.invDirections.y[ray];
+            float t1z = (box.max.z - stream.origins.z[ray]) * stream.invDirections.z[ray];
+            float tmin = max(max(min(t0x, t1x), min(t0y, t1y)), min(t0z, t1z));
+            float tmax = min(min(max(t0x, t1x), max(t0y, t1y)), max(t0z, t1z));
+            hits[i - chunkStart] = (tmin < stream.tmax[ray]) & (tmax >= max(0.0f, tmin));
+        }
+
+        for (uint32_t i = chunkStart; i < chunkEnd; i++) {
+            uint32_t ray = rays[i];
+            rays[i] = rays[numHits];
+            rays[numHits] = ray;
+            numHits += hits[i - chunkStart];
+        }
+    }
+    return numHits;
+}
+
 } // namespace
 
 
@@ -99,6 +132,76 @@ RayHit BVH::intersect(Ray ray) const {
     return closestHit;
 }
 
+void BVH::intersect(RayStream& stream, const std::vector<uint32_t>& rays) const {
+    traceStream(stream, rays, false);
+}
+
+void BVH::intersectAny(RayStream& stream, const std::vector<uint32_t>& rays) const {
+    traceStream(stream, rays, true);
+}
+
+void BVH::traceStream(RayStream& stream, const std::vector<uint32_t>& rays, bool anyHit) const {
+    for (uint32_t ray : rays) {
+        stream.hitDistances[ray] = rayMiss.t;
+        stream.hitShapes[ray] = nullptr;
+    }
+
+    // The rays of a node are always the first ones of the list, as they are a
+    // subset of the rays of its parent
+    std::vector<uint32_t>& traversalRays = stream.traversalRays;
+    traversalRays.assign(rays.begin(), rays.end());
+    struct StackEntry {
+        uint32_t nodeIndex;
+        uint32_t numRays;
+    };
+
+    constexpr uint32_t stackSize = 128; // Should be enough for moderately balanced trees
+    StackEntry traversalStack[stackSize];
+    uint32_t stackOffset = 0;
+    traversalStack[stackOffset++] = { rootNodeIndex_, static_cast<uint32_t>(rays.size()) };
+
+    while (stackOffset > 0) {
+        StackEntry entry = traversalStack[--stackOffset];
+        const LinearNode& node = linearNodes_[entry.nodeIndex];
+        uint32_t numRays = partitionRays(stream, node.bounds, traversalRays.data(), entry.numRays);
+        if (numRays == 0) {
+            continue;
+        }
+
+        if (!node.isLeaf()) {
+            // The near child of the first ray goes first
+            uint32_t firstChild = entry.nodeIndex + 1;
+            uint32_t secondChild = node.secondChildOffset;
+            bool raySign = node.splitAxis == 0 ? stream.directions.x[traversalRays[0]] < 0.0f
+                : node.splitAxis == 1 ? stream.directions.y[traversalRays[0]] < 0.0f
+                : stream.directions.z[traversalRays[0]] < 0.0f;
+            assert(stackOffset + 2 <= stackSize);
+            traversalStack[stackOffset++] = { raySign ? firstChild : secondChild, numRays };
+            traversalStack[stackOffset++] = { raySign ? secondChild : firstChild, numRays };
+            continue;
+        }
+
+        for (uint32_t i = 0; i < numRays; i++) {
+            uint32_t rayIndex = traversalRays[i];
+            Ray ray = stream.getRay(rayIndex);
+            for (uint32_t j = 0; j < node.numShapes; j++) {
+                RayHit hit = orderedShapes_[node.firstShapeIndex + j]->intersect(ray);
+                if (hit.t >= 0.0f && hit.t < ray.tmax) {
+                    stream.hitDistances[rayIndex] = hit.t;
+                    stream.hitNormals.set(rayIndex, hit.normal);
+                    stream.hitShapes[rayIndex] = hit.shape;
+                    // Rays with any hit are done, their boxes aren't hit anymore
+                    ray.tmax = anyHit ? -inf<float> : hit.t;
+                    if (anyHit) {
+                        break;
+                    }
+                }
+            }
+            stream.tmax[rayIndex] = ray.tmax;
+        }
+    }
+}
+
 void BVH::traverse(const TraversalCallback& callback) const {
     constexpr uint32_t stackSize = 128; // Should be enough for moderately balanced trees
     uint32_t traversalStack[stackSize];
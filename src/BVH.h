@@ -9,6 +9,7 @@ namespace pt {
 
 class Shape;
 struct Ray;
+struct RayStream;
 
 // See: On fast Construction of SAH-based Bounding Volume Hierarchies (2007), Wald
 class BVH {
@@ -30,6 +31,15 @@ public:
 
     BVH(const std::vector<const Shape*>& shapes, uint32_t maxShapesPerLeaf);
     RayHit intersect(Ray ray) const;
+    // Closest hits of the listed rays of the stream. The rays traverse the tree
+    // together, the box of a node is tested in one loop over all rays that reach
+    // it and a node is only fetched once for all of them.
+    // See: Dynamic Ray Stream Traversal (2014), Barringer and Akenine-Möller
+    void intersect(RayStream& stream, const std::vector<uint32_t>& rays) const;
+    // Any hit before the tmax of every listed ray, without searching for the closest one
+    void intersectAny(RayStream& stream, const std::vector<uint32_t>& rays) const;
+
+    const BoundingBox& getBounds() const { return linearNodes_[rootNodeIndex_].bounds; }
 
     // Depth-first traversal (for testing purposes)
     void traverse(const TraversalCallback& callback) const;
@@ -60,6 +70,7 @@ private:
     uint32_t buildInternal(std::vector<BuildNode>& nodes, const std::vector<const Shape*>& shapes,
         std::vector<ShapeInfo>& shapeInfos, uint32_t left, uint32_t right);
     uint32_t flattenTree(uint32_t rootIndex, const std::vector<BuildNode>& buildNodes);
+    void traceStream(RayStream& stream, const std::vector<uint32_t>& rays, bool anyHit) const;
 
     std::vector<const Shape*> orderedShapes_;
     std::vector<LinearNode> linearNodes_;
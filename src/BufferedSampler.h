@@ -0,0 +1,122 @@
+#pragma once
+
+#include "Sampler.h"
+#include "MathUtils.h"
+
+#include <vector>
+#include <cassert>
+#include <cstdint>
+
+namespace pt {
+
+// Reads the samples of a batch of consecutive samples of a pixel from a
+// contiguous buffer, with the values of every float of the layout next to each
+// other for all samples of the batch.
+// A group of the layout is generated for a range of samples at once when a
+// sample reaches it, so the sampler shares the setup of every dimension across
+// the samples and can vectorize over them. Deep bounces are only reached by
+// some paths: every time a group runs out, its next range covers twice as many
+// samples, so at most about twice the samples that use a group are generated.
+// The values are the same as from the sampler, the calls have to follow the layout.
+template <typename SamplerType>
+class BufferedSampler {
+public:
+    BufferedSampler(SamplerType& sampler, const SampleLayout& layout)
+        : sampler_(sampler)
+        , layout_(layout)
+    {
+        // Calls after the last group form one more group
+        for (uint32_t endCall : layout.getGroupEnds()) {
+            groups_.push_back({ endCall });
+        }
+        if (groups_.empty() || groups_.back().endCall < layout.getNumCalls()) {
+            groups_.push_back({ layout.getNumCalls() });
+        }
+    }
+
+    void startPixel(uint32_t pixelIndex) {
+        sampler_.startPixel(pixelIndex);
+    }
+
+    // Starts the batch [firstSample, firstSample + numSamples) of the current
+    // pixel at its first sample
+    void startSamples(uint32_t firstSample, uint32_t numSamples) {
+        firstSample_ = firstSample;
+        numSamples_ = numSamples;
+        samples_.resize(static_cast<size_t>(numSamples) * layout_.getNumFloats());
+        for (Group& group : groups_) {
+            group.endSample = 0;
+            group.numNextSamples = 1;
+        }
+        sampleIndex_ = 0;
+        startSample();
+    }
+
+    void startNextSample() {
+        sampleIndex_++;
+        assert(sampleIndex_ <= numSamples_);
+        startSample();
+    }
+
+    float get1D() {
+        assert(call_ < layout_.getNumCalls() && layout_.getCallSize(call_) == 1);
+        const float* values = getValues();
+        call_++;
+        return values[0];
+    }
+
+    Vec2 get2D() {
+        assert(call_ < layout_.getNumCalls() && layout_.getCallSize(call_) == 2);
+        const float* values = getValues();
+        call_++;
+        return Vec2(values[0], values[numSamples_]);
+    }
+
+private:
+    struct Group {
+        uint32_t endCall;
+        uint32_t endSample = 0; // The group is generated for the samples before it
+        uint32_t numNextSamples = 1;
+    };
+
+    void startSample() {
+        call_ = 0;
+        group_ = 0;
+        groupEndCall_ = 0;
+    }
+
+    const float* getValues() {
+        if (call_ == groupEndCall_) {
+            startGroup();
+        }
+        return &samples_[static_cast<size_t>(layout_.getFloatOffset(call_)) * numSamples_ + sampleIndex_];
+    }
+
+    // Enters the next group with the current sample
+    void startGroup() {
+        uint32_t firstCall = groupEndCall_;
+        Group& group = groups_[group_];
+        if (sampleIndex_ >= group.endSample) {
+            uint32_t endSample = sampleIndex_ + min(group.numNextSamples, numSamples_ - sampleIndex_);
+            sampler_.generateSamples(layout_, firstCall, group.endCall, firstSample_ + sampleIndex_,
+                endSample - sampleIndex_, &samples_[sampleIndex_], numSamples_);
+            group.endSample = endSample;
+            group.numNextSamples *= 2;
+        }
+        groupEndCall_ = group.endCall;
+        group_++;
+    }
+
+    SamplerType& sampler_;
+    const SampleLayout& layout_;
+    std::vector<Group> groups_;
+    std::vector<float> samples_;
+    uint32_t firstSample_ = 0;
+    uint32_t numSamples_ = 0;
+    uint32_t sampleIndex_ = 0; // Within the batch
+    uint32_t call_ = 0;
+    uint32_t group_ = 0; // The next group of the current sample
+    uint32_t groupEndCall_ = 0;
+};
+
+} // namespace pt
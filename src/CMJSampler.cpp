@@ -30,7 +30,8 @@ uint32_t cmjPermute(uint32_t i, uint32_t l, uint32_t p) {
     return (i + p) % l;
 }
 
-float cmjRandFloat(uint32_t i, uint32_t p) {
+// Random jitter within a stratum in 24 bit fixed point
+uint32_t cmjRandJitter(uint32_t i, uint32_t p) {
     i ^= p;
     i ^= i >> 17;
     i ^= i >> 10;       i *= 0xb36534e5;
@@ -38,7 +39,15 @@ float cmjRandFloat(uint32_t i, uint32_t p) {
     i ^= i >> 21;       i *= 0x93fc4795;
     i ^= 0xdf6e307f;
     i ^= i >> 17;       i *= 1 | p >> 18;
-    return i * (1.0f / 4294967808.0f);
+    return i >> 8;
+}
+
+// (stratum + jitter) / numStrata in fixed point, which converts to a float in
+// [0, 1) exactly. Floating point math would depend on how the compiler
+// vectorizes it with fast math, so batched samples could differ in the last bit.
+float cmjToFloat(uint32_t stratum, uint32_t jitter, uint32_t numStrata) {
+    uint64_t x = ((static_cast<uint64_t>(stratum) << 24) + jitter) / numStrata;
+    return static_cast<float>(static_cast<uint32_t>(x)) * 0x1p-24f;
 }
 
 } // namespace
@@ -46,59 +55,99 @@ float cmjRandFloat(uint32_t i, uint32_t p) {
 
 namespace pt {
 
-CMJSampler::CMJSampler(uint32_t samplesPerPixel)
-    : Sampler(samplesPerPixel)
+CMJSampler::CMJSampler(uint32_t samplesPerPixel, uint64_t seed)
+    : Sampler(samplesPerPixel, seed)
 {
     numSamplesX_ = static_cast<uint32_t>(std::sqrt(samplesPerPixel));
     numSamplesY_ = (samplesPerPixel - 1) / numSamplesX_ + 1;
     samplesPerPixel_ = numSamplesX_ * numSamplesY_;
 }
 
-std::unique_ptr<Sampler> CMJSampler::clone(uint64_t seed) {
-    return std::make_unique<CMJSampler>(samplesPerPixel_);
+std::unique_ptr<Sampler> CMJSampler::clone() const {
+    return std::make_unique<CMJSampler>(samplesPerPixel_, seed_);
+}
+
+const char* CMJSampler::getName() const {
+    return "cmj";
 }
 
 float CMJSampler::get1D() {
-    uint32_t n = samplesPerPixel_;
-    uint32_t p = hashedPixelIndex_ + nextPattern_;
+    uint32_t p = hashedPixelIndex_ + patternOffset_ + nextPattern_;
     nextPattern_++;
-
-    uint32_t s = sampleIndex_;
-    uint32_t sx = cmjPermute(s, n, p * 0x68bc21eb);
-    float jx = cmjRandFloat(s, p * 0x967a889b);
-    float x = (sx + jx) / n;
-
-    return min(x, oneMinusEpsilon<float>);
+    return sample1D(sampleIndex_, p);
 }
 
 Vec2 CMJSampler::get2D() {
-    uint32_t m = numSamplesX_;
-    uint32_t n = numSamplesY_;
-    uint32_t p = hashedPixelIndex_ + nextPattern_;
+    uint32_t p = hashedPixelIndex_ + patternOffset_ + nextPattern_;
     nextPattern_++;
-
-    uint32_t s = cmjPermute(sampleIndex_, samplesPerPixel_, p * 0x51633e2d);
-    uint32_t sx = cmjPermute(s % m, m, p * 0x68bc21eb);
-    uint32_t sy = cmjPermute(s / m, n, p * 0x02e5be93);
-    float jx = cmjRandFloat(s, p * 0x967a889b);
-    float jy = cmjRandFloat(s, p * 0x368cc8b7);
-    float x = (sx + (sy + jx) / n) / m;
-    float y = (s + jy) / samplesPerPixel_;
-
-    x = min(x, oneMinusEpsilon<float>);
-    y = min(y, oneMinusEpsilon<float>);
-    return Vec2(x, y);
+    return sample2D(sampleIndex_, p);
 }
 
 void CMJSampler::startNextSample() {
     sampleIndex_++;
     nextPattern_ = 0;
+    if (sampleIndex_ == samplesPerPixel_) {
+        sampleIndex_ = 0;
+        patternOffset_ += 0x9e3779b9;
+    }
+}
+
+void CMJSampler::startSample(uint32_t sampleIndex) {
+    sampleIndex_ = sampleIndex % samplesPerPixel_;
+    patternOffset_ = (sampleIndex / samplesPerPixel_) * 0x9e3779b9;
+    nextPattern_ = 0;
 }
 
 void CMJSampler::startPixel(uint32_t pixelIndex) {
-    hashedPixelIndex_ = hash(pixelIndex);
+    hashedPixelIndex_ = static_cast<uint32_t>(hash(pixelIndex ^ hash(seed_)));
     sampleIndex_ = 0;
+    patternOffset_ = 0;
     nextPattern_ = 0;
 }
 
+void CMJSampler::generateSamples(const SampleLayout& layout, uint32_t firstCall, uint32_t endCall,
+        uint32_t firstSample, uint32_t numSamples, float* samples, size_t stride) {
+    for (uint32_t call = firstCall; call < endCall; call++) {
+        float* values = samples + layout.getFloatOffset(call) * stride;
+        uint32_t p = hashedPixelIndex_ + call;
+        if (layout.getCallSize(call) == 1) {
+            for (uint32_t i = 0; i < numSamples; i++) {
+                uint32_t sampleIndex = firstSample + i;
+                uint32_t patternOffset = (sampleIndex / samplesPerPixel_) * 0x9e3779b9;
+                values[i] = sample1D(sampleIndex % samplesPerPixel_, p + patternOffset);
+            }
+        }
+        else {
+            for (uint32_t i = 0; i < numSamples; i++) {
+                uint32_t sampleIndex = firstSample + i;
+                uint32_t patternOffset = (sampleIndex / samplesPerPixel_) * 0x9e3779b9;
+                Vec2 value = sample2D(sampleIndex % samplesPerPixel_, p + patternOffset);
+                values[i] = value.x;
+                values[stride + i] = value.y;
+            }
+        }
+    }
+}
+
+// Sample s of the pattern p, every call of a sample uses the next pattern
+float CMJSampler::sample1D(uint32_t s, uint32_t p) const {
+    uint32_t sx = cmjPermute(s, samplesPerPixel_, p * 0x68bc21eb);
+    uint32_t jx = cmjRandJitter(s, p * 0x967a889b);
+    return cmjToFloat(sx, jx, samplesPerPixel_);
+}
+
+Vec2 CMJSampler::sample2D(uint32_t sampleIndex, uint32_t p) const {
+    uint32_t m = numSamplesX_;
+    uint32_t n = numSamplesY_;
+    uint32_t s = cmjPermute(sampleIndex, samplesPerPixel_, p * 0x51633e2d);
+    uint32_t sx = cmjPermute(s % m, m, p * 0x68bc21eb);
+    uint32_t sy = cmjPermute(s / m, n, p * 0x02e5be93);
+    uint32_t jx = cmjRandJitter(s, p * 0x967a889b);
+    uint32_t jy = cmjRandJitter(s, p * 0x368cc8b7);
+    // x = (sx + (sy + jx) / n) / m, the substrata of the columns are the rows
+    float x = cmjToFloat(sx * n + sy, jx, samplesPerPixel_);
+    float y = cmjToFloat(s, jy, samplesPerPixel_);
+    return Vec2(x, y);
+}
+
 } // namespace pt
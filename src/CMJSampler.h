@@ -8,20 +8,28 @@
 namespace pt {
 
 // See: Correlated Multi-Jittered Sampling (2013), Andrew Kensler
-class CMJSampler : public Sampler {
+class CMJSampler final : public Sampler {
 public:
-    CMJSampler(uint32_t samplesPerPixel);
+    CMJSampler(uint32_t samplesPerPixel, uint64_t seed = 0);
 
-    virtual std::unique_ptr<Sampler> clone(uint64_t seed) override;
+    virtual std::unique_ptr<Sampler> clone() const override;
+    virtual const char* getName() const override;
     virtual float get1D() override;
     virtual Vec2 get2D() override;
     virtual void startNextSample() override;
+    virtual void startSample(uint32_t sampleIndex) override;
     virtual void startPixel(uint32_t pixelIndex) override;
+    virtual void generateSamples(const SampleLayout& layout, uint32_t firstCall, uint32_t endCall,
+        uint32_t firstSample, uint32_t numSamples, float* samples, size_t stride) override;
 
 private:
+    float sample1D(uint32_t s, uint32_t p) const;
+    Vec2 sample2D(uint32_t sampleIndex, uint32_t p) const;
+
     uint32_t numSamplesX_;
     uint32_t numSamplesY_;
-    uint32_t sampleIndex_ = 0;
+    uint32_t sampleIndex_ = 0; // Index within the current pattern
+    uint32_t patternOffset_ = 0; // Selects a new pattern for every samplesPerPixel samples
     uint32_t hashedPixelIndex_ = 0;
     uint32_t nextPattern_ = 0;
 };
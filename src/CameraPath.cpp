@@ -0,0 +1,71 @@
+#include "CameraPath.h"
+#include "MathUtils.h"
+#include "Matrix4x4.h"
+
+#include <algorithm>
+
+namespace pt {
+
+void CameraPath::addKeyframe(const CameraKeyframe& keyframe) {
+    auto it = std::upper_bound(keyframes_.begin(), keyframes_.end(), keyframe.frame,
+        [](float frame, const CameraKeyframe& other) { return frame < other.frame; });
+    keyframes_.insert(it, keyframe);
+}
+
+CameraKeyframe CameraPath::evaluate(float frame) const {
+    if (keyframes_.empty()) {
+        return CameraKeyframe();
+    }
+    if (frame <= keyframes_.front().frame) {
+        return keyframes_.front();
+    }
+    if (frame >= keyframes_.back().frame) {
+        return keyframes_.back();
+    }
+
+    // Segment [i, i + 1] containing the frame, it has a length > 0
+    size_t i = std::upper_bound(keyframes_.begin(), keyframes_.end(), frame,
+        [](float frame, const CameraKeyframe& other) { return frame < other.frame; }) - keyframes_.begin() - 1;
+    const CameraKeyframe& k0 = keyframes_[i];
+    const CameraKeyframe& k1 = keyframes_[i + 1];
+    float length = k1.frame - k0.frame;
+    float t = (frame - k0.frame) / length;
+
+    // Cubic Hermite basis
+    float t2 = t * t;
+    float t3 = t2 * t;
+    float h00 = 2.0f * t3 - 3.0f * t2 + 1.0f;
+    float h10 = t3 - 2.0f * t2 + t;
+    float h01 = -2.0f * t3 + 3.0f * t2;
+    float h11 = t3 - t2;
+    auto interpolate = [&](Vec3 CameraKeyframe::* property) {
+        return h00 * (k0.*property) + (h10 * length) * getTangent(i, property) +
+            h01 * (k1.*property) + (h11 * length) * getTangent(i + 1, property);
+    };
+
+    CameraKeyframe result;
+    result.frame = frame;
+    result.position = interpolate(&CameraKeyframe::position);
+    result.target = interpolate(&CameraKeyframe::target);
+    result.up = interpolate(&CameraKeyframe::up);
+    result.fovY = lerp(k0.fovY, k1.fovY, t);
+    result.aperture = lerp(k0.aperture, k1.aperture, t);
+    result.focalDistance = lerp(k0.focalDistance, k1.focalDistance, t);
+    return result;
+}
+
+Camera CameraPath::getCamera(float frame) const {
+    CameraKeyframe keyframe = evaluate(frame);
+    return Camera(radians(keyframe.fovY), aspect_, keyframe.aperture, keyframe.focalDistance,
+        lookAt(keyframe.position, keyframe.target, keyframe.up));
+}
+
+// Change per frame at a keyframe, one-sided at the ends of the path
+Vec3 CameraPath::getTangent(size_t index, Vec3 CameraKeyframe::* property) const {
+    size_t previous = index > 0 ? index - 1 : index;
+    size_t next = min(index + 1, keyframes_.size() - 1);
+    float length = keyframes_[next].frame - keyframes_[previous].frame;
+    return length > 0.0f ? (keyframes_[next].*property - keyframes_[previous].*property) / length : Vec3(0.0f);
+}
+
+} // namespace pt
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Camera.h"
+#include "Vector3.h"
+
+#include <vector>
+
+namespace pt {
+
+struct CameraKeyframe {
+    float frame = 0.0f;
+    Vec3 position = Vec3(0.0f);
+    Vec3 target = Vec3(0.0f, 0.0f, -1.0f);
+    Vec3 up = Vec3(0.0f, 1.0f, 0.0f);
+    float fovY = 60.0f; // Degrees
+    float aperture = 0.0f;
+    float focalDistance = 0.0f;
+};
+
+// Camera animation through keyframes. Position, target and up vector follow a
+// Catmull-Rom spline (with tangents scaled to the frame spacing, so the speed is
+// continuous at keyframes), the other properties are interpolated linearly.
+class CameraPath {
+public:
+    explicit CameraPath(float aspect) : aspect_(aspect) {}
+
+    // Keyframes are kept sorted by frame
+    void addKeyframe(const CameraKeyframe& keyframe);
+
+    bool isEmpty() const { return keyframes_.empty(); }
+    float getFirstFrame() const { return keyframes_.empty() ? 0.0f : keyframes_.front().frame; }
+    float getLastFrame() const { return keyframes_.empty() ? 0.0f : keyframes_.back().frame; }
+
+    // The camera at any frame, clamped to the first and last keyframe
+    CameraKeyframe evaluate(float frame) const;
+    Camera getCamera(float frame) const;
+
+private:
+    Vec3 getTangent(size_t index, Vec3 CameraKeyframe::* property) const;
+
+    float aspect_;
+    std::vector<CameraKeyframe> keyframes_;
+};
+
+} // namespace pt
@@ -0,0 +1,168 @@
+#include "Checkpointer.h"
+
+#include <json.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+std::string getJobPath(const std::string& checkpointPath) {
+    return checkpointPath + ".job";
+}
+
+bool replaceFile(const std::string& tempPath, const std::string& path) {
+    if (std::rename(tempPath.c_str(), path.c_str()) == 0) {
+        return true;
+    }
+
+    // Renaming onto an existing file fails on some platforms
+    std::remove(path.c_str());
+    return std::rename(tempPath.c_str(), path.c_str()) == 0;
+}
+
+} // namespace
+
+namespace pt {
+
+std::string CheckpointJob::describeDifference(const CheckpointJob& other) const {
+    auto describeSampleRange = [](const CheckpointJob& job) {
+        return job.numSamples > 0 ? "sample range " + std::to_string(job.firstSample) + ":"
+            + std::to_string(job.numSamples) : std::string("all samples");
+    };
+
+    std::ostringstream difference;
+    auto addDifference = [&](const std::string& value, const std::string& otherValue) {
+        difference << (difference.tellp() > 0 ? ", " : "") << value << " instead of " << otherValue;
+    };
+    if (samplerName != other.samplerName) {
+        addDifference("sampler \"" + samplerName + "\"", "\"" + other.samplerName + "\"");
+    }
+    if (seed != other.seed) {
+        addDifference("seed " + std::to_string(seed), std::to_string(other.seed));
+    }
+    if (samplesPerPixel != other.samplesPerPixel) {
+        addDifference(std::to_string(samplesPerPixel) + " samples per pixel", std::to_string(other.samplesPerPixel));
+    }
+    if (firstSample != other.firstSample || numSamples != other.numSamples) {
+        addDifference(describeSampleRange(*this), describeSampleRange(other));
+    }
+    return difference.str();
+}
+
+Checkpointer::Checkpointer(const Film& film, const std::string& path, float intervalSeconds, const CheckpointJob& job)
+    : path_(path)
+    , intervalSeconds_(intervalSeconds)
+    , job_(job)
+    , snapshot_(film)
+    , writeBuffer_(film.getWidth(), film.getHeight())
+{
+    // The old checkpoint stays until the first snapshot replaces it, without a
+    // job file it can't be resumed by mistake in the meantime
+    CheckpointJob previousJob;
+    if (loadJob(path_, previousJob) && !previousJob.describeDifference(job_).empty()) {
+        std::remove(getJobPath(path_).c_str());
+    }
+
+    writerThread_ = std::thread([&] {
+        writerThreadMain();
+    });
+}
+
+Checkpointer::~Checkpointer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        shouldExit_ = true;
+    }
+    exitCondition_.notify_one();
+    writerThread_.join();
+}
+
+void Checkpointer::commitTile(const Film& film, const Film::Tile& tile) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    snapshot_.copyTile(film, tile);
+    isDirty_ = true;
+}
+
+void Checkpointer::writerThreadMain() {
+    auto interval = std::chrono::duration<float>(intervalSeconds_);
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (true) {
+        exitCondition_.wait_for(lock, interval, [&] { return shouldExit_; });
+
+        if (isDirty_) {
+            // Only the in-memory copy happens under the lock
+            writeBuffer_ = snapshot_;
+            isDirty_ = false;
+            lock.unlock();
+            if (!writeSnapshot()) {
+                std::cout << "[WARNING]: Failed to write the checkpoint \"" << path_ << "\"\n";
+            }
+            lock.lock();
+        }
+
+        if (shouldExit_) {
+            break;
+        }
+    }
+}
+
+bool Checkpointer::loadJob(const std::string& path, CheckpointJob& job) {
+    std::ifstream file(getJobPath(path));
+    if (!file.is_open()) {
+        return false;
+    }
+
+    auto root = nlohmann::json::parse(file, nullptr, false);
+    if (root.is_discarded() || !root.is_object() || !root.contains("sampler") || !root["sampler"].is_string()) {
+        return false;
+    }
+    for (const char* key : { "seed", "spp", "firstSample", "numSamples" }) {
+        if (!root.contains(key) || !root[key].is_number_unsigned()) {
+            return false;
+        }
+    }
+
+    job.samplerName = root.value("sampler", "");
+    job.seed = root.value("seed", uint64_t(0));
+    job.samplesPerPixel = root.value("spp", 0u);
+    job.firstSample = root.value("firstSample", 0u);
+    job.numSamples = root.value("numSamples", 0u);
+    return true;
+}
+
+bool Checkpointer::writeSnapshot() {
+    // Write to a temporary file first so a crash never leaves a broken checkpoint behind
+    std::string tempPath = path_ + ".tmp";
+    if (!writeBuffer_.saveRaw(tempPath) || !replaceFile(tempPath, path_)) {
+        return false;
+    }
+    return writeJob();
+}
+
+bool Checkpointer::writeJob() {
+    nlohmann::json root = {
+        { "sampler", job_.samplerName },
+        { "seed", job_.seed },
+        { "spp", job_.samplesPerPixel },
+        { "firstSample", job_.firstSample },
+        { "numSamples", job_.numSamples }
+    };
+
+    std::string jobPath = getJobPath(path_);
+    std::string tempPath = jobPath + ".tmp";
+    {
+        std::ofstream file(tempPath);
+        file << root.dump(4) << "\n";
+        if (!file.good()) {
+            return false;
+        }
+    }
+    return replaceFile(tempPath, jobPath);
+}
+
+} // namespace pt
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Film.h"
+
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+namespace pt {
+
+// What the samples of a checkpoint depend on besides the scene. Resuming with a
+// different job would mix up the sample sequences, so it's refused.
+struct CheckpointJob {
+    std::string samplerName;
+    uint64_t seed = 0;
+    uint32_t samplesPerPixel = 0;
+    uint32_t firstSample = 0; // Sample range of a partial render if numSamples > 0
+    uint32_t numSamples = 0;
+
+    // Lists the settings of this job that differ from the other one, e.g.
+    // "seed 3 instead of 0", empty if the jobs match
+    std::string describeDifference(const CheckpointJob& other) const;
+};
+
+// Periodically writes the accumulation buffer of a film to a raw film file.
+// Finished tiles are copied into a snapshot and a background thread writes
+// the snapshot, so rendering only pays for the tile copies.
+// The job is written to a file next to the checkpoint after every snapshot. A
+// job file of another job is removed first, so a checkpoint never appears to
+// belong to a job it doesn't contain the samples of.
+class Checkpointer {
+public:
+    Checkpointer(const Film& film, const std::string& path, float intervalSeconds, const CheckpointJob& job);
+    ~Checkpointer();
+
+    // Must only be called while no other thread is adding samples to the tile
+    void commitTile(const Film& film, const Film::Tile& tile);
+
+    // Returns false if the checkpoint has no valid job file
+    static bool loadJob(const std::string& path, CheckpointJob& job);
+
+private:
+    void writerThreadMain();
+    bool writeSnapshot();
+    bool writeJob();
+
+    std::string path_;
+    float intervalSeconds_;
+    CheckpointJob job_;
+    Film snapshot_;
+    Film writeBuffer_;
+    bool isDirty_ = false;
+    bool shouldExit_ = false;
+    std::mutex mutex_;
+    std::condition_variable exitCondition_;
+    std::thread writerThread_;
+};
+
+} // namespace pt
@@ -30,6 +30,12 @@ inline Vector3<T> srgbToLinear(const Vector3<T>& srgb) {
     return { srgbToLinear(srgb.r), srgbToLinear(srgb.g), srgbToLinear(srgb.b) };
 }
 
+// Relative luminance of a linear Rec. 709 color
+template <typename T>
+inline T luminance(const Vector3<T>& linear) {
+    return static_cast<T>(0.2126) * linear.r + static_cast<T>(0.7152) * linear.g + static_cast<T>(0.0722) * linear.b;
+}
+
 template <typename T>
 inline Vector3<T> tonemapReinhard(const Vector3<T>& hdrSrgb) {
     return saturate(hdrSrgb / (Vector3<T>(static_cast<T>(1)) + hdrSrgb));
@@ -0,0 +1,330 @@
+#include "Deflate.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <iterator>
+
+namespace {
+
+constexpr uint32_t kWindowSize = 32768;
+constexpr uint32_t kHashBits = 15;
+constexpr uint32_t kMaxChainLength = 16; // Same search effort as stb_image_write
+constexpr uint32_t kMinMatch = 3;
+constexpr uint32_t kMaxMatch = 258;
+constexpr uint32_t kMaxLazyMatch = 32; // Longer matches are taken without looking further
+constexpr uint32_t kEndOfBlock = 256;
+
+constexpr std::array<uint16_t, 29> kLengthBase = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+constexpr std::array<uint8_t, 29> kLengthExtraBits = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+constexpr std::array<uint16_t, 30> kDistanceBase = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+constexpr std::array<uint8_t, 30> kDistanceExtraBits = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+uint32_t reverseBits(uint32_t bits, uint32_t count) {
+    uint32_t result = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        result = (result << 1) | ((bits >> i) & 1);
+    }
+    return result;
+}
+
+// Bit-reversed fixed Huffman codes of the literal/length alphabet (RFC 1951 3.2.6)
+struct FixedHuffmanTable {
+    FixedHuffmanTable() {
+        for (uint32_t symbol = 0; symbol < 288; symbol++) {
+            uint32_t code, length;
+            if (symbol < 144) {
+                code = 0x30 + symbol;
+                length = 8;
+            }
+            else if (symbol < 256) {
+                code = 0x190 + symbol - 144;
+                length = 9;
+            }
+            else if (symbol < 280) {
+                code = symbol - 256;
+                length = 7;
+            }
+            else {
+                code = 0xc0 + symbol - 280;
+                length = 8;
+            }
+            codes[symbol] = static_cast<uint16_t>(reverseBits(code, length));
+            lengths[symbol] = static_cast<uint8_t>(length);
+        }
+    }
+
+    std::array<uint16_t, 288> codes;
+    std::array<uint8_t, 288> lengths;
+};
+
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& output) : output_(output) {}
+
+    // Deflate packs bits starting at the least significant bit of each byte
+    void write(uint32_t bits, uint32_t count) {
+        buffer_ |= static_cast<uint64_t>(bits) << count_;
+        count_ += count;
+        while (count_ >= 8) {
+            output_.push_back(static_cast<uint8_t>(buffer_));
+            buffer_ >>= 8;
+            count_ -= 8;
+        }
+    }
+
+    void alignToByte() {
+        if (count_ > 0) {
+            write(0, 8 - count_);
+        }
+    }
+
+private:
+    std::vector<uint8_t>& output_;
+    uint64_t buffer_ = 0;
+    uint32_t count_ = 0;
+};
+
+class FixedHuffmanEncoder {
+public:
+    explicit FixedHuffmanEncoder(BitWriter& writer) : writer_(writer) {}
+
+    void writeSymbol(uint32_t symbol) {
+        writer_.write(table_.codes[symbol], table_.lengths[symbol]);
+    }
+
+    void writeMatch(uint32_t length, uint32_t distance) {
+        size_t lengthCode = std::distance(kLengthBase.begin(),
+            std::upper_bound(kLengthBase.begin(), kLengthBase.end(), length)) - 1;
+        writeSymbol(257 + static_cast<uint32_t>(lengthCode));
+        writer_.write(length - kLengthBase[lengthCode], kLengthExtraBits[lengthCode]);
+
+        // Distance codes are 5 bit codes in the fixed Huffman block
+        size_t distanceCode = std::distance(kDistanceBase.begin(),
+            std::upper_bound(kDistanceBase.begin(), kDistanceBase.end(), distance)) - 1;
+        writer_.write(reverseBits(static_cast<uint32_t>(distanceCode), 5), 5);
+        writer_.write(distance - kDistanceBase[distanceCode], kDistanceExtraBits[distanceCode]);
+    }
+
+private:
+    static const FixedHuffmanTable table_;
+    BitWriter& writer_;
+};
+
+const FixedHuffmanTable FixedHuffmanEncoder::table_;
+
+// Hash chains over the positions of 3 byte sequences within the last 32 KB
+class MatchFinder {
+public:
+    MatchFinder(const uint8_t* data, size_t size)
+        : data_(data), size_(size), head_(size_t(1) << kHashBits, -1), previous_(size) {
+    }
+
+    void insert(size_t position) {
+        if (position + kMinMatch <= size_) {
+            uint32_t hash = computeHash(position);
+            previous_[position] = head_[hash];
+            head_[hash] = static_cast<int32_t>(position);
+        }
+    }
+
+    // Returns the length of the longest match (0 if none) and its distance
+    uint32_t findMatch(size_t position, uint32_t& distance) const {
+        if (position + kMinMatch > size_) {
+            return 0;
+        }
+
+        uint32_t maxLength = static_cast<uint32_t>(std::min<size_t>(kMaxMatch, size_ - position));
+        uint32_t bestLength = 0;
+        int32_t candidate = head_[computeHash(position)];
+        for (uint32_t i = 0; i < kMaxChainLength && candidate >= 0; i++) {
+            size_t candidateDistance = position - static_cast<size_t>(candidate);
+            if (candidateDistance > kWindowSize) {
+                break;
+            }
+
+            const uint8_t* a = data_ + candidate;
+            const uint8_t* b = data_ + position;
+            if (a[bestLength] == b[bestLength]) {
+                uint32_t length = computeMatchLength(a, b, maxLength);
+                if (length > bestLength) {
+                    bestLength = length;
+                    distance = static_cast<uint32_t>(candidateDistance);
+                    if (length == maxLength) {
+                        break;
+                    }
+                }
+            }
+            candidate = previous_[candidate];
+        }
+
+        return bestLength >= kMinMatch ? bestLength : 0;
+    }
+
+private:
+    // Compares eight bytes at a time while they fit
+    static uint32_t computeMatchLength(const uint8_t* a, const uint8_t* b, uint32_t maxLength) {
+        uint32_t length = 0;
+        while (length + 8 <= maxLength) {
+            uint64_t wordA, wordB;
+            std::memcpy(&wordA, a + length, sizeof(wordA));
+            std::memcpy(&wordB, b + length, sizeof(wordB));
+            uint64_t difference = wordA ^ wordB;
+            if (difference != 0) {
+                // Little-endian, so the first differing byte is the lowest non-zero one
+                while ((difference & 0xff) == 0) {
+                    difference >>= 8;
+                    length++;
+                }
+                return length;
+            }
+            length += 8;
+        }
+        while (length < maxLength && a[length] == b[length]) {
+            length++;
+        }
+        return length;
+    }
+
+    uint32_t computeHash(size_t position) const {
+        uint32_t key = data_[position] | (data_[position + 1] << 8) | (data_[position + 2] << 16);
+        return (key * 2654435761u) >> (32 - kHashBits);
+    }
+
+    const uint8_t* data_;
+    size_t size_;
+    std::vector<int32_t> head_;
+    std::vector<int32_t> previous_;
+};
+
+} // namespace
+
+namespace pt {
+
+std::vector<uint8_t> deflateChunk(const uint8_t* data, size_t size, bool isFinal) {
+    std::vector<uint8_t> output;
+    output.reserve(size / 2 + 64);
+    BitWriter writer(output);
+    FixedHuffmanEncoder encoder(writer);
+    MatchFinder matchFinder(data, size);
+
+    writer.write(isFinal ? 1 : 0, 1); // BFINAL
+    writer.write(1, 2); // BTYPE = fixed Huffman codes
+
+    size_t position = 0;
+    uint32_t distance = 0;
+    uint32_t length = matchFinder.findMatch(position, distance);
+    while (position < size) {
+        matchFinder.insert(position);
+
+        // Lazy matching: a longer match at the next byte wins over this one. It
+        // is kept for the next iteration, so no position is searched twice.
+        uint32_t nextDistance = 0;
+        uint32_t nextLength = 0;
+        bool hasNextMatch = false;
+        if (length > 0 && length < kMaxLazyMatch) {
+            nextLength = matchFinder.findMatch(position + 1, nextDistance);
+            hasNextMatch = true;
+            if (nextLength > length) {
+                length = 0;
+            }
+        }
+
+        if (length > 0) {
+            encoder.writeMatch(length, distance);
+            for (size_t i = position + 1; i < position + length; i++) {
+                matchFinder.insert(i);
+            }
+            position += length;
+            length = matchFinder.findMatch(position, distance);
+        }
+        else {
+            encoder.writeSymbol(data[position]);
+            position++;
+            if (hasNextMatch) {
+                length = nextLength;
+                distance = nextDistance;
+            }
+            else {
+                length = matchFinder.findMatch(position, distance);
+            }
+        }
+    }
+    encoder.writeSymbol(kEndOfBlock);
+
+    if (!isFinal) {
+        // Empty stored block to get back to a byte boundary (a "sync flush")
+        writer.write(0, 3);
+        writer.alignToByte();
+        output.insert(output.end(), { 0x00, 0x00, 0xff, 0xff });
+    }
+    writer.alignToByte();
+
+    return output;
+}
+
+uint32_t adler32(const uint8_t* data, size_t size, uint32_t adler) {
+    constexpr uint32_t base = 65521;
+    constexpr size_t maxBlockSize = 5552; // Largest block without overflowing the sums
+
+    uint32_t a = adler & 0xffff;
+    uint32_t b = adler >> 16;
+    while (size > 0) {
+        size_t blockSize = std::min(size, maxBlockSize);
+        for (size_t i = 0; i < blockSize; i++) {
+            a += data[i];
+            b += a;
+        }
+        a %= base;
+        b %= base;
+        data += blockSize;
+        size -= blockSize;
+    }
+
+    return a | (b << 16);
+}
+
+// Same as adler32_combine() of zlib
+uint32_t adler32Combine(uint32_t adler1, uint32_t adler2, size_t size2) {
+    constexpr uint32_t base = 65521;
+    uint32_t remainder = static_cast<uint32_t>(size2 % base);
+    uint32_t a = adler1 & 0xffff;
+    uint32_t b = static_cast<uint32_t>((static_cast<uint64_t>(remainder) * a) % base);
+    a += (adler2 & 0xffff) + base - 1;
+    b += (adler1 >> 16) + (adler2 >> 16) + base - remainder;
+    if (a >= base) a -= base;
+    if (a >= base) a -= base;
+    if (b >= 2 * base) b -= 2 * base;
+    if (b >= base) b -= base;
+    return a | (b << 16);
+}
+
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc) {
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> table;
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            }
+            table[i] = c;
+        }
+        return table;
+    }();
+
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+} // namespace pt
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+namespace pt {
+
+// Compresses data into raw deflate blocks (RFC 1951) with LZ77 and the fixed
+// Huffman codes. Non-final chunks end with an empty stored block, so they end
+// on a byte boundary and chunks that were compressed independently (e.g. on
+// different threads) can simply be concatenated into one stream.
+std::vector<uint8_t> deflateChunk(const uint8_t* data, size_t size, bool isFinal);
+
+// Checksums with the usual initial values. The Adler-32 of concatenated data can
+// be computed from the checksums of the parts.
+uint32_t adler32(const uint8_t* data, size_t size, uint32_t adler = 1);
+uint32_t adler32Combine(uint32_t adler1, uint32_t adler2, size_t size2);
+uint32_t crc32(const uint8_t* data, size_t size, uint32_t crc = 0);
+
+} // namespace pt
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "MathUtils.h"
+#include "Vector3.h"
+
+#include <cmath>
+
+namespace pt {
+
+// Bounds a set of directions by the directions within an angle of the axis
+struct DirectionCone {
+    DirectionCone() = default;
+    constexpr DirectionCone(const Vec3& axis_, float cosTheta_)
+        : axis(axis_)
+        , cosTheta(cosTheta_)
+    {
+    }
+
+    static constexpr DirectionCone entireSphere() {
+        return DirectionCone(Vec3(0.0f, 0.0f, 1.0f), -1.0f);
+    }
+
+    Vec3 axis;
+    float cosTheta;
+};
+
+// Accurate for small angles unlike the arc cosine of the dot product
+inline float angleBetween(const Vec3& a, const Vec3& b) {
+    if (dot(a, b) < 0.0f) {
+        return pi<float> - 2.0f * std::asin(min(0.5f * length(a + b), 1.0f));
+    }
+    return 2.0f * std::asin(min(0.5f * length(b - a), 1.0f));
+}
+
+// The smallest cone around both cones
+inline DirectionCone merge(const DirectionCone& a, const DirectionCone& b) {
+    float thetaA = std::acos(clamp(a.cosTheta, -1.0f, 1.0f));
+    float thetaB = std::acos(clamp(b.cosTheta, -1.0f, 1.0f));
+    float thetaD = angleBetween(a.axis, b.axis);
+    if (min(thetaD + thetaB, pi<float>) <= thetaA) {
+        return a;
+    }
+    if (min(thetaD + thetaA, pi<float>) <= thetaB) {
+        return b;
+    }
+
+    float theta = 0.5f * (thetaA + thetaD + thetaB);
+    Vec3 rotationAxis = cross(a.axis, b.axis);
+    if (theta >= pi<float>) {
+        return DirectionCone::entireSphere();
+    }
+    if (lengthSq(rotationAxis) == 0.0f) {
+        // Parallel axes, opposite ones need more than half the sphere
+        if (dot(a.axis, b.axis) < 0.0f) {
+            return DirectionCone::entireSphere();
+        }
+        return a.cosTheta < b.cosTheta ? a : b;
+    }
+
+    // Rotates the axis of a towards b, so the new cone just touches both
+    float rotation = theta - thetaA;
+    rotationAxis = normalize(rotationAxis);
+    Vec3 axis = a.axis * std::cos(rotation) + cross(rotationAxis, a.axis) * std::sin(rotation);
+    return DirectionCone(normalize(axis), std::cos(theta));
+}
+
+} // namespace pt
@@ -0,0 +1,406 @@
+#include "DistributedRenderer.h"
+#include "SceneFileParser.h"
+#include "ProgressBar.h"
+#include "Scene.h"
+#include "Camera.h"
+#include "MathUtils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+#ifndef _WIN32
+#include <poll.h>
+#include <spawn.h>
+#include <sys/wait.h>
+
+extern char** environ;
+#endif
+
+namespace {
+
+// Values per unit in a Work message: id, tile start and end, first sample and count
+constexpr size_t kWorkUnitSize = 7;
+
+// The coordinator gives up if no worker is connected for this long
+constexpr float kWorkerTimeoutSeconds = 60.0f;
+
+void appendUint32(std::vector<uint8_t>& data, uint32_t value) {
+    size_t offset = data.size();
+    data.resize(offset + sizeof(value));
+    std::memcpy(&data[offset], &value, sizeof(value));
+}
+
+uint32_t readUint32(const std::vector<uint8_t>& data, size_t index) {
+    uint32_t value;
+    std::memcpy(&value, &data[index * sizeof(value)], sizeof(value));
+    return value;
+}
+
+bool sendMessage(pt::Socket& socket, pt::MessageType type, const std::vector<uint8_t>& payload) {
+    return socket.sendMessage(static_cast<uint32_t>(type), payload.data(), payload.size());
+}
+
+bool sendMessage(pt::Socket& socket, pt::MessageType type, const std::string& payload = std::string()) {
+    return socket.sendMessage(static_cast<uint32_t>(type), payload);
+}
+
+std::string toString(const std::vector<uint8_t>& payload) {
+    return std::string(payload.begin(), payload.end());
+}
+
+} // namespace
+
+namespace pt {
+
+RenderCoordinator::RenderCoordinator(const nlohmann::json& job, uint32_t samplesPerUnit)
+    : job_(job), samplesPerUnit_(samplesPerUnit) {
+}
+
+RenderCoordinator::~RenderCoordinator() {
+#ifndef _WIN32
+    // Workers exit after Done or a closed connection, so this only waits briefly
+    connections_.clear();
+    for (int pid : spawnedWorkers_) {
+        waitpid(pid, nullptr, 0);
+    }
+#endif
+}
+
+bool RenderCoordinator::listen(uint16_t port) {
+    if (!listener_.listen(port)) {
+        std::cout << "[ERROR]: Couldn't listen on port " << port << "\n";
+        return false;
+    }
+
+    std::cout << "[INFO]: Waiting for workers on port " << listener_.getPort() << "\n";
+    return true;
+}
+
+bool RenderCoordinator::spawnLocalWorkers(const std::string& executablePath, uint32_t numWorkers, uint32_t threadsPerWorker) {
+#ifndef _WIN32
+    std::string address = "127.0.0.1:" + std::to_string(getPort());
+    std::string threads = std::to_string(threadsPerWorker);
+    for (uint32_t i = 0; i < numWorkers; i++) {
+        const char* arguments[] = { executablePath.c_str(), "worker", address.c_str(), "--threads", threads.c_str(), nullptr };
+        pid_t pid;
+        if (posix_spawnp(&pid, executablePath.c_str(), nullptr, nullptr, const_cast<char**>(arguments), environ) != 0) {
+            std::cout << "[ERROR]: Couldn't start a worker process from \"" << executablePath << "\"\n";
+            return false;
+        }
+        spawnedWorkers_.push_back(pid);
+    }
+    return true;
+#else
+    std::cout << "[ERROR]: Starting local workers is not supported on this platform\n";
+    return false;
+#endif
+}
+
+bool RenderCoordinator::render(Film& film, uint32_t samplesPerPixel, uint32_t tileWidth, uint32_t tileHeight) {
+#ifndef _WIN32
+    // Units are ordered by their sample range, so a batch of consecutive units
+    // with the same range can be rendered in parallel by the tile renderer
+    uint32_t samplesPerUnit = samplesPerUnit_ > 0 ? min(samplesPerUnit_, samplesPerPixel) : samplesPerPixel;
+    auto tiles = film.getTiles(tileWidth, tileHeight);
+    for (uint32_t firstSample = 0; firstSample < samplesPerPixel; firstSample += samplesPerUnit) {
+        uint32_t numSamples = min(samplesPerUnit, samplesPerPixel - firstSample);
+        for (const auto& tile : tiles) {
+            pendingUnits_.push_back(static_cast<uint32_t>(units_.size()));
+            units_.push_back({ tile, firstSample, numSamples });
+        }
+    }
+    isUnitDone_.assign(units_.size(), false);
+
+    uint64_t totalWork = film.getCropWindowArea() * samplesPerPixel;
+    ProgressBar progressBar(totalWork, "Rendering");
+    size_t numUnitsDone = 0;
+    auto lastWorkerTime = std::chrono::steady_clock::now();
+    bool hasStarted = false;
+
+    while (numUnitsDone < units_.size()) {
+        std::vector<pollfd> handles = { { listener_.getHandle(), POLLIN, 0 } };
+        for (const auto& connection : connections_) {
+            handles.push_back({ connection.socket.getHandle(), POLLIN, 0 });
+        }
+
+        if (poll(handles.data(), handles.size(), 500) < 0) {
+            continue; // Interrupted by a signal
+        }
+
+        if (handles[0].revents & POLLIN) {
+            Socket socket = listener_.accept();
+            if (socket.isValid()) {
+                connections_.emplace_back();
+                connections_.back().socket = std::move(socket);
+            }
+        }
+
+        // New connections are only polled in the next iteration
+        for (size_t i = 1; i < handles.size(); i++) {
+            if (handles[i].revents == 0) {
+                continue;
+            }
+            if (!processMessage(connections_[i - 1], film, numUnitsDone, progressBar)) {
+                dropConnection(connections_[i - 1]);
+            }
+        }
+
+        size_t numReadyWorkers = std::count_if(connections_.begin(), connections_.end(),
+            [](const Connection& connection) { return connection.isReady; });
+        hasStarted = hasStarted || numReadyWorkers >= minWorkers_;
+        for (auto& connection : connections_) {
+            if (hasStarted && connection.isReady && !sendWork(connection)) {
+                dropConnection(connection);
+            }
+        }
+
+        connections_.erase(std::remove_if(connections_.begin(), connections_.end(),
+            [](const Connection& connection) { return !connection.socket.isValid(); }), connections_.end());
+
+        if (!connections_.empty()) {
+            lastWorkerTime = std::chrono::steady_clock::now();
+        }
+        else if (haveSpawnedWorkersExited()) {
+            std::cout << "[ERROR]: All worker processes exited before the frame was finished\n";
+            return false;
+        }
+        else if (std::chrono::duration<float>(std::chrono::steady_clock::now() - lastWorkerTime).count() > kWorkerTimeoutSeconds) {
+            std::cout << "[ERROR]: No worker connected for " << kWorkerTimeoutSeconds << " seconds\n";
+            return false;
+        }
+    }
+
+    for (auto& connection : connections_) {
+        sendMessage(connection.socket, MessageType::Done);
+    }
+    connections_.clear();
+    listener_.close();
+
+    return true;
+#else
+    (void)film; (void)samplesPerPixel; (void)tileWidth; (void)tileHeight;
+    std::cout << "[ERROR]: Distributed rendering is not supported on this platform\n";
+    return false;
+#endif
+}
+
+bool RenderCoordinator::processMessage(Connection& connection, Film& film, size_t& numUnitsDone, ProgressBar& progressBar) {
+    uint32_t type;
+    std::vector<uint8_t> payload;
+    if (!connection.socket.receiveMessage(type, payload)) {
+        return false;
+    }
+
+    switch (static_cast<MessageType>(type)) {
+    case MessageType::Hello: {
+        auto hello = nlohmann::json::parse(toString(payload), nullptr, false);
+        if (hello.is_discarded()) {
+            return false;
+        }
+        connection.numThreads = max(1u, hello.value("threads", 1u));
+        return sendMessage(connection.socket, MessageType::Job, job_.dump());
+    }
+    case MessageType::Ready:
+        connection.isReady = true;
+        std::cout << "[INFO]: Worker with " << connection.numThreads << " threads connected\n";
+        return true;
+    case MessageType::Error:
+        std::cout << "[ERROR]: Worker failed: " << toString(payload) << "\n";
+        return false;
+    case MessageType::Result: {
+        if (payload.size() < sizeof(uint32_t)) {
+            return false;
+        }
+        uint32_t unitIndex = readUint32(payload, 0);
+        if (connection.assignedUnits.erase(unitIndex) == 0) {
+            return false;
+        }
+
+        const WorkUnit& unit = units_[unitIndex];
+        std::vector<uint8_t> tileData(payload.begin() + sizeof(uint32_t), payload.end());
+        if (isUnitDone_[unitIndex] || !film.addTileData(unit.tile, tileData)) {
+            return false;
+        }
+
+        isUnitDone_[unitIndex] = true;
+        numUnitsDone++;
+        progressBar.update((unit.tile.endX - unit.tile.startX + 1) * (unit.tile.endY - unit.tile.startY + 1) * unit.numSamples);
+        if (tileCallback_) {
+            tileCallback_(film, unit.tile);
+        }
+        return true;
+    }
+    default:
+        return false;
+    }
+}
+
+bool RenderCoordinator::sendWork(Connection& connection) {
+    // Keeps up to two batches per worker in flight, so the next one is already
+    // queued when the current one finishes
+    size_t batchSize = 4 * static_cast<size_t>(connection.numThreads);
+    while (connection.assignedUnits.size() <= batchSize && !pendingUnits_.empty()) {
+        const WorkUnit& firstUnit = units_[pendingUnits_.front()];
+        std::vector<uint8_t> payload;
+        for (size_t i = 0; i < batchSize && !pendingUnits_.empty(); i++) {
+            uint32_t unitIndex = pendingUnits_.front();
+            const WorkUnit& unit = units_[unitIndex];
+            if (unit.firstSample != firstUnit.firstSample || unit.numSamples != firstUnit.numSamples) {
+                break;
+            }
+
+            for (uint32_t value : { unitIndex, unit.tile.startX, unit.tile.startY, unit.tile.endX, unit.tile.endY,
+                    unit.firstSample, unit.numSamples }) {
+                appendUint32(payload, value);
+            }
+            connection.assignedUnits.insert(unitIndex);
+            pendingUnits_.pop_front();
+        }
+
+        if (!sendMessage(connection.socket, MessageType::Work, payload)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void RenderCoordinator::dropConnection(Connection& connection) {
+    if (!connection.assignedUnits.empty()) {
+        std::cout << "[WARNING]: Lost a worker, reassigning " << connection.assignedUnits.size() << " work units\n";
+    }
+
+    // Sorted to keep units with the same sample range next to each other
+    std::vector<uint32_t> units(connection.assignedUnits.begin(), connection.assignedUnits.end());
+    std::sort(units.begin(), units.end());
+    pendingUnits_.insert(pendingUnits_.begin(), units.begin(), units.end());
+
+    connection.assignedUnits.clear();
+    connection.isReady = false;
+    connection.socket.close();
+}
+
+bool RenderCoordinator::haveSpawnedWorkersExited() {
+#ifndef _WIN32
+    if (spawnedWorkers_.empty()) {
+        return false;
+    }
+
+    spawnedWorkers_.erase(std::remove_if(spawnedWorkers_.begin(), spawnedWorkers_.end(),
+        [](int pid) { return waitpid(pid, nullptr, WNOHANG) == pid; }), spawnedWorkers_.end());
+    return spawnedWorkers_.empty();
+#else
+    return false;
+#endif
+}
+
+int RenderWorker::run(const std::string& host, uint16_t port, float connectTimeout) {
+    Socket socket;
+    auto connectStartTime = std::chrono::steady_clock::now();
+    while (!socket.connect(host, port)) {
+        if (std::chrono::duration<float>(std::chrono::steady_clock::now() - connectStartTime).count() > connectTimeout) {
+            std::cout << "[ERROR]: Couldn't connect to the coordinator at " << host << ":" << port << "\n";
+            return 1;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    uint32_t numThreads = numThreads_ > 0 ? numThreads_ : max(1u, std::thread::hardware_concurrency());
+    nlohmann::json hello = { { "threads", numThreads } };
+    uint32_t type;
+    std::vector<uint8_t> payload;
+    if (!sendMessage(socket, MessageType::Hello, hello.dump()) ||
+            !socket.receiveMessage(type, payload) || type != static_cast<uint32_t>(MessageType::Job)) {
+        std::cout << "[ERROR]: The coordinator didn't send a job\n";
+        return 1;
+    }
+
+    auto job = nlohmann::json::parse(toString(payload), nullptr, false);
+    if (job.is_discarded() || !job.contains("scene") || !job.contains("scenePath")) {
+        sendMessage(socket, MessageType::Error, "Invalid job description");
+        return 1;
+    }
+
+    SceneFileParser sceneParser(job["scene"], job["scenePath"].get<std::string>());
+    Film film = sceneParser.parseFilm();
+    Camera camera = sceneParser.parseCamera(film.getWidth() / static_cast<float>(film.getHeight()));
+    auto sampler = sceneParser.parseSampler(job.value("spp", 0u), job.value("seed", int64_t(-1)));
+    Renderer renderer = sceneParser.parseRenderer();
+    renderer.setNumThreads(numThreads);
+    renderer.setTimeLimit(0.0f);
+    renderer.setShowProgress(false);
+
+    std::vector<Sphere> spheres;
+    std::vector<Triangle> triangles;
+    std::vector<Material> materials;
+    sceneParser.parseScene(spheres, triangles, materials);
+
+    Scene scene;
+    for (const auto& shape : spheres) {
+        scene.add(shape);
+    }
+    for (const auto& shape : triangles) {
+        scene.add(shape);
+    }
+    scene.compile();
+
+    if (!sendMessage(socket, MessageType::Ready)) {
+        return 1;
+    }
+
+    // Results are sent from the render threads as soon as a tile is finished
+    std::mutex socketMutex;
+    std::unordered_map<uint64_t, uint32_t> tileUnits; // Tile start -> unit index
+    bool isConnected = true;
+    renderer.setTileCallback([&](const Film& film, const Film::Tile& tile) {
+        std::vector<uint8_t> result;
+        appendUint32(result, tileUnits.at(static_cast<uint64_t>(tile.startY) << 32 | tile.startX));
+        auto tileData = film.getTileData(tile);
+        result.insert(result.end(), tileData.begin(), tileData.end());
+
+        std::lock_guard<std::mutex> lock(socketMutex);
+        isConnected = isConnected && sendMessage(socket, MessageType::Result, result);
+    });
+
+    while (isConnected && socket.receiveMessage(type, payload)) {
+        if (type == static_cast<uint32_t>(MessageType::Done)) {
+            return 0;
+        }
+        if (type != static_cast<uint32_t>(MessageType::Work) || payload.size() % (kWorkUnitSize * sizeof(uint32_t)) != 0) {
+            std::cout << "[ERROR]: Received an invalid message from the coordinator\n";
+            return 1;
+        }
+
+        // All units of a batch share the same sample range
+        size_t numUnits = payload.size() / (kWorkUnitSize * sizeof(uint32_t));
+        std::vector<Film::Tile> tiles;
+        tileUnits.clear();
+        for (size_t i = 0; i < numUnits; i++) {
+            const size_t base = i * kWorkUnitSize;
+            Film::Tile tile = { readUint32(payload, base + 1), readUint32(payload, base + 2),
+                readUint32(payload, base + 3), readUint32(payload, base + 4) };
+            if (tile.endX >= film.getWidth() || tile.endY >= film.getHeight() ||
+                    tile.startX > tile.endX || tile.startY > tile.endY) {
+                std::cout << "[ERROR]: Received an invalid tile from the coordinator\n";
+                return 1;
+            }
+
+            film.clearTile(tile);
+            tiles.push_back(tile);
+            tileUnits[static_cast<uint64_t>(tile.startY) << 32 | tile.startX] = readUint32(payload, base);
+        }
+
+        if (numUnits > 0) {
+            renderer.renderTiles(scene, camera, film, *sampler, tiles, readUint32(payload, 5), readUint32(payload, 6));
+        }
+    }
+
+    std::cout << "[ERROR]: Lost the connection to the coordinator\n";
+    return 1;
+}
+
+} // namespace pt
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "Film.h"
+#include "Renderer.h"
+#include "Network.h"
+
+#include <json.hpp>
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace pt {
+
+// Protocol between the coordinator and its workers. A worker connects and sends
+// Hello with its thread count, receives the Job (scene description, spp and seed)
+// and answers with Ready or Error. After that it receives batches of work units
+// and returns one Result with the partial film data per unit, until Done.
+enum class MessageType : uint32_t {
+    Hello = 1,
+    Job,
+    Ready,
+    Error,
+    Work,
+    Result,
+    Done
+};
+
+// Renders a frame with worker processes on this or other machines. The frame is
+// split into work units of one tile and a range of sample indices, so the merged
+// film is bit-identical to a local render if every unit covers all samples of
+// its tile. Units of a worker that disconnects are handed out again.
+class RenderCoordinator {
+public:
+    // The job is sent to every worker, see RenderWorker for its contents
+    RenderCoordinator(const nlohmann::json& job, uint32_t samplesPerUnit);
+    ~RenderCoordinator();
+
+    bool listen(uint16_t port);
+    uint16_t getPort() const { return listener_.getPort(); }
+
+    // Starts worker processes of the given executable that connect to this coordinator
+    bool spawnLocalWorkers(const std::string& executablePath, uint32_t numWorkers, uint32_t threadsPerWorker);
+
+    // Returns false if no worker was available for too long
+    bool render(Film& film, uint32_t samplesPerPixel, uint32_t tileWidth, uint32_t tileHeight);
+
+    // Holds back the work until this many workers are ready, e.g. to spread the
+    // first units evenly when all workers are started at the same time
+    void setMinWorkers(uint32_t numWorkers) { minWorkers_ = numWorkers; }
+
+    // Called after the result of a unit was added to the film
+    void setTileCallback(const Renderer::TileCallback& callback) { tileCallback_ = callback; }
+
+private:
+    struct WorkUnit {
+        Film::Tile tile;
+        uint32_t firstSample;
+        uint32_t numSamples;
+    };
+
+    struct Connection {
+        Socket socket;
+        uint32_t numThreads = 1;
+        bool isReady = false;
+        std::unordered_set<uint32_t> assignedUnits;
+    };
+
+    bool processMessage(Connection& connection, Film& film, size_t& numUnitsDone, ProgressBar& progressBar);
+    bool sendWork(Connection& connection);
+    void dropConnection(Connection& connection);
+    bool haveSpawnedWorkersExited();
+
+    nlohmann::json job_;
+    uint32_t samplesPerUnit_;
+    uint32_t minWorkers_ = 1;
+    Socket listener_;
+    std::vector<Connection> connections_;
+    std::vector<WorkUnit> units_;
+    std::vector<bool> isUnitDone_;
+    std::deque<uint32_t> pendingUnits_;
+    std::vector<int> spawnedWorkers_; // Process ids
+    Renderer::TileCallback tileCallback_;
+};
+
+// Worker process side of the protocol. The job is a JSON object with the parsed
+// scene file ("scene"), the path of the scene file to resolve relative paths
+// ("scenePath"), the samples per pixel ("spp") and the sampler seed ("seed").
+class RenderWorker {
+public:
+    explicit RenderWorker(uint32_t numThreads) : numThreads_(numThreads) {}
+
+    // Tries to connect for the given time, so workers can start before the coordinator
+    int run(const std::string& host, uint16_t port, float connectTimeout);
+
+private:
+    uint32_t numThreads_;
+};
+
+} // namespace pt
@@ -1,34 +1,183 @@
 #include "Film.h"
 #include "ColorUtils.h"
 #include "MathUtils.h"
+#include "ParallelFor.h"
+#include "PngWriter.h"
 
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include <stb_image_write.h>
 
 #include <algorithm>
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
 #include <cctype>
+#include <cstring>
 #include <cassert>
 
+namespace {
+
+struct RawFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+};
+
+constexpr char rawFileMagic[4] = { 'P', 'T', 'R', 'F' };
+constexpr uint32_t rawFileVersion = 1;
+constexpr uint64_t rawPixelSize = 20;
+
+std::string getExtension(const std::string& path) {
+    size_t dot = path.rfind('.');
+    std::string ext = dot == std::string::npos ? std::string() : path.substr(dot);
+    std::transform(ext.begin(), ext.end(), ext.begin(),
+        [](unsigned char c) { return std::tolower(c); });
+    return ext;
+}
+
+// Piecewise linear approximation of linearToSRGB() with 256 segments per octave
+// between 2^-9 and 2^16, indexed by the bits of the float. The relative error is
+// below 1e-6, far less than the 8 bit output can show, and it avoids the pow().
+class LinearToSRGBTable {
+public:
+    LinearToSRGBTable() {
+        for (uint32_t i = 0; i < values_.size(); i++) {
+            values_[i] = pt::linearToSRGB(fromBits(minBits + (i << segmentShift)));
+        }
+    }
+
+    float operator()(float x) const {
+        uint32_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+        if (bits < minBits || bits >= maxBits) {
+            return pt::linearToSRGB(x); // Also handles negative values and NaNs
+        }
+
+        uint32_t offset = bits - minBits;
+        uint32_t index = offset >> segmentShift;
+        float t = static_cast<float>(offset & segmentMask) * (1.0f / (segmentMask + 1));
+        return values_[index] + t * (values_[index + 1] - values_[index]);
+    }
+
+private:
+    static float fromBits(uint32_t bits) {
+        float x;
+        std::memcpy(&x, &bits, sizeof(x));
+        return x;
+    }
+
+    static constexpr uint32_t minBits = (127u - 9u) << 23; // 2^-9
+    static constexpr uint32_t maxBits = (127u + 16u) << 23; // 2^16
+    static constexpr uint32_t segmentShift = 23 - 8;
+    static constexpr uint32_t segmentMask = (1u << segmentShift) - 1;
+    std::array<float, ((maxBits - minBits) >> segmentShift) + 1> values_;
+};
+
+// Also checks that the pixels of the header fit the file, so a corrupt or
+// truncated file is rejected before the pixels are allocated
+bool readRawFileHeader(std::ifstream& file, RawFileHeader& header) {
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || std::memcmp(header.magic, rawFileMagic, sizeof(rawFileMagic)) != 0
+            || header.version != rawFileVersion) {
+        return false;
+    }
+
+    std::streampos pixelStart = file.tellg();
+    file.seekg(0, std::ios::end);
+    uint64_t pixelDataSize = static_cast<uint64_t>(file.tellg() - pixelStart);
+    file.seekg(pixelStart);
+    return file && pixelDataSize == static_cast<uint64_t>(header.width) * header.height * rawPixelSize;
+}
+
+} // namespace
+
 namespace pt {
 
 Film::Film(uint32_t width, uint32_t height)
+    : Film(width, height, { 0, 0, max(width, 1u) - 1, max(height, 1u) - 1 })
+{
+}
+
+Film::Film(uint32_t width, uint32_t height, const Tile& storageWindow)
     : width_(width)
     , height_(height)
-    , pixels_(width * height, { 0u, Vec3(0.0f) })
+    , storageWindow_(storageWindow)
+    , storageWidth_(storageWindow.endX - storageWindow.startX + 1)
+    , cropWindow_({ 0, 0, max(width, 1u) - 1, max(height, 1u) - 1 })
 {
+    size_t numStoredPixels = width > 0 && height > 0
+        ? static_cast<size_t>(storageWidth_) * (storageWindow.endY - storageWindow.startY + 1) : 0;
+    pixels_.resize(numStoredPixels, { 0u, Vec3(0.0f), 0.0f });
 }
 
 void Film::addSample(uint32_t x, uint32_t y, const Vec3& color) {
     assert(x < width_);
     assert(y < height_);
-    auto& pixel = pixels_[x + y * width_];
+    auto& pixel = pixels_[getPixelIndex(x, y)];
+    float lum = luminance(color);
     pixel.accumColor += color;
+    pixel.accumLuminanceSq += lum * lum;
     pixel.numSamples++;
 }
 
+uint32_t Film::getNumSamples(uint32_t x, uint32_t y) const {
+    assert(x < width_);
+    assert(y < height_);
+    return pixels_[getPixelIndex(x, y)].numSamples;
+}
+
+uint64_t Film::getTotalSamples() const {
+    uint64_t totalSamples = 0;
+    for (const auto& pixel : pixels_) {
+        totalSamples += pixel.numSamples;
+    }
+    return totalSamples;
+}
+
+float Film::getRelativeError(uint32_t x, uint32_t y) const {
+    assert(x < width_);
+    assert(y < height_);
+    const auto& pixel = pixels_[getPixelIndex(x, y)];
+    if (pixel.numSamples < 2) {
+        return std::numeric_limits<float>::max();
+    }
+
+    float n = static_cast<float>(pixel.numSamples);
+    float mean = luminance(pixel.accumColor) / n;
+    float variance = max(0.0f, (pixel.accumLuminanceSq - mean * mean * n) / (n - 1.0f));
+    float standardError = std::sqrt(variance / n);
+
+    // The small bias keeps almost black pixels from dominating the error
+    return standardError / (mean + 0.01f);
+}
+
+void Film::setCropWindow(const Tile& window, bool fullSizeOutput) {
+    cropWindow_.startX = min(window.startX, max(width_, 1u) - 1);
+    cropWindow_.startY = min(window.startY, max(height_, 1u) - 1);
+    cropWindow_.endX = clamp(window.endX, cropWindow_.startX, max(width_, 1u) - 1);
+    cropWindow_.endY = clamp(window.endY, cropWindow_.startY, max(height_, 1u) - 1);
+    fullSizeOutput_ = fullSizeOutput;
+}
+
+uint64_t Film::getCropWindowArea() const {
+    if (width_ == 0 || height_ == 0) {
+        return 0;
+    }
+    return static_cast<uint64_t>(cropWindow_.endX - cropWindow_.startX + 1) * (cropWindow_.endY - cropWindow_.startY + 1);
+}
+
 std::vector<Film::Tile> Film::getTiles(uint32_t tileWidth, uint32_t tileHeight) const {
-    const uint32_t numTilesX = (width_ + tileWidth - 1) / tileWidth;
-    const uint32_t numTilesY = (height_ + tileHeight - 1) / tileHeight;
+    if (width_ == 0 || height_ == 0) {
+        return {};
+    }
+
+    const uint32_t windowWidth = cropWindow_.endX - cropWindow_.startX + 1;
+    const uint32_t windowHeight = cropWindow_.endY - cropWindow_.startY + 1;
+    const uint32_t numTilesX = (windowWidth + tileWidth - 1) / tileWidth;
+    const uint32_t numTilesY = (windowHeight + tileHeight - 1) / tileHeight;
 
     std::vector<Tile> tiles;
     tiles.reserve(numTilesX * numTilesY);
@@ -36,10 +185,10 @@ std::vector<Film::Tile> Film::getTiles(uint32_t tileWidth, uint32_t tileHeight)
     for (uint32_t tileY = 0; tileY < numTilesY; tileY++) {
         for (uint32_t tileX = 0; tileX < numTilesX; tileX++) {
             Tile tile;
-            tile.startX = tileWidth * tileX;
-            tile.startY = tileHeight * tileY;
-            tile.endX = min(tileWidth * (tileX + 1) - 1, width_ - 1);
-            tile.endY = min(tileHeight * (tileY + 1) - 1, height_ - 1);
+            tile.startX = cropWindow_.startX + tileWidth * tileX;
+            tile.startY = cropWindow_.startY + tileHeight * tileY;
+            tile.endX = min(tile.startX + tileWidth - 1, cropWindow_.endX);
+            tile.endY = min(tile.startY + tileHeight - 1, cropWindow_.endY);
             tiles.push_back(tile);
         }
     }
@@ -48,47 +197,357 @@ std::vector<Film::Tile> Film::getTiles(uint32_t tileWidth, uint32_t tileHeight)
 }
 
 std::vector<uint8_t> Film::getImageBuffer(bool tonemap) const {
-    std::vector<uint8_t> imageBuffer;
-    imageBuffer.reserve(width_ * height_ * 3);
+    constexpr uint32_t rowsPerBlock = 16;
 
-    for (const auto& pixel : pixels_) {
+    const size_t imageWidth = getImageWidth();
+    std::vector<uint8_t> imageBuffer(imageWidth * getImageHeight() * 3);
+    if (width_ == 0 || height_ == 0) {
+        return imageBuffer;
+    }
+
+    Tile window = getOutputWindow();
+    size_t numBlocks = (window.endY - window.startY + rowsPerBlock) / rowsPerBlock;
+    parallelFor(numBlocks, [&](size_t blockIndex) {
+        uint32_t startY = window.startY + static_cast<uint32_t>(blockIndex) * rowsPerBlock;
+        uint32_t endY = min(startY + rowsPerBlock - 1, window.endY);
+        for (uint32_t y = startY; y <= endY; y++) {
+            getImageRow(y, window.startX, window.endX, tonemap, &imageBuffer[(y - window.startY) * imageWidth * 3]);
+        }
+    });
+
+    return imageBuffer;
+}
+
+void Film::getImageRow(uint32_t y, uint32_t startX, uint32_t endX, bool tonemap, uint8_t* rgb) const {
+    static const LinearToSRGBTable linearToSRGBTable;
+    for (uint32_t x = startX; x <= endX; x++) {
+        const auto& pixel = pixels_[getPixelIndex(x, y)];
         Vec3 color = pixel.accumColor / static_cast<float>(max(1u, pixel.numSamples));
-        color = linearToSRGB(color);
+        color = Vec3(linearToSRGBTable(color.r), linearToSRGBTable(color.g), linearToSRGBTable(color.b));
         color = tonemap ? tonemapACES(color) : saturate(color);
-        imageBuffer.push_back(static_cast<uint8_t>(color.r * 255.0 + 0.5));
-        imageBuffer.push_back(static_cast<uint8_t>(color.g * 255.0 + 0.5));
-        imageBuffer.push_back(static_cast<uint8_t>(color.b * 255.0 + 0.5));
+        *rgb++ = static_cast<uint8_t>(color.r * 255.0f + 0.5f);
+        *rgb++ = static_cast<uint8_t>(color.g * 255.0f + 0.5f);
+        *rgb++ = static_cast<uint8_t>(color.b * 255.0f + 0.5f);
     }
+}
 
-    return imageBuffer;
+void Film::getRadianceRow(uint32_t y, uint32_t startX, uint32_t endX, float* rgb) const {
+    for (uint32_t x = startX; x <= endX; x++) {
+        const auto& pixel = pixels_[getPixelIndex(x, y)];
+        Vec3 color = pixel.accumColor / static_cast<float>(max(1u, pixel.numSamples));
+        *rgb++ = color.r;
+        *rgb++ = color.g;
+        *rgb++ = color.b;
+    }
 }
 
-bool Film::saveToFile(std::string path) const {
-    auto image = getImageBuffer();
+uint32_t Film::getImageWidth() const {
+    Tile window = getOutputWindow();
+    return width_ > 0 ? window.endX - window.startX + 1 : 0;
+}
 
-    auto ext = path.substr(path.rfind('.'));
-    std::transform(ext.begin(), ext.end(), ext.begin(),
-        [](unsigned char c) { return std::tolower(c); });
+uint32_t Film::getImageHeight() const {
+    Tile window = getOutputWindow();
+    return height_ > 0 ? window.endY - window.startY + 1 : 0;
+}
+
+bool Film::isStoringAllPixels() const {
+    return storageWindow_.startX == 0 && storageWindow_.startY == 0 &&
+        storageWindow_.endX + 1 >= width_ && storageWindow_.endY + 1 >= height_;
+}
+
+Film::Tile Film::getOutputWindow() const {
+    return fullSizeOutput_ ? Tile{ 0, 0, max(width_, 1u) - 1, max(height_, 1u) - 1 } : cropWindow_;
+}
 
+bool Film::saveToFile(std::string path) const {
+    auto ext = getExtension(path);
+    if (ext == ".ptraw") {
+        return saveRaw(path);
+    }
+    else if (ext == ".exr") {
+        return saveExr(path);
+    }
+    else if (ext == ".pfm") {
+        return writePfm(path, getImageWidth(), getImageHeight(),
+            [this](uint32_t y, float* rgb) { readImageRow(y, rgb); });
+    }
+
+    auto image = getImageBuffer();
+    int width = static_cast<int>(getImageWidth());
+    int height = static_cast<int>(getImageHeight());
     int bytesWritten = 0;
     if (ext == ".png") {
-        bytesWritten = stbi_write_png(path.data(), static_cast<int>(width_),
-            static_cast<int>(height_), 3, image.data(), width_ * sizeof(uint8_t) * 3);
+        return writePng(path, static_cast<uint32_t>(width), static_cast<uint32_t>(height), image);
     }
     else if (ext == ".jpg" || ext == ".jpeg") {
-        bytesWritten = stbi_write_jpg(path.data(), static_cast<int>(width_),
-            static_cast<int>(height_), 3, image.data(), 90);
+        bytesWritten = stbi_write_jpg(path.data(), width, height, 3, image.data(), 90);
     }
     else if (ext == ".bmp") {
-        bytesWritten = stbi_write_bmp(path.data(), static_cast<int>(width_),
-            static_cast<int>(height_), 3, image.data());
+        bytesWritten = stbi_write_bmp(path.data(), width, height, 3, image.data());
     }
     else if (ext == ".tga") {
-        bytesWritten = stbi_write_tga(path.data(), static_cast<int>(width_),
-            static_cast<int>(height_), 3, image.data());
+        bytesWritten = stbi_write_tga(path.data(), width, height, 3, image.data());
     }
 
     return bytesWritten > 0;
 }
 
+void Film::readImageRow(uint32_t y, float* rgb) const {
+    Tile window = getOutputWindow();
+    getRadianceRow(window.startY + y, window.startX, window.endX, rgb);
+}
+
+bool Film::saveExr(const std::string& path, ExrPixelType pixelType, ExrCompression compression) const {
+    ExrOptions options;
+    options.pixelType = pixelType;
+    options.compression = compression;
+    if (!fullSizeOutput_) {
+        options.offsetX = cropWindow_.startX;
+        options.offsetY = cropWindow_.startY;
+        options.displayWidth = width_;
+        options.displayHeight = height_;
+    }
+
+    return writeExr(path, getImageWidth(), getImageHeight(),
+        [this](uint32_t y, float* rgb) { readImageRow(y, rgb); }, options);
+}
+
+void Film::copyTile(const Film& other, const Tile& tile) {
+    assert(other.width_ == width_ && other.height_ == height_);
+    assert(tile.endX < width_ && tile.endY < height_);
+
+    size_t tileWidth = tile.endX - tile.startX + 1;
+    for (uint32_t y = tile.startY; y <= tile.endY; y++) {
+        std::memcpy(&pixels_[getPixelIndex(tile.startX, y)],
+            &other.pixels_[other.getPixelIndex(tile.startX, y)], tileWidth * sizeof(Pixel));
+    }
+}
+
+void Film::clearTile(const Tile& tile) {
+    assert(tile.endX < width_ && tile.endY < height_);
+    for (uint32_t y = tile.startY; y <= tile.endY; y++) {
+        for (uint32_t x = tile.startX; x <= tile.endX; x++) {
+            pixels_[getPixelIndex(x, y)] = { 0u, Vec3(0.0f), 0.0f };
+        }
+    }
+}
+
+std::vector<uint8_t> Film::getTileData(const Tile& tile) const {
+    assert(tile.endX < width_ && tile.endY < height_);
+    size_t tileWidth = tile.endX - tile.startX + 1;
+    size_t rowSize = tileWidth * sizeof(Pixel);
+    std::vector<uint8_t> data((tile.endY - tile.startY + 1) * rowSize);
+
+    for (uint32_t y = tile.startY; y <= tile.endY; y++) {
+        std::memcpy(&data[(y - tile.startY) * rowSize], &pixels_[getPixelIndex(tile.startX, y)], rowSize);
+    }
+
+    return data;
+}
+
+bool Film::addTileData(const Tile& tile, const std::vector<uint8_t>& data) {
+    if (tile.endX >= width_ || tile.endY >= height_ || tile.startX > tile.endX || tile.startY > tile.endY) {
+        return false;
+    }
+
+    size_t tileWidth = tile.endX - tile.startX + 1;
+    if (data.size() != (tile.endY - tile.startY + 1) * tileWidth * sizeof(Pixel)) {
+        return false;
+    }
+
+    const uint8_t* source = data.data();
+    for (uint32_t y = tile.startY; y <= tile.endY; y++) {
+        for (uint32_t x = tile.startX; x <= tile.endX; x++) {
+            Pixel other;
+            std::memcpy(&other, source, sizeof(Pixel));
+            source += sizeof(Pixel);
+
+            auto& pixel = pixels_[getPixelIndex(x, y)];
+            pixel.numSamples += other.numSamples;
+            pixel.accumColor += other.accumColor;
+            pixel.accumLuminanceSq += other.accumLuminanceSq;
+        }
+    }
+
+    return true;
+}
+
+bool Film::saveRaw(const std::string& path) const {
+    static_assert(sizeof(Pixel) == rawPixelSize, "The raw file format expects tightly packed pixels");
+
+    if (!isStoringAllPixels()) {
+        return false;
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    RawFileHeader header;
+    std::memcpy(header.magic, rawFileMagic, sizeof(rawFileMagic));
+    header.version = rawFileVersion;
+    header.width = width_;
+    header.height = height_;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(pixels_.data()), pixels_.size() * sizeof(Pixel));
+
+    return file.good();
+}
+
+bool Film::loadRaw(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    RawFileHeader header;
+    if (!readRawFileHeader(file, header)) {
+        return false;
+    }
+
+    std::vector<Pixel> pixels(static_cast<size_t>(header.width) * header.height);
+    file.read(reinterpret_cast<char*>(pixels.data()), pixels.size() * sizeof(Pixel));
+    if (!file) {
+        return false;
+    }
+
+    width_ = header.width;
+    height_ = header.height;
+    pixels_ = std::move(pixels);
+    storageWindow_ = { 0, 0, max(width_, 1u) - 1, max(height_, 1u) - 1 };
+    storageWidth_ = max(width_, 1u);
+    cropWindow_ = storageWindow_;
+    fullSizeOutput_ = false;
+    return true;
+}
+
+bool Film::mergeRawFiles(const std::vector<std::string>& inputPaths, const std::string& outputPath) {
+    if (inputPaths.empty()) {
+        return false;
+    }
+
+    // The output is truncated before the inputs are read
+    for (const auto& path : inputPaths) {
+        std::error_code error;
+        if (std::filesystem::equivalent(path, outputPath, error)) {
+            std::cout << "[ERROR]: The output \"" << outputPath << "\" is also an input\n";
+            return false;
+        }
+    }
+
+    std::vector<std::ifstream> inputs;
+    RawFileHeader header = {};
+    for (const auto& path : inputPaths) {
+        inputs.emplace_back(path, std::ios::binary);
+        RawFileHeader inputHeader;
+        if (!inputs.back().is_open() || !readRawFileHeader(inputs.back(), inputHeader)) {
+            std::cout << "[ERROR]: \"" << path << "\" is not a valid raw film file\n";
+            return false;
+        }
+        if (inputs.size() > 1 && (inputHeader.width != header.width || inputHeader.height != header.height)) {
+            std::cout << "[ERROR]: The size of \"" << path << "\" doesn't match the size of \"" << inputPaths[0] << "\"\n";
+            return false;
+        }
+        header = inputHeader;
+    }
+
+    // A raw output is written row by row, other formats need the whole film
+    bool isRawOutput = getExtension(outputPath) == ".ptraw";
+    Film film(isRawOutput ? 0 : header.width, isRawOutput ? 0 : header.height);
+    std::ofstream output;
+    if (isRawOutput) {
+        output.open(outputPath, std::ios::binary);
+        if (!output.is_open()) {
+            return false;
+        }
+        output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+
+    // Sums in double precision, so merging many films adds no noticeable rounding error
+    struct PixelSum {
+        uint64_t numSamples;
+        double accumColor[3];
+        double accumLuminanceSq;
+    };
+    std::vector<Pixel> row(header.width);
+    std::vector<PixelSum> rowSums(header.width);
+
+    for (uint32_t y = 0; y < header.height; y++) {
+        std::fill(rowSums.begin(), rowSums.end(), PixelSum{});
+        for (size_t i = 0; i < inputs.size(); i++) {
+            inputs[i].read(reinterpret_cast<char*>(row.data()), row.size() * sizeof(Pixel));
+            if (!inputs[i]) {
+                std::cout << "[ERROR]: \"" << inputPaths[i] << "\" is truncated\n";
+                return false;
+            }
+
+            for (uint32_t x = 0; x < header.width; x++) {
+                rowSums[x].numSamples += row[x].numSamples;
+                rowSums[x].accumColor[0] += row[x].accumColor.r;
+                rowSums[x].accumColor[1] += row[x].accumColor.g;
+                rowSums[x].accumColor[2] += row[x].accumColor.b;
+                rowSums[x].accumLuminanceSq += row[x].accumLuminanceSq;
+            }
+        }
+
+        for (uint32_t x = 0; x < header.width; x++) {
+            if (rowSums[x].numSamples > std::numeric_limits<uint32_t>::max()) {
+                std::cout << "[ERROR]: Too many samples in pixel (" << x << ", " << y << ")\n";
+                return false;
+            }
+            row[x].numSamples = static_cast<uint32_t>(rowSums[x].numSamples);
+            row[x].accumColor = Vec3(static_cast<float>(rowSums[x].accumColor[0]),
+                static_cast<float>(rowSums[x].accumColor[1]), static_cast<float>(rowSums[x].accumColor[2]));
+            row[x].accumLuminanceSq = static_cast<float>(rowSums[x].accumLuminanceSq);
+        }
+
+        if (isRawOutput) {
+            output.write(reinterpret_cast<const char*>(row.data()), row.size() * sizeof(Pixel));
+        }
+        else {
+            std::copy(row.begin(), row.end(), film.pixels_.begin() + static_cast<size_t>(y) * header.width);
+        }
+    }
+
+    return isRawOutput ? output.good() : film.saveToFile(outputPath);
+}
+
+RawFilmTileWriter::RawFilmTileWriter(const std::string& path, uint32_t width, uint32_t height)
+    : width_(width)
+    , height_(height)
+    , file_(path, std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc)
+{
+    RawFileHeader header;
+    std::memcpy(header.magic, rawFileMagic, sizeof(rawFileMagic));
+    header.version = rawFileVersion;
+    header.width = width;
+    header.height = height;
+    file_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // Extends the file to its full size without writing the pixels, most file
+    // systems keep the unwritten (empty) pixels as holes
+    uint64_t fileSize = sizeof(RawFileHeader) + static_cast<uint64_t>(width) * height * sizeof(Pixel);
+    if (fileSize > sizeof(RawFileHeader)) {
+        file_.seekp(static_cast<std::streamoff>(fileSize - 1));
+        file_.put('\0');
+    }
+}
+
+bool RawFilmTileWriter::writeTile(const Film& film, const Film::Tile& tile) {
+    assert(film.getWidth() == width_ && film.getHeight() == height_);
+    auto tileData = film.getTileData(tile);
+    size_t rowSize = (tile.endX - tile.startX + 1) * sizeof(Pixel);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (uint32_t y = tile.startY; y <= tile.endY; y++) {
+        uint64_t offset = sizeof(RawFileHeader) + (tile.startX + static_cast<uint64_t>(y) * width_) * sizeof(Pixel);
+        file_.seekp(static_cast<std::streamoff>(offset));
+        file_.write(reinterpret_cast<const char*>(&tileData[(y - tile.startY) * rowSize]), rowSize);
+    }
+
+    return file_.good();
+}
+
 } // namespace pt
@@ -1,9 +1,12 @@
 #pragma once
 
 #include "Vector3.h"
+#include "HdrImageWriter.h"
 
 #include <vector>
 #include <string>
+#include <fstream>
+#include <mutex>
 #include <cstdint>
 #include <cassert>
 
@@ -18,23 +21,116 @@ public:
 
     Film(uint32_t width, uint32_t height);
 
+    // Film that only stores the pixels inside the storage window, e.g. a single
+    // tile of an out-of-core render. Pixels outside the window must not be accessed.
+    Film(uint32_t width, uint32_t height, const Tile& storageWindow);
+
     void addSample(uint32_t x, uint32_t y, const Vec3& color);
+    uint32_t getNumSamples(uint32_t x, uint32_t y) const;
+    uint64_t getTotalSamples() const;
+
+    // Standard error of the pixel's mean luminance relative to the mean itself.
+    // Returns the largest float value if the pixel has less than two samples.
+    float getRelativeError(uint32_t x, uint32_t y) const;
+
+    // Rendering is restricted to the crop window (the whole film by default). Image
+    // outputs only contain the window unless a full size output is requested, the
+    // raw outputs always cover the whole film so region renders can be merged.
+    void setCropWindow(const Tile& window, bool fullSizeOutput = false);
+    const Tile& getCropWindow() const { return cropWindow_; }
+    uint64_t getCropWindowArea() const;
+
+    // Tiles covering the crop window
     std::vector<Tile> getTiles(uint32_t tileWidth, uint32_t tileHeight) const;
+
+    // 8-bit RGB image of the output region, see setCropWindow()
     std::vector<uint8_t> getImageBuffer(bool tonemap = true) const;
+    uint32_t getImageWidth() const;
+    uint32_t getImageHeight() const;
+
+    // Pixels [startX, endX] of a row as 8-bit RGB like getImageBuffer() or as
+    // linear float RGB, e.g. to update a preview of a tile
+    void getImageRow(uint32_t y, uint32_t startX, uint32_t endX, bool tonemap, uint8_t* rgb) const;
+    void getRadianceRow(uint32_t y, uint32_t startX, uint32_t endX, float* rgb) const;
+
+    // 8-bit images are tonemapped. The .exr (half float) and .pfm (float) extensions
+    // write the linear radiance and .ptraw the raw accumulation buffer.
     bool saveToFile(std::string path) const;
 
+    // Linear radiance of the output region, streamed from the accumulation buffer
+    // one row at a time. A crop window becomes the data window of the EXR file.
+    bool saveExr(const std::string& path, ExrPixelType pixelType = ExrPixelType::Half,
+        ExrCompression compression = ExrCompression::Rle) const;
+
+    // Copies the accumulated samples of the tile from another film of the same size
+    void copyTile(const Film& other, const Tile& tile);
+    void clearTile(const Tile& tile);
+
+    // Packed pixel data of a tile in the raw file layout, e.g. to send it to
+    // another process. Adding the data sums up the samples of both films.
+    std::vector<uint8_t> getTileData(const Tile& tile) const;
+    bool addTileData(const Tile& tile, const std::vector<uint8_t>& data);
+
+    // Raw accumulation buffer with the per-pixel float sums and sample counts.
+    // Loading replaces the size and contents of the film. Saving requires a film
+    // that stores all pixels.
+    bool saveRaw(const std::string& path) const;
+    bool loadRaw(const std::string& path);
+
+    // Sums the samples of raw film files of the same size, e.g. renders of
+    // different sample ranges. The inputs are streamed row by row, so only the
+    // output is held in memory, and not even that if it's a raw file too.
+    static bool mergeRawFiles(const std::vector<std::string>& inputPaths, const std::string& outputPath);
+
     uint32_t getWidth() const { return width_; }
     uint32_t getHeight() const { return height_; }
 
 private:
+    friend class RawFilmTileWriter;
+
     struct Pixel {
         uint32_t numSamples;
         Vec3 accumColor;
+        float accumLuminanceSq; // Second moment for the variance estimate
     };
 
+    Tile getOutputWindow() const;
+    void readImageRow(uint32_t y, float* rgb) const;
+    bool isStoringAllPixels() const;
+
+    size_t getPixelIndex(uint32_t x, uint32_t y) const {
+        assert(x >= storageWindow_.startX && x <= storageWindow_.endX);
+        assert(y >= storageWindow_.startY && y <= storageWindow_.endY);
+        return (x - storageWindow_.startX) + static_cast<size_t>(y - storageWindow_.startY) * storageWidth_;
+    }
+
     uint32_t width_;
     uint32_t height_;
     std::vector<Pixel> pixels_;
+    Tile storageWindow_;
+    uint32_t storageWidth_;
+    Tile cropWindow_;
+    bool fullSizeOutput_ = false;
+};
+
+// Writes the tiles of an out-of-core render into a raw film file as they are
+// finished, so the film only has to store the tiles that are being rendered.
+class RawFilmTileWriter {
+public:
+    RawFilmTileWriter(const std::string& path, uint32_t width, uint32_t height);
+
+    bool isValid() const { return file_.good(); }
+
+    // Can be called from multiple threads
+    bool writeTile(const Film& film, const Film::Tile& tile);
+
+private:
+    using Pixel = Film::Pixel;
+
+    uint32_t width_;
+    uint32_t height_;
+    std::fstream file_;
+    std::mutex mutex_;
 };
 
 } // namespace pt
@@ -0,0 +1,266 @@
+#include "GuidingField.h"
+#include "MathUtils.h"
+#include "Vector2.h"
+
+#include <cmath>
+
+namespace {
+
+using namespace pt;
+
+// Regions are split once they get more records than this times the square root
+// of the samples per pixel of the pass (the passes double in size)
+constexpr float spatialSplitRecords = 12000.0f;
+
+// Quadrants with more than this fraction of the energy of a quadtree get a child
+constexpr float directionalSplitFraction = 0.01f;
+constexpr uint32_t maxDirectionalDepth = 20;
+
+// Energies are recorded as fixed point integers with this scale, records are
+// clamped so millions of them can't overflow the sums
+constexpr float recordScale = 65536.0f;
+constexpr float maxRecordedEnergy = 1e6f;
+
+Vec3 squareToDirection(const Vec2& u) {
+    float cosTheta = 2.0f * u.x - 1.0f;
+    float sinTheta = std::sqrt(max(1.0f - cosTheta * cosTheta, 0.0f));
+    float phi = 2.0f * pi<float> * u.y;
+    return Vec3(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+}
+
+Vec2 directionToSquare(const Vec3& direction) {
+    float phi = std::atan2(direction.y, direction.x);
+    if (phi < 0.0f) {
+        phi += 2.0f * pi<float>;
+    }
+    return Vec2(clamp((direction.z + 1.0f) * 0.5f, 0.0f, oneMinusEpsilon<float>),
+        clamp(phi / (2.0f * pi<float>), 0.0f, oneMinusEpsilon<float>));
+}
+
+// The quadrant of the point, which is then mapped to the square of the quadrant
+uint32_t enterQuadrant(Vec2& u) {
+    uint32_t x = u.x >= 0.5f ? 1 : 0;
+    uint32_t y = u.y >= 0.5f ? 1 : 0;
+    u = Vec2(2.0f * u.x - x, 2.0f * u.y - y);
+    return x + 2 * y;
+}
+
+// Picks the lower half with the given probability and remaps u to [0, 1)
+uint32_t pickHalf(float& u, float lowerProb) {
+    if (u < lowerProb) {
+        u = min(u / lowerProb, oneMinusEpsilon<float>);
+        return 0;
+    }
+    u = min((u - lowerProb) / (1.0f - lowerProb), oneMinusEpsilon<float>);
+    return 1;
+}
+
+} // namespace
+
+namespace pt {
+
+DirectionalQuadtree::DirectionalQuadtree()
+    : nodes_(1, { { 0.0f, 0.0f, 0.0f, 0.0f }, { 0, 0, 0, 0 } })
+{
+}
+
+float DirectionalQuadtree::getTotalEnergy() const {
+    const auto& energies = nodes_[0].energies;
+    return energies[0] + energies[1] + energies[2] + energies[3];
+}
+
+Vec3 DirectionalQuadtree::sample(float u1, float u2, float& pdf) const {
+    // Picks the x half and then the y half of every node, so the samples keep
+    // their stratification in both dimensions
+    Vec2 origin(0.0f, 0.0f);
+    float size = 1.0f;
+    pdf = 1.0f / (4.0f * pi<float>);
+    uint32_t nodeIndex = 0;
+    while (true) {
+        const auto& energies = nodes_[nodeIndex].energies;
+        float total = energies[0] + energies[1] + energies[2] + energies[3];
+        uint32_t x = pickHalf(u1, (energies[0] + energies[2]) / total);
+        uint32_t y = pickHalf(u2, energies[x] / (energies[x] + energies[x + 2]));
+        uint32_t quadrant = x + 2 * y;
+        pdf *= 4.0f * energies[quadrant] / total;
+
+        size *= 0.5f;
+        origin += Vec2(static_cast<float>(x), static_cast<float>(y)) * size;
+        nodeIndex = nodes_[nodeIndex].children[quadrant];
+        if (nodeIndex == 0) {
+            break;
+        }
+    }
+    return squareToDirection(origin + Vec2(u1, u2) * size);
+}
+
+float DirectionalQuadtree::pdf(const Vec3& direction) const {
+    Vec2 u = directionToSquare(direction);
+    float pdf = 1.0f / (4.0f * pi<float>);
+    uint32_t nodeIndex = 0;
+    while (true) {
+        const auto& energies = nodes_[nodeIndex].energies;
+        float total = energies[0] + energies[1] + energies[2] + energies[3];
+        if (total <= 0.0f) {
+            return 0.0f;
+        }
+        uint32_t quadrant = enterQuadrant(u);
+        pdf *= 4.0f * energies[quadrant] / total;
+
+        nodeIndex = nodes_[nodeIndex].children[quadrant];
+        if (nodeIndex == 0) {
+            return pdf;
+        }
+    }
+}
+
+DirectionalQuadtree DirectionalQuadtree::refine(float splitFraction, uint32_t maxDepth) const {
+    DirectionalQuadtree tree;
+    tree.nodes_[0].energies = nodes_[0].energies;
+    float splitEnergy = splitFraction * getTotalEnergy();
+    if (splitEnergy <= 0.0f) {
+        return tree;
+    }
+
+    // The node of this tree that covers a new node, 0 if the new node is below a leaf
+    struct StackEntry {
+        uint32_t nodeIndex;
+        uint32_t sourceIndex;
+        uint32_t depth;
+    };
+    std::vector<StackEntry> stack = { { 0, 0, 1 } };
+    while (!stack.empty()) {
+        StackEntry entry = stack.back();
+        stack.pop_back();
+        if (entry.depth >= maxDepth) {
+            continue;
+        }
+
+        for (uint32_t quadrant = 0; quadrant < 4; quadrant++) {
+            float energy = tree.nodes_[entry.nodeIndex].energies[quadrant];
+            if (energy <= splitEnergy) {
+                continue;
+            }
+
+            Node child = { { 0.25f * energy, 0.25f * energy, 0.25f * energy, 0.25f * energy }, { 0, 0, 0, 0 } };
+            uint32_t sourceIndex = 0;
+            if (entry.nodeIndex == 0 || entry.sourceIndex != 0) {
+                sourceIndex = nodes_[entry.sourceIndex].children[quadrant];
+                if (sourceIndex != 0) {
+                    child.energies = nodes_[sourceIndex].energies;
+                }
+            }
+
+            uint32_t childIndex = static_cast<uint32_t>(tree.nodes_.size());
+            tree.nodes_.push_back(child);
+            tree.nodes_[entry.nodeIndex].children[quadrant] = childIndex;
+            stack.push_back({ childIndex, sourceIndex, entry.depth + 1 });
+        }
+    }
+    return tree;
+}
+
+GuidingField::GuidingField(const BoundingBox& bounds)
+    : bounds_(bounds)
+    , nodes_(1, { 0, 0 })
+{
+    regions_.push_back(std::make_unique<Region>());
+    regions_[0]->records = std::vector<std::atomic<uint64_t>>(4);
+}
+
+const DirectionalQuadtree* GuidingField::getDistribution(const Vec3& p) const {
+    const DirectionalQuadtree& tree = regions_[findRegion(p)]->samplingTree;
+    return tree.getTotalEnergy() > 0.0f ? &tree : nullptr;
+}
+
+void GuidingField::record(const Vec3& p, const Vec3& direction, float radianceOverPdf) {
+    Region& region = *regions_[findRegion(p)];
+    region.numRecords.fetch_add(1, std::memory_order_relaxed);
+    if (!(radianceOverPdf > 0.0f)) {
+        return;
+    }
+
+    uint64_t energy = static_cast<uint64_t>(min(radianceOverPdf, maxRecordedEnergy) * recordScale);
+    if (energy == 0) {
+        return;
+    }
+
+    // Every node on the way to the leaf gets the energy, so a quadrant always
+    // has the sum of its child
+    Vec2 u = directionToSquare(direction);
+    uint32_t nodeIndex = 0;
+    do {
+        uint32_t quadrant = enterQuadrant(u);
+        region.records[4 * nodeIndex + quadrant].fetch_add(energy, std::memory_order_relaxed);
+        nodeIndex = region.recordingTree.nodes_[nodeIndex].children[quadrant];
+    } while (nodeIndex != 0);
+}
+
+void GuidingField::update() {
+    std::vector<uint64_t> numRecords(regions_.size());
+    for (size_t regionIndex = 0; regionIndex < regions_.size(); regionIndex++) {
+        Region& region = *regions_[regionIndex];
+        region.samplingTree = region.recordingTree;
+        auto& nodes = region.samplingTree.nodes_;
+        for (size_t nodeIndex = 0; nodeIndex < nodes.size(); nodeIndex++) {
+            for (uint32_t quadrant = 0; quadrant < 4; quadrant++) {
+                uint64_t energy = region.records[4 * nodeIndex + quadrant].load(std::memory_order_relaxed);
+                nodes[nodeIndex].energies[quadrant] = static_cast<float>(energy) / recordScale;
+            }
+        }
+        numRecords[regionIndex] = region.numRecords.load(std::memory_order_relaxed);
+    }
+
+    // Children of a split region start with its distribution and an even share
+    // of its records, so they are split further until every leaf is below the limit
+    float maxRecords = spatialSplitRecords * std::sqrt(std::exp2(static_cast<float>(numUpdates_)));
+    for (size_t nodeIndex = 0; nodeIndex < nodes_.size(); nodeIndex++) {
+        uint32_t regionIndex = nodes_[nodeIndex].regionIndex;
+        if (nodes_[nodeIndex].firstChild != 0 || static_cast<float>(numRecords[regionIndex]) <= maxRecords) {
+            continue;
+        }
+
+        nodes_[nodeIndex].firstChild = static_cast<uint32_t>(nodes_.size());
+        numRecords[regionIndex] /= 8;
+        for (uint32_t child = 0; child < 8; child++) {
+            uint32_t childRegionIndex = regionIndex;
+            if (child > 0) {
+                childRegionIndex = static_cast<uint32_t>(regions_.size());
+                regions_.push_back(std::make_unique<Region>());
+                regions_.back()->samplingTree = regions_[regionIndex]->samplingTree;
+                numRecords.push_back(numRecords[regionIndex]);
+            }
+            nodes_.push_back({ 0, childRegionIndex });
+        }
+    }
+
+    for (auto& region : regions_) {
+        region->recordingTree = region->samplingTree.refine(directionalSplitFraction, maxDirectionalDepth);
+        region->records = std::vector<std::atomic<uint64_t>>(4 * region->recordingTree.getNumNodes());
+        region->numRecords = 0;
+    }
+    numUpdates_++;
+}
+
+uint32_t GuidingField::findRegion(const Vec3& p) const {
+    Vec3 boxMin = bounds_.min;
+    Vec3 boxMax = bounds_.max;
+    uint32_t nodeIndex = 0;
+    while (nodes_[nodeIndex].firstChild != 0) {
+        Vec3 center = (boxMin + boxMax) * 0.5f;
+        uint32_t octant = 0;
+        for (int axis = 0; axis < 3; axis++) {
+            if (p[axis] >= center[axis]) {
+                octant |= 1 << axis;
+                boxMin[axis] = center[axis];
+            }
+            else {
+                boxMax[axis] = center[axis];
+            }
+        }
+        nodeIndex = nodes_[nodeIndex].firstChild + octant;
+    }
+    return nodes_[nodeIndex].regionIndex;
+}
+
+} // namespace pt
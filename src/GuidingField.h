@@ -0,0 +1,104 @@
+#pragma once
+
+#include "BoundingBox.h"
+#include "Vector3.h"
+
+#include <vector>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+namespace pt {
+
+// A distribution of directions by a quadtree over the square of the cylindrical
+// coordinates (cos theta, phi), which maps equal areas to equal solid angles.
+// Every node stores the energy of its four quadrants, a quadrant with a child
+// node has the sum of the energies of the child.
+class DirectionalQuadtree {
+public:
+    DirectionalQuadtree();
+
+    float getTotalEnergy() const;
+    size_t getNumNodes() const { return nodes_.size(); }
+
+    // Directions in world space, the PDFs are per solid angle. Only valid with
+    // a total energy > 0.
+    Vec3 sample(float u1, float u2, float& pdf) const;
+    float pdf(const Vec3& direction) const;
+
+    // The structure for the next energies: quadrants with more than the split
+    // fraction of the total energy get a child node (up to the max depth), the
+    // others are merged. The energies are copied or spread over new children.
+    DirectionalQuadtree refine(float splitFraction, uint32_t maxDepth) const;
+
+private:
+    friend class GuidingField;
+
+    struct Node {
+        std::array<float, 4> energies; // Quadrant index = x half + 2 * y half
+        std::array<uint32_t, 4> children; // 0 if the quadrant has no child
+    };
+
+    std::vector<Node> nodes_;
+};
+
+// A vertex of a path that is recorded into the guiding field once the path is
+// finished, the light that arrives over the direction is the radiance the path
+// gathered after the vertex divided by the throughput
+struct GuidingVertex {
+    Vec3 point;
+    Vec3 direction;
+    float pdf; // The PDF the direction was sampled with
+    Vec3 radiance; // Radiance of the path before the direction was sampled
+    Vec3 throughput; // Throughput of the path including the sampled direction
+};
+
+// Learns the distribution of the light that arrives at the points of the scene
+// from the paths of a render, stored as a spatial octree over the scene with a
+// directional quadtree for every leaf. The records of a pass go into a copy of
+// the quadtrees, so the distributions used for sampling stay fixed during the
+// pass and update() can refine both trees with the new data.
+// See: Practical Path Guiding for Efficient Light-Transport Simulation (2017), Müller et al.
+class GuidingField {
+public:
+    explicit GuidingField(const BoundingBox& bounds);
+
+    // The distribution learned for the region of the point, null if the last
+    // update had no light for the region
+    const DirectionalQuadtree* getDistribution(const Vec3& p) const;
+
+    // Adds a sample of the light arriving at p from the direction, divided by
+    // the PDF of the direction. Thread-safe, the energies are summed as fixed
+    // point integers so the result doesn't depend on the order of the records.
+    void record(const Vec3& p, const Vec3& direction, float radianceOverPdf);
+
+    // Switches the sampling to the records since the last update, splits the
+    // regions with many records and refines the quadtrees for the next records.
+    // Must not run at the same time as any other call.
+    void update();
+
+    size_t getNumRegions() const { return regions_.size(); }
+
+private:
+    struct Region {
+        DirectionalQuadtree samplingTree;
+        DirectionalQuadtree recordingTree;
+        std::vector<std::atomic<uint64_t>> records; // 4 per node of the recording tree
+        std::atomic<uint64_t> numRecords = 0;
+    };
+
+    struct Node {
+        uint32_t firstChild; // The 8 children are consecutive, 0 for a leaf
+        uint32_t regionIndex;
+    };
+
+    uint32_t findRegion(const Vec3& p) const;
+
+    BoundingBox bounds_;
+    std::vector<Node> nodes_;
+    std::vector<std::unique_ptr<Region>> regions_;
+    uint32_t numUpdates_ = 0;
+};
+
+} // namespace pt
@@ -0,0 +1,249 @@
+#include "HdrImageWriter.h"
+
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+namespace {
+
+// The files are little-endian, like the machines the renderer runs on
+template <typename T>
+void append(std::vector<uint8_t>& data, const T& value) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(&value);
+    data.insert(data.end(), bytes, bytes + sizeof(T));
+}
+
+void appendString(std::vector<uint8_t>& data, const char* text) {
+    data.insert(data.end(), text, text + std::strlen(text) + 1);
+}
+
+void appendAttribute(std::vector<uint8_t>& header, const char* name, const char* type,
+        const std::vector<uint8_t>& value) {
+    appendString(header, name);
+    appendString(header, type);
+    append(header, static_cast<int32_t>(value.size()));
+    header.insert(header.end(), value.begin(), value.end());
+}
+
+std::vector<uint8_t> createExrHeader(uint32_t width, uint32_t height, const pt::ExrOptions& options) {
+    std::vector<uint8_t> header = { 0x76, 0x2f, 0x31, 0x01 }; // Magic number
+    append(header, int32_t(2)); // Version 2, single part scanline file
+
+    // Channels have to be sorted by name
+    std::vector<uint8_t> channels;
+    for (const char* name : { "B", "G", "R" }) {
+        appendString(channels, name);
+        append(channels, int32_t(options.pixelType == pt::ExrPixelType::Half ? 1 : 2));
+        append(channels, int32_t(0)); // pLinear and reserved bytes
+        append(channels, int32_t(1)); // x sampling
+        append(channels, int32_t(1)); // y sampling
+    }
+    channels.push_back(0);
+    appendAttribute(header, "channels", "chlist", channels);
+
+    appendAttribute(header, "compression", "compression",
+        { static_cast<uint8_t>(options.compression == pt::ExrCompression::Rle ? 1 : 0) });
+
+    std::vector<uint8_t> dataWindow;
+    append(dataWindow, static_cast<int32_t>(options.offsetX));
+    append(dataWindow, static_cast<int32_t>(options.offsetY));
+    append(dataWindow, static_cast<int32_t>(options.offsetX + width - 1));
+    append(dataWindow, static_cast<int32_t>(options.offsetY + height - 1));
+    appendAttribute(header, "dataWindow", "box2i", dataWindow);
+
+    uint32_t displayWidth = options.displayWidth > 0 ? options.displayWidth : width;
+    uint32_t displayHeight = options.displayHeight > 0 ? options.displayHeight : height;
+    std::vector<uint8_t> displayWindow;
+    append(displayWindow, int32_t(0));
+    append(displayWindow, int32_t(0));
+    append(displayWindow, static_cast<int32_t>(displayWidth - 1));
+    append(displayWindow, static_cast<int32_t>(displayHeight - 1));
+    appendAttribute(header, "displayWindow", "box2i", displayWindow);
+
+    appendAttribute(header, "lineOrder", "lineOrder", { 0 }); // Increasing y
+
+    std::vector<uint8_t> one;
+    append(one, 1.0f);
+    appendAttribute(header, "pixelAspectRatio", "float", one);
+
+    std::vector<uint8_t> center;
+    append(center, 0.0f);
+    append(center, 0.0f);
+    appendAttribute(header, "screenWindowCenter", "v2f", center);
+    appendAttribute(header, "screenWindowWidth", "float", one);
+
+    header.push_back(0); // End of the header
+    return header;
+}
+
+// RLE compression of OpenEXR: the bytes are split into two halves (first the
+// even, then the odd bytes) and delta encoded, then runs of at least three equal
+// bytes are stored as (length - 1, byte) and other bytes as (-count, bytes...).
+void compressRle(const std::vector<uint8_t>& input, std::vector<uint8_t>& scratch, std::vector<uint8_t>& output) {
+    constexpr size_t minRunLength = 3;
+    constexpr size_t maxRunLength = 127;
+
+    const size_t size = input.size();
+    scratch.resize(size);
+    size_t halfSize = (size + 1) / 2;
+    for (size_t i = 0; i < size; i++) {
+        scratch[(i % 2 == 0 ? 0 : halfSize) + i / 2] = input[i];
+    }
+    uint8_t previous = scratch[0];
+    for (size_t i = 1; i < size; i++) {
+        uint8_t current = scratch[i];
+        scratch[i] = static_cast<uint8_t>(current - previous + 128);
+        previous = current;
+    }
+
+    output.clear();
+    size_t runStart = 0;
+    while (runStart < size) {
+        size_t runEnd = runStart + 1;
+        while (runEnd < size && scratch[runEnd] == scratch[runStart] && runEnd - runStart < maxRunLength + 1) {
+            runEnd++;
+        }
+
+        if (runEnd - runStart >= minRunLength) {
+            output.push_back(static_cast<uint8_t>(runEnd - runStart - 1));
+            output.push_back(scratch[runStart]);
+        }
+        else {
+            // Literals until the next run of three equal bytes. There is none at
+            // runStart, so this takes at least one byte.
+            runEnd = runStart;
+            while (runEnd < size && runEnd - runStart < maxRunLength &&
+                    (runEnd + 2 >= size || scratch[runEnd] != scratch[runEnd + 1] ||
+                    scratch[runEnd + 1] != scratch[runEnd + 2])) {
+                runEnd++;
+            }
+            output.push_back(static_cast<uint8_t>(-static_cast<int>(runEnd - runStart)));
+            output.insert(output.end(), scratch.begin() + runStart, scratch.begin() + runEnd);
+        }
+        runStart = runEnd;
+    }
+}
+
+} // namespace
+
+namespace pt {
+
+bool writePfm(const std::string& path, uint32_t width, uint32_t height, const ImageRowReader& readRow) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    // A negative scale means little-endian. The rows go from bottom to top.
+    file << "PF\n" << width << " " << height << "\n-1.0\n";
+    std::vector<float> row(static_cast<size_t>(width) * 3);
+    for (uint32_t i = 0; i < height; i++) {
+        readRow(height - 1 - i, row.data());
+        file.write(reinterpret_cast<const char*>(row.data()), row.size() * sizeof(float));
+    }
+
+    return file.good();
+}
+
+bool writeExr(const std::string& path, uint32_t width, uint32_t height, const ImageRowReader& readRow,
+        const ExrOptions& options) {
+    if (width == 0 || height == 0) {
+        return false;
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    auto header = createExrHeader(width, height, options);
+    file.write(reinterpret_cast<const char*>(header.data()), header.size());
+
+    // One scanline per chunk. The offsets are only known once the chunks are
+    // compressed, so the table is written at the end.
+    std::vector<uint64_t> offsets(height);
+    const auto offsetTablePosition = file.tellp();
+    file.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+
+    const size_t bytesPerValue = options.pixelType == ExrPixelType::Half ? 2 : 4;
+    std::vector<float> row(static_cast<size_t>(width) * 3);
+    std::vector<uint8_t> lineData(row.size() * bytesPerValue);
+    std::vector<uint8_t> scratch, compressed;
+    for (uint32_t y = 0; y < height; y++) {
+        readRow(y, row.data());
+
+        // Planar channels in the order of the channel list: B, G, R
+        uint8_t* output = lineData.data();
+        for (int channel = 2; channel >= 0; channel--) {
+            for (uint32_t x = 0; x < width; x++) {
+                float value = row[x * 3 + channel];
+                if (bytesPerValue == 2) {
+                    uint16_t half = floatToHalf(value);
+                    std::memcpy(output, &half, sizeof(half));
+                }
+                else {
+                    std::memcpy(output, &value, sizeof(value));
+                }
+                output += bytesPerValue;
+            }
+        }
+
+        // Lines that don't get smaller are stored uncompressed, which readers
+        // recognize by the size
+        const std::vector<uint8_t>* chunkData = &lineData;
+        if (options.compression == ExrCompression::Rle) {
+            compressRle(lineData, scratch, compressed);
+            if (compressed.size() < lineData.size()) {
+                chunkData = &compressed;
+            }
+        }
+
+        offsets[y] = static_cast<uint64_t>(file.tellp());
+        int32_t chunkHeader[2] = { static_cast<int32_t>(options.offsetY + y), static_cast<int32_t>(chunkData->size()) };
+        file.write(reinterpret_cast<const char*>(chunkHeader), sizeof(chunkHeader));
+        file.write(reinterpret_cast<const char*>(chunkData->data()), chunkData->size());
+    }
+
+    file.seekp(offsetTablePosition);
+    file.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+
+    return file.good();
+}
+
+uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    uint32_t sign = (bits >> 16) & 0x8000;
+    uint32_t magnitude = bits & 0x7fffffff;
+
+    if (magnitude >= 0x477fe000) { // 65504, the largest half
+        return static_cast<uint16_t>(sign | 0x7bff);
+    }
+
+    if (magnitude < 0x38800000) { // Below 2^-14, the smallest normal half
+        if (magnitude < 0x33000000) { // Rounds to zero
+            return static_cast<uint16_t>(sign);
+        }
+        // Denormal: the 24 bit mantissa shifted to units of 2^-24
+        uint32_t mantissa = (magnitude & 0x7fffff) | 0x800000;
+        uint32_t shift = 126 - (magnitude >> 23);
+        uint32_t half = mantissa >> shift;
+        uint32_t remainder = mantissa & ((1u << shift) - 1);
+        uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1))) {
+            half++;
+        }
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    // Rebias the exponent from 127 to 15 and round the mantissa to nearest even.
+    // A carry out of the mantissa correctly increments the exponent.
+    uint32_t half = (magnitude - 0x38000000) >> 13;
+    uint32_t remainder = magnitude & 0x1fff;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) {
+        half++;
+    }
+    return static_cast<uint16_t>(sign | half);
+}
+
+} // namespace pt
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace pt {
+
+// Fills one row of linear RGB floats (3 * width values), y = 0 is the top row.
+// The writers request the rows one at a time, so the image never has to exist
+// as a whole in memory.
+using ImageRowReader = std::function<void(uint32_t y, float* rgb)>;
+
+enum class ExrPixelType {
+    Half,
+    Float
+};
+
+enum class ExrCompression {
+    None,
+    Rle
+};
+
+struct ExrOptions {
+    ExrPixelType pixelType = ExrPixelType::Half;
+    ExrCompression compression = ExrCompression::Rle;
+
+    // Position of the image inside the display window, e.g. for a crop window of
+    // a larger frame. A display size of 0 means the size of the image.
+    uint32_t offsetX = 0;
+    uint32_t offsetY = 0;
+    uint32_t displayWidth = 0;
+    uint32_t displayHeight = 0;
+};
+
+// Portable float map: 32-bit float RGB, no compression
+bool writePfm(const std::string& path, uint32_t width, uint32_t height, const ImageRowReader& readRow);
+
+// Single part scanline OpenEXR with R, G and B channels
+bool writeExr(const std::string& path, uint32_t width, uint32_t height, const ImageRowReader& readRow,
+    const ExrOptions& options = {});
+
+// Rounds to the nearest half, values beyond the half range are clamped to the largest half
+uint16_t floatToHalf(float value);
+
+} // namespace pt
@@ -0,0 +1,304 @@
+#include "LightBVH.h"
+#include "Shape.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace {
+
+using namespace pt;
+
+// Splits below this depth are by count, so the path to every light fits into
+// the 64 bits of its bit trail
+constexpr uint32_t maxSplitCostDepth = 32;
+
+float safeSqrt(float x) {
+    return std::sqrt(max(x, 0.0f));
+}
+
+// cos(max(0, a - b)) and sin(max(0, a - b)) from the sines and cosines of a and b
+float cosSubClamped(float sinA, float cosA, float sinB, float cosB) {
+    return cosA > cosB ? 1.0f : cosA * cosB + sinA * sinB;
+}
+
+float sinSubClamped(float sinA, float cosA, float sinB, float cosB) {
+    return cosA > cosB ? 0.0f : sinA * cosB - cosA * sinB;
+}
+
+LightBounds getLightBounds(const Shape& light) {
+    LightBounds lightBounds;
+    lightBounds.bounds = light.getWorldBounds();
+    lightBounds.normals = light.getNormalBounds();
+    lightBounds.cosThetaE = 0.0f; // Every point emits into its hemisphere
+    lightBounds.power = light.getPower();
+    return lightBounds;
+}
+
+LightBounds mergeLightBounds(const LightBounds& a, const LightBounds& b) {
+    // Lights without power don't widen the bounds
+    if (a.power == 0.0f) {
+        return b;
+    }
+    if (b.power == 0.0f) {
+        return a;
+    }
+
+    LightBounds lightBounds;
+    lightBounds.bounds = BoundingBox(min(a.bounds.min, b.bounds.min), max(a.bounds.max, b.bounds.max));
+    lightBounds.normals = merge(a.normals, b.normals);
+    lightBounds.cosThetaE = min(a.cosThetaE, b.cosThetaE);
+    lightBounds.power = a.power + b.power;
+    return lightBounds;
+}
+
+// Surface area orientation heuristic, with the measure of the directions the
+// bounds can emit into and a penalty for thin splits across a long box
+float computeSplitCost(const LightBounds& lightBounds, const BoundingBox& nodeBounds, uint32_t dimension) {
+    float thetaO = std::acos(clamp(lightBounds.normals.cosTheta, -1.0f, 1.0f));
+    float thetaE = std::acos(clamp(lightBounds.cosThetaE, -1.0f, 1.0f));
+    float thetaW = min(thetaO + thetaE, pi<float>);
+    float cosThetaO = lightBounds.normals.cosTheta;
+    float sinThetaO = safeSqrt(1.0f - cosThetaO * cosThetaO);
+    float solidAngle = 2.0f * pi<float> * (1.0f - cosThetaO) + 0.5f * pi<float> *
+        (2.0f * thetaW * sinThetaO - std::cos(thetaO - 2.0f * thetaW) - 2.0f * thetaO * sinThetaO + cosThetaO);
+    Vec3 size = nodeBounds.max - nodeBounds.min;
+    float aspect = maxComponent(size) / size[dimension];
+    return lightBounds.power * solidAngle * aspect * lightBounds.bounds.getSurfaceArea();
+}
+
+struct SplitBin {
+    size_t numLights = 0;
+    LightBounds lightBounds;
+};
+
+} // namespace
+
+
+namespace pt {
+
+float LightBounds::importance(const Vec3& p, const Vec3& n) const {
+    Vec3 center = bounds.getCenter();
+    float distSq = lengthSq(p - center);
+    Vec3 wi = distSq > 0.0f ? (p - center) / std::sqrt(distSq) : normals.axis;
+
+    // Directions of the bounds as seen from p
+    float radiusSq = lengthSq(bounds.getExtents());
+    float cosThetaB = distSq < radiusSq ? -1.0f : safeSqrt(1.0f - radiusSq / distSq);
+    float sinThetaB = safeSqrt(1.0f - cosThetaB * cosThetaB);
+
+    // The smallest angle between a normal and a direction to p
+    float cosThetaW = dot(normals.axis, wi);
+    float sinThetaW = safeSqrt(1.0f - cosThetaW * cosThetaW);
+    float cosThetaO = normals.cosTheta;
+    float sinThetaO = safeSqrt(1.0f - cosThetaO * cosThetaO);
+    float cosThetaX = cosSubClamped(sinThetaW, cosThetaW, sinThetaO, cosThetaO);
+    float sinThetaX = sinSubClamped(sinThetaW, cosThetaW, sinThetaO, cosThetaO);
+    float cosTheta = cosSubClamped(sinThetaX, cosThetaX, sinThetaB, cosThetaB);
+    if (cosTheta <= cosThetaE) {
+        return 0.0f;
+    }
+
+    // The distance is clamped for points close to or inside the bounds
+    distSq = max(distSq, 0.5f * length(bounds.max - bounds.min));
+    float result = power * cosTheta / distSq;
+
+    // The smallest angle to the surface normal, for either side
+    if (lengthSq(n) > 0.0f) {
+        float cosThetaI = abs(dot(wi, n));
+        float sinThetaI = safeSqrt(1.0f - cosThetaI * cosThetaI);
+        result *= cosSubClamped(sinThetaI, cosThetaI, sinThetaB, cosThetaB);
+    }
+    return max(result, 0.0f);
+}
+
+LightBVH::LightBVH(const std::vector<const Shape*>& lights)
+    : bitTrails_(lights.size())
+{
+    assert(lights.size() <= std::numeric_limits<uint32_t>::max());
+    if (lights.empty()) {
+        return;
+    }
+
+    std::vector<LightInfo> lightInfos;
+    lightInfos.reserve(lights.size());
+    for (size_t index = 0; index < lights.size(); index++) {
+        LightBounds lightBounds = getLightBounds(*lights[index]);
+        lightInfos.push_back({
+            static_cast<uint32_t>(index),
+            lightBounds,
+            lightBounds.bounds.getCenter()
+        });
+    }
+
+    nodes_.reserve(2 * lights.size() - 1);
+    buildInternal(lightInfos, 0, static_cast<uint32_t>(lightInfos.size()), 0, 0);
+}
+
+bool LightBVH::sample(const Vec3& p, const Vec3& n, float u, uint32_t& lightIndex, float& probability) const {
+    if (nodes_.empty()) {
+        return false;
+    }
+
+    uint32_t nodeIndex = 0;
+    probability = 1.0f;
+    while (!nodes_[nodeIndex].isLeaf) {
+        const Node& node = nodes_[nodeIndex];
+        float importance0 = nodes_[nodeIndex + 1].lightBounds.importance(p, n);
+        float importance1 = nodes_[node.childOrLightIndex].lightBounds.importance(p, n);
+        if (importance0 == 0.0f && importance1 == 0.0f) {
+            return false;
+        }
+
+        // Reuses u for the next level
+        float probability0 = importance0 / (importance0 + importance1);
+        if (u < probability0) {
+            u = min(u / probability0, oneMinusEpsilon<float>);
+            probability *= probability0;
+            nodeIndex++;
+        }
+        else {
+            u = min((u - probability0) / (1.0f - probability0), oneMinusEpsilon<float>);
+            probability *= 1.0f - probability0;
+            nodeIndex = node.childOrLightIndex;
+        }
+    }
+
+    if (nodeIndex == 0 && nodes_[0].lightBounds.importance(p, n) == 0.0f) {
+        return false;
+    }
+    lightIndex = nodes_[nodeIndex].childOrLightIndex;
+    return true;
+}
+
+float LightBVH::getProbability(const Vec3& p, const Vec3& n, uint32_t lightIndex) const {
+    uint64_t bitTrail = bitTrails_[lightIndex];
+    uint32_t nodeIndex = 0;
+    float probability = 1.0f;
+    while (!nodes_[nodeIndex].isLeaf) {
+        const Node& node = nodes_[nodeIndex];
+        float importance0 = nodes_[nodeIndex + 1].lightBounds.importance(p, n);
+        float importance1 = nodes_[node.childOrLightIndex].lightBounds.importance(p, n);
+        if (importance0 == 0.0f && importance1 == 0.0f) {
+            return 0.0f;
+        }
+
+        float probability0 = importance0 / (importance0 + importance1);
+        if (bitTrail & 1) {
+            probability *= 1.0f - probability0;
+            nodeIndex = node.childOrLightIndex;
+        }
+        else {
+            probability *= probability0;
+            nodeIndex++;
+        }
+        bitTrail >>= 1;
+    }
+    assert(nodes_[nodeIndex].childOrLightIndex == lightIndex);
+
+    if (nodeIndex == 0 && nodes_[0].lightBounds.importance(p, n) == 0.0f) {
+        return 0.0f;
+    }
+    return probability;
+}
+
+uint32_t LightBVH::buildInternal(std::vector<LightInfo>& lightInfos, uint32_t left, uint32_t right,
+        uint64_t bitTrail, uint32_t depth) {
+    assert(depth < 64);
+    uint32_t nodeIndex = static_cast<uint32_t>(nodes_.size());
+    nodes_.emplace_back();
+
+    LightBounds lightBounds = lightInfos[left].lightBounds;
+    for (uint32_t i = left + 1; i < right; i++) {
+        lightBounds = mergeLightBounds(lightBounds, lightInfos[i].lightBounds);
+    }
+    nodes_[nodeIndex].lightBounds = lightBounds;
+
+    if (right - left == 1) {
+        nodes_[nodeIndex].childOrLightIndex = lightInfos[left].lightIndex;
+        nodes_[nodeIndex].isLeaf = true;
+        bitTrails_[lightInfos[left].lightIndex] = bitTrail;
+        return nodeIndex;
+    }
+
+    BoundingBox centroidBounds(Vec3(inf<float>), Vec3(-inf<float>));
+    for (uint32_t i = left; i < right; i++) {
+        centroidBounds.min = min(centroidBounds.min, lightInfos[i].centroid);
+        centroidBounds.max = max(centroidBounds.max, lightInfos[i].centroid);
+    }
+
+    // Split based on the minimum cost over all dimensions
+    constexpr uint32_t numBins = 12;
+    float minSplitCost = inf<float>;
+    uint32_t minCostDimension = 0;
+    uint32_t minCostSplitIndex = 0;
+    for (uint32_t dimension = 0; dimension < 3 && depth < maxSplitCostDepth; dimension++) {
+        float centroidBoundsWidth = centroidBounds.max[dimension] - centroidBounds.min[dimension];
+        if (centroidBoundsWidth < 1e-6f) {
+            continue;
+        }
+
+        SplitBin splitBins[numBins];
+        float k1 = numBins * (1.0f - 1e-6f) / centroidBoundsWidth;
+        float k0 = centroidBounds.min[dimension];
+        for (uint32_t i = left; i < right; i++) {
+            uint32_t binIndex = min(static_cast<uint32_t>(k1 * (lightInfos[i].centroid[dimension] - k0)), numBins - 1);
+            SplitBin& bin = splitBins[binIndex];
+            bin.lightBounds = bin.numLights == 0 ? lightInfos[i].lightBounds
+                : mergeLightBounds(bin.lightBounds, lightInfos[i].lightBounds);
+            bin.numLights++;
+        }
+
+        for (uint32_t split = 0; split < numBins - 1; split++) {
+            SplitBin sides[2];
+            for (uint32_t bin = 0; bin < numBins; bin++) {
+                SplitBin& side = sides[bin <= split ? 0 : 1];
+                if (splitBins[bin].numLights > 0) {
+                    side.lightBounds = side.numLights == 0 ? splitBins[bin].lightBounds
+                        : mergeLightBounds(side.lightBounds, splitBins[bin].lightBounds);
+                    side.numLights += splitBins[bin].numLights;
+                }
+            }
+            if (sides[0].numLights == 0 || sides[1].numLights == 0) {
+                continue;
+            }
+
+            float cost = computeSplitCost(sides[0].lightBounds, lightBounds.bounds, dimension)
+                + computeSplitCost(sides[1].lightBounds, lightBounds.bounds, dimension);
+            if (cost < minSplitCost) {
+                minSplitCost = cost;
+                minCostDimension = dimension;
+                minCostSplitIndex = split;
+            }
+        }
+    }
+
+    uint32_t middle;
+    if (minSplitCost < inf<float>) {
+        float k1 = numBins * (1.0f - 1e-6f) / (centroidBounds.max[minCostDimension] - centroidBounds.min[minCostDimension]);
+        float k0 = centroidBounds.min[minCostDimension];
+        auto middleIter = std::partition(lightInfos.begin() + left, lightInfos.begin() + right,
+            [&](const LightInfo& info) {
+                uint32_t binIndex = min(static_cast<uint32_t>(k1 * (info.centroid[minCostDimension] - k0)), numBins - 1);
+                return binIndex <= minCostSplitIndex;
+            });
+        middle = static_cast<uint32_t>(middleIter - lightInfos.begin());
+    }
+    else {
+        // Split with equal counts, also for stacked centroids
+        uint32_t splitDimension = maxDimension(centroidBounds.getExtents());
+        middle = (left + right) / 2;
+        std::nth_element(lightInfos.begin() + left, lightInfos.begin() + middle, lightInfos.begin() + right,
+            [&](const LightInfo& a, const LightInfo& b) {
+                return a.centroid[splitDimension] < b.centroid[splitDimension];
+            });
+    }
+
+    buildInternal(lightInfos, left, middle, bitTrail, depth + 1);
+    uint32_t secondChild = buildInternal(lightInfos, middle, right, bitTrail | (uint64_t(1) << depth), depth + 1);
+    nodes_[nodeIndex].childOrLightIndex = secondChild;
+    nodes_[nodeIndex].isLeaf = false;
+    return nodeIndex;
+}
+
+} // namespace pt
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "BoundingBox.h"
+#include "DirectionCone.h"
+
+#include <vector>
+#include <cstdint>
+
+namespace pt {
+
+class Shape;
+
+// Bounds of the emission of a light or a group of lights
+struct LightBounds {
+    // An estimate of the light arriving at the point p with the surface normal n
+    // (zero for points in the volume), conservative towards the brightest light
+    // in the bounds. Zero if no light in the bounds can reach p.
+    float importance(const Vec3& p, const Vec3& n) const;
+
+    BoundingBox bounds;
+    DirectionCone normals;
+    float cosThetaE; // Spread of the emission around every normal
+    float power;
+};
+
+// Picks one of many lights for a shading point by descending a BVH over the
+// lights, with the probability of every child proportional to the importance
+// of its bounds. Distant lights and lights facing away get a low probability.
+// See: Importance Sampling of Many Lights with Adaptive Tree Splitting (2018), Conty Estevez and Kulla
+// and Physically Based Rendering 4th edition, section 12.6.3
+class LightBVH {
+public:
+    LightBVH() = default;
+    explicit LightBVH(const std::vector<const Shape*>& lights);
+
+    // Returns false if no light reaches the point
+    bool sample(const Vec3& p, const Vec3& n, float u, uint32_t& lightIndex, float& probability) const;
+    float getProbability(const Vec3& p, const Vec3& n, uint32_t lightIndex) const;
+
+    size_t getNumNodes() const { return nodes_.size(); }
+
+private:
+    struct Node {
+        LightBounds lightBounds;
+        // The second child, the first child is always the next node
+        uint32_t childOrLightIndex;
+        bool isLeaf;
+    };
+
+    struct LightInfo {
+        uint32_t lightIndex;
+        LightBounds lightBounds;
+        Vec3 centroid;
+    };
+
+    uint32_t buildInternal(std::vector<LightInfo>& lightInfos, uint32_t left, uint32_t right,
+        uint64_t bitTrail, uint32_t depth);
+
+    std::vector<Node> nodes_;
+    // The path from the root to every light, bit i is set if the light is
+    // below the second child at depth i
+    std::vector<uint64_t> bitTrails_;
+};
+
+} // namespace pt
@@ -0,0 +1,223 @@
+#include "Network.h"
+
+#include <cstring>
+#include <cstdlib>
+
+#ifndef _WIN32
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Guards against a corrupted stream allocating huge buffers
+constexpr uint32_t kMaxPayloadSize = 1u << 30;
+
+void writeUint32(uint8_t* destination, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        destination[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+uint32_t readUint32(const uint8_t* source) {
+    uint32_t value = 0;
+    for (int i = 0; i < 4; i++) {
+        value |= static_cast<uint32_t>(source[i]) << (8 * i);
+    }
+    return value;
+}
+
+} // namespace
+
+namespace pt {
+
+Socket::~Socket() {
+    close();
+}
+
+Socket::Socket(Socket&& other) noexcept : handle_(other.handle_) {
+    other.handle_ = -1;
+}
+
+Socket& Socket::operator=(Socket&& other) noexcept {
+    if (this != &other) {
+        close();
+        handle_ = other.handle_;
+        other.handle_ = -1;
+    }
+    return *this;
+}
+
+bool Socket::sendMessage(uint32_t type, const std::string& payload) {
+    return sendMessage(type, payload.data(), payload.size());
+}
+
+bool Socket::sendMessage(uint32_t type, const void* payload, size_t size) {
+    if (size > kMaxPayloadSize) {
+        return false;
+    }
+
+    uint8_t header[8];
+    writeUint32(header, type);
+    writeUint32(header + 4, static_cast<uint32_t>(size));
+    return sendAll(header, sizeof(header)) && (size == 0 || sendAll(payload, size));
+}
+
+bool Socket::receiveMessage(uint32_t& type, std::vector<uint8_t>& payload) {
+    uint8_t header[8];
+    if (!receiveAll(header, sizeof(header))) {
+        return false;
+    }
+
+    type = readUint32(header);
+    uint32_t size = readUint32(header + 4);
+    if (size > kMaxPayloadSize) {
+        return false;
+    }
+
+    payload.resize(size);
+    return size == 0 || receiveAll(payload.data(), size);
+}
+
+bool parseAddress(const std::string& address, std::string& host, uint16_t& port) {
+    size_t separator = address.rfind(':');
+    std::string portString = separator == std::string::npos ? address : address.substr(separator + 1);
+    host = separator == std::string::npos || separator == 0 ? "127.0.0.1" : address.substr(0, separator);
+
+    char* end = nullptr;
+    long value = std::strtol(portString.c_str(), &end, 10);
+    if (portString.empty() || *end != '\0' || value <= 0 || value > 65535) {
+        return false;
+    }
+
+    port = static_cast<uint16_t>(value);
+    return true;
+}
+
+#ifndef _WIN32
+
+bool Socket::listen(uint16_t port) {
+    close();
+    handle_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (handle_ < 0) {
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(handle_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (::bind(handle_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+            ::listen(handle_, 16) != 0) {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+bool Socket::connect(const std::string& host, uint16_t port) {
+    close();
+
+    addrinfo hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* addresses = nullptr;
+    std::string service = std::to_string(port);
+    if (getaddrinfo(host.c_str(), service.c_str(), &hints, &addresses) != 0) {
+        return false;
+    }
+
+    for (addrinfo* info = addresses; info; info = info->ai_next) {
+        handle_ = ::socket(info->ai_family, info->ai_socktype, info->ai_protocol);
+        if (handle_ >= 0 && ::connect(handle_, info->ai_addr, info->ai_addrlen) == 0) {
+            break;
+        }
+        close();
+    }
+    freeaddrinfo(addresses);
+
+    if (handle_ >= 0) {
+        // Small result and work messages shouldn't wait for more data
+        int noDelay = 1;
+        setsockopt(handle_, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    }
+
+    return handle_ >= 0;
+}
+
+Socket Socket::accept() {
+    int handle = ::accept(handle_, nullptr, nullptr);
+    if (handle >= 0) {
+        int noDelay = 1;
+        setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+    }
+    return Socket(handle);
+}
+
+void Socket::close() {
+    if (handle_ >= 0) {
+        ::close(handle_);
+        handle_ = -1;
+    }
+}
+
+uint16_t Socket::getPort() const {
+    sockaddr_in address = {};
+    socklen_t length = sizeof(address);
+    if (handle_ < 0 || getsockname(handle_, reinterpret_cast<sockaddr*>(&address), &length) != 0) {
+        return 0;
+    }
+    return ntohs(address.sin_port);
+}
+
+bool Socket::sendAll(const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+#ifdef MSG_NOSIGNAL
+        ssize_t sent = ::send(handle_, bytes, size, MSG_NOSIGNAL); // A closed peer must not kill the process
+#else
+        ssize_t sent = ::send(handle_, bytes, size, 0);
+#endif
+        if (sent <= 0) {
+            return false;
+        }
+        bytes += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+bool Socket::receiveAll(void* data, size_t size) {
+    char* bytes = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t received = ::recv(handle_, bytes, size, 0);
+        if (received <= 0) {
+            return false;
+        }
+        bytes += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+#else
+
+bool Socket::listen(uint16_t) { return false; }
+bool Socket::connect(const std::string&, uint16_t) { return false; }
+Socket Socket::accept() { return Socket(); }
+void Socket::close() { handle_ = -1; }
+uint16_t Socket::getPort() const { return 0; }
+bool Socket::sendAll(const void*, size_t) { return false; }
+bool Socket::receiveAll(void*, size_t) { return false; }
+
+#endif
+
+} // namespace pt
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pt {
+
+// Blocking TCP socket that exchanges framed messages. Every message starts with
+// a 32 bit type and a 32 bit payload size, both in little endian byte order.
+// Only implemented for POSIX systems, all operations fail elsewhere.
+class Socket {
+public:
+    Socket() = default;
+    ~Socket();
+
+    Socket(Socket&& other) noexcept;
+    Socket& operator=(Socket&& other) noexcept;
+    Socket(const Socket&) = delete;
+    Socket& operator=(const Socket&) = delete;
+
+    // Listens on all interfaces. Port 0 picks a free port, see getPort().
+    bool listen(uint16_t port);
+    bool connect(const std::string& host, uint16_t port);
+    Socket accept();
+    void close();
+
+    bool sendMessage(uint32_t type, const void* payload, size_t size);
+    bool sendMessage(uint32_t type, const std::string& payload);
+    bool receiveMessage(uint32_t& type, std::vector<uint8_t>& payload);
+
+    uint16_t getPort() const;
+    int getHandle() const { return handle_; }
+    bool isValid() const { return handle_ >= 0; }
+
+private:
+    explicit Socket(int handle) : handle_(handle) {}
+
+    bool sendAll(const void* data, size_t size);
+    bool receiveAll(void* data, size_t size);
+
+    int handle_ = -1;
+};
+
+// Splits "host:port" into its parts, the host defaults to localhost
+bool parseAddress(const std::string& address, std::string& host, uint16_t& port);
+
+} // namespace pt
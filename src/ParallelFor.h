@@ -0,0 +1,48 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace pt {
+
+// Calls function(i) for every i in [0, count) on up to numThreads threads
+// (0 = one per hardware thread). Items are handed out one at a time, so each
+// item should be a reasonably large piece of work, e.g. a block of rows.
+template <typename Function>
+void parallelFor(size_t count, const Function& function, uint32_t numThreads = 0) {
+    if (numThreads == 0) {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    numThreads = static_cast<uint32_t>(std::min<size_t>(numThreads, count));
+
+    if (numThreads <= 1) {
+        for (size_t i = 0; i < count; i++) {
+            function(i);
+        }
+        return;
+    }
+
+    std::atomic<size_t> nextIndex = 0;
+    auto workerMain = [&] {
+        for (size_t i = nextIndex++; i < count; i = nextIndex++) {
+            function(i);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(numThreads - 1);
+    for (uint32_t i = 1; i < numThreads; i++) {
+        threads.emplace_back(workerMain);
+    }
+    workerMain();
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+} // namespace pt
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "RayStream.h"
+#include "GuidingField.h"
+
+#include <vector>
+#include <cstdint>
+
+namespace pt {
+
+class Shape;
+
+// The state of the paths of a wavefront in SoA layout, so a stage only touches
+// the arrays it needs (see Renderer::renderTileWavefront). The stages pass the
+// indices of the paths they produce work for in queues.
+struct PathPool {
+    explicit PathPool(uint32_t capacity_, uint32_t numSampleFloats)
+        : capacity(capacity_)
+    {
+        rays.resize(capacity);
+        throughputs.resize(capacity);
+        radiances.resize(capacity);
+        vertexPoints.resize(capacity);
+        vertexNormals.resize(capacity);
+        vertexShapes.resize(capacity);
+        bsdfs.resize(capacity);
+        cosThetas.resize(capacity);
+        bsdfPdfs.resize(capacity);
+        shadowRays.resize(capacity);
+        shadowLights.resize(capacity);
+        shadowContributions.resize(capacity);
+        samples.resize(static_cast<size_t>(capacity) * numSampleFloats);
+        activePaths.reserve(capacity);
+        shadowPaths.reserve(capacity);
+        extendedPaths.reserve(capacity);
+    }
+
+    // The sample float at the given offset of the sample layout
+    float getSample(uint32_t floatOffset, uint32_t path) const {
+        return samples[static_cast<size_t>(floatOffset) * capacity + path];
+    }
+
+    uint32_t capacity;
+
+    // Ray of the current bounce and its closest hit
+    RayStream rays;
+
+    Vec3Array throughputs;
+    Vec3Array radiances;
+
+    // The vertex that sampled the ray with its BSDF, for the MIS weight of a light hit
+    Vec3Array vertexPoints;
+    Vec3Array vertexNormals;
+    std::vector<const Shape*> vertexShapes;
+    Vec3Array bsdfs;
+    std::vector<float> cosThetas;
+    std::vector<float> bsdfPdfs;
+
+    // Shadow ray of the next event estimation, the contribution is added if the
+    // light is the closest hit
+    RayStream shadowRays;
+    std::vector<const Shape*> shadowLights;
+    Vec3Array shadowContributions;
+
+    // The vertices of every path for the guiding field, only allocated in the
+    // passes that train it (maxGuidingVertices per path)
+    std::vector<GuidingVertex> guidingVertices;
+    std::vector<uint32_t> numGuidingVertices;
+    uint32_t maxGuidingVertices = 0;
+
+    // The floats of the sample layout for every path, see getSample()
+    std::vector<float> samples;
+
+    // Paths to shade at the current depth, paths with a shadow ray and paths
+    // with a new ray after the BSDF sampling
+    std::vector<uint32_t> activePaths;
+    std::vector<uint32_t> shadowPaths;
+    std::vector<uint32_t> extendedPaths;
+};
+
+} // namespace pt
@@ -0,0 +1,186 @@
+#include "PngWriter.h"
+#include "Deflate.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+namespace {
+
+// Filtered image data per IDAT chunk. Fixed, so the file doesn't depend on the
+// number of threads. Large enough that the matches lost at the block borders
+// don't matter.
+constexpr size_t kTargetBlockSize = 256 * 1024;
+constexpr size_t kBytesPerPixel = 3;
+
+struct CompressedBlock {
+    std::vector<uint8_t> data;
+    uint32_t adler;
+    size_t uncompressedSize;
+    uint32_t crc;
+};
+
+uint8_t paethPredictor(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = std::abs(p - a);
+    int pb = std::abs(p - b);
+    int pc = std::abs(p - c);
+    return static_cast<uint8_t>(pa <= pb && pa <= pc ? a : (pb <= pc ? b : c));
+}
+
+// Applies one of the five PNG filters, previousRow is all zeros for the first
+// row. One loop per filter, so the simple ones can be vectorized.
+void applyFilter(int filter, const uint8_t* row, const uint8_t* previousRow, size_t rowSize, uint8_t* output) {
+    constexpr size_t bpp = kBytesPerPixel;
+    switch (filter) {
+    case 1:
+        std::copy(row, row + bpp, output);
+        for (size_t i = bpp; i < rowSize; i++) {
+            output[i] = static_cast<uint8_t>(row[i] - row[i - bpp]);
+        }
+        break;
+    case 2:
+        for (size_t i = 0; i < rowSize; i++) {
+            output[i] = static_cast<uint8_t>(row[i] - previousRow[i]);
+        }
+        break;
+    case 3:
+        for (size_t i = 0; i < bpp; i++) {
+            output[i] = static_cast<uint8_t>(row[i] - (previousRow[i] >> 1));
+        }
+        for (size_t i = bpp; i < rowSize; i++) {
+            output[i] = static_cast<uint8_t>(row[i] - ((row[i - bpp] + previousRow[i]) >> 1));
+        }
+        break;
+    case 4:
+        for (size_t i = 0; i < bpp; i++) {
+            output[i] = static_cast<uint8_t>(row[i] - previousRow[i]);
+        }
+        for (size_t i = bpp; i < rowSize; i++) {
+            output[i] = static_cast<uint8_t>(row[i] - paethPredictor(row[i - bpp], previousRow[i], previousRow[i - bpp]));
+        }
+        break;
+    default:
+        std::copy(row, row + rowSize, output);
+        break;
+    }
+}
+
+// Picks the filter with the smallest sum of absolute (signed) values, the same
+// heuristic as libpng and stb_image_write. Writes the filter byte and the row.
+void filterRow(const uint8_t* row, const uint8_t* previousRow, size_t rowSize, uint8_t* output, uint8_t* scratch) {
+    int bestFilter = 0;
+    uint64_t bestScore = UINT64_MAX;
+    for (int filter = 0; filter < 5; filter++) {
+        uint8_t* candidate = scratch + filter * rowSize;
+        applyFilter(filter, row, previousRow, rowSize, candidate);
+        uint64_t score = 0;
+        for (size_t i = 0; i < rowSize; i++) {
+            score += static_cast<uint8_t>(std::abs(static_cast<int8_t>(candidate[i])));
+        }
+        if (score < bestScore) {
+            bestScore = score;
+            bestFilter = filter;
+        }
+    }
+
+    output[0] = static_cast<uint8_t>(bestFilter);
+    const uint8_t* best = scratch + bestFilter * rowSize;
+    std::copy(best, best + rowSize, output + 1);
+}
+
+void appendUint32(std::vector<uint8_t>& data, uint32_t value) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        data.push_back(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+uint32_t computeChunkCrc(const char* type, const std::vector<uint8_t>& data) {
+    uint32_t crc = pt::crc32(reinterpret_cast<const uint8_t*>(type), 4);
+    return pt::crc32(data.data(), data.size(), crc);
+}
+
+void writeChunk(std::ofstream& file, const char* type, const std::vector<uint8_t>& data, uint32_t crc) {
+    std::vector<uint8_t> header;
+    appendUint32(header, static_cast<uint32_t>(data.size()));
+    header.insert(header.end(), type, type + 4);
+    file.write(reinterpret_cast<const char*>(header.data()), header.size());
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+
+    std::vector<uint8_t> footer;
+    appendUint32(footer, crc);
+    file.write(reinterpret_cast<const char*>(footer.data()), footer.size());
+}
+
+void writeChunk(std::ofstream& file, const char* type, const std::vector<uint8_t>& data) {
+    writeChunk(file, type, data, computeChunkCrc(type, data));
+}
+
+} // namespace
+
+namespace pt {
+
+bool writePng(const std::string& path, uint32_t width, uint32_t height,
+        const std::vector<uint8_t>& rgb, uint32_t numThreads) {
+    size_t rowSize = static_cast<size_t>(width) * kBytesPerPixel;
+    if (width == 0 || height == 0 || rgb.size() != rowSize * height) {
+        return false;
+    }
+
+    size_t rowsPerBlock = std::max<size_t>(1, kTargetBlockSize / (rowSize + 1));
+    size_t numBlocks = (height + rowsPerBlock - 1) / rowsPerBlock;
+    std::vector<CompressedBlock> blocks(numBlocks);
+    const std::vector<uint8_t> zeroRow(rowSize);
+
+    parallelFor(numBlocks, [&](size_t blockIndex) {
+        size_t firstRow = blockIndex * rowsPerBlock;
+        size_t endRow = std::min<size_t>(firstRow + rowsPerBlock, height);
+
+        std::vector<uint8_t> filtered((endRow - firstRow) * (rowSize + 1));
+        std::vector<uint8_t> scratch(5 * rowSize);
+        for (size_t y = firstRow; y < endRow; y++) {
+            const uint8_t* row = &rgb[y * rowSize];
+            const uint8_t* previousRow = y > 0 ? row - rowSize : zeroRow.data();
+            filterRow(row, previousRow, rowSize, &filtered[(y - firstRow) * (rowSize + 1)], scratch.data());
+        }
+
+        auto& block = blocks[blockIndex];
+        block.data = deflateChunk(filtered.data(), filtered.size(), blockIndex + 1 == numBlocks);
+        block.adler = adler32(filtered.data(), filtered.size());
+        block.uncompressedSize = filtered.size();
+        block.crc = computeChunkCrc("IDAT", block.data);
+    }, numThreads);
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    const uint8_t signature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+    file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+    std::vector<uint8_t> header;
+    appendUint32(header, width);
+    appendUint32(header, height);
+    header.insert(header.end(), { 8, 2, 0, 0, 0 }); // 8 bit RGB, deflate, adaptive filtering, no interlacing
+    writeChunk(file, "IHDR", header);
+
+    // The IDAT chunks form one zlib stream. The zlib header and the Adler-32
+    // trailer get small chunks of their own, so the blocks can be used as they are.
+    writeChunk(file, "IDAT", { 0x78, 0x5e });
+    uint32_t adler = 1;
+    for (const auto& block : blocks) {
+        writeChunk(file, "IDAT", block.data, block.crc);
+        adler = adler32Combine(adler, block.adler, block.uncompressedSize);
+    }
+    std::vector<uint8_t> trailer;
+    appendUint32(trailer, adler);
+    writeChunk(file, "IDAT", trailer);
+    writeChunk(file, "IEND", {});
+
+    return file.good();
+}
+
+} // namespace pt
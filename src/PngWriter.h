@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace pt {
+
+// Writes an 8-bit RGB PNG. Blocks of rows are filtered and deflated in parallel
+// and each block becomes its own IDAT chunk. The compression is about the same
+// as stb_image_write (fixed Huffman codes), independent of the thread count.
+bool writePng(const std::string& path, uint32_t width, uint32_t height,
+    const std::vector<uint8_t>& rgb, uint32_t numThreads = 0);
+
+} // namespace pt
@@ -7,19 +7,27 @@
 
 namespace pt {
 
-ProgressBar::ProgressBar(size_t totalWork, const std::string& title, size_t barWidth)
+ProgressBar::ProgressBar(size_t totalWork, const std::string& title, bool isVisible, size_t barWidth)
     : totalWork_(totalWork)
     , title_(title)
     , barWidth_(barWidth)
 {
-    updateThread_ = std::thread([&] {
-        updateThreadMain();
-    });
+    if (isVisible) {
+        updateThread_ = std::thread([&] {
+            updateThreadMain();
+        });
+    }
 }
 
 ProgressBar::~ProgressBar() {
-    shouldExit_ = true;
-    updateThread_.join();
+    {
+        std::lock_guard<std::mutex> lock(exitMutex_);
+        shouldExit_ = true;
+    }
+    exitCondition_.notify_one(); // Don't wait for the current sleep to finish
+    if (updateThread_.joinable()) {
+        updateThread_.join();
+    }
 }
 
 void ProgressBar::update(size_t amount) {
@@ -31,8 +39,12 @@ void ProgressBar::updateThreadMain() const {
     size_t numIterations = 0;
     auto sleepDuration = std::chrono::milliseconds(250);
 
-    while (!shouldExit_) {
-        std::this_thread::sleep_for(sleepDuration);
+    bool isExiting = false;
+    while (!isExiting) {
+        {
+            std::unique_lock<std::mutex> lock(exitMutex_);
+            isExiting = exitCondition_.wait_for(lock, sleepDuration, [&] { return shouldExit_; });
+        }
 
         auto currTime = std::chrono::high_resolution_clock::now();
         auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(currTime - startTime);
@@ -3,12 +3,15 @@
 #include <string>
 #include <atomic>
 #include <thread>
+#include <mutex>
+#include <condition_variable>
 
 namespace pt {
 
 class ProgressBar {
 public:
-    ProgressBar(size_t totalWork, const std::string& title, size_t barWidth = 50);
+    // A hidden progress bar only counts the work without printing anything
+    ProgressBar(size_t totalWork, const std::string& title, bool isVisible = true, size_t barWidth = 50);
     ~ProgressBar();
 
     void update(size_t amount = 1);
@@ -21,7 +24,9 @@ private:
     size_t barWidth_;
     std::thread updateThread_;
     std::atomic<size_t> workDone_ = 0;
-    std::atomic<bool> shouldExit_ = false;
+    bool shouldExit_ = false;
+    mutable std::mutex exitMutex_;
+    mutable std::condition_variable exitCondition_;
 };
 
 } // namespace pt
@@ -1,20 +1,20 @@
 #include "RandomSampler.h"
+#include "HashUtils.h"
 
 namespace pt {
 
-RandomSampler::RandomSampler(uint32_t samplesPerPixel)
-    : Sampler(samplesPerPixel)
+RandomSampler::RandomSampler(uint32_t samplesPerPixel, uint64_t seed)
+    : Sampler(samplesPerPixel, seed)
 {
+    seedSample(rng_, sampleIndex_);
 }
 
-std::unique_ptr<Sampler> RandomSampler::clone(uint64_t seed) {
-    auto clonedSampler = std::make_unique<RandomSampler>(getSamplesPerPixel());
-    constexpr uint64_t oddBitsMask = 0x5555555555555555ul;
-    constexpr uint64_t evenBitsMask = 0xaaaaaaaaaaaaaaaaul;
-    clonedSampler->rng_.seed(
-        RandomSeries::defaultState ^ (seed & oddBitsMask),
-        RandomSeries::defaultInc ^ (seed & evenBitsMask));
-    return clonedSampler;
+std::unique_ptr<Sampler> RandomSampler::clone() const {
+    return std::make_unique<RandomSampler>(samplesPerPixel_, seed_);
+}
+
+const char* RandomSampler::getName() const {
+    return "random";
 }
 
 float RandomSampler::get1D() {
@@ -22,15 +22,51 @@ float RandomSampler::get1D() {
 }
 
 Vec2 RandomSampler::get2D() {
-    return Vec2(rng_.uniformFloat(), rng_.uniformFloat());
+    float x = rng_.uniformFloat();
+    float y = rng_.uniformFloat();
+    return Vec2(x, y);
 }
 
 void RandomSampler::startNextSample() {
-    // Nothing to do
+    sampleIndex_++;
+    seedSample(rng_, sampleIndex_);
+}
+
+void RandomSampler::startSample(uint32_t sampleIndex) {
+    sampleIndex_ = sampleIndex;
+    seedSample(rng_, sampleIndex_);
 }
 
 void RandomSampler::startPixel(uint32_t pixelIndex) {
-    // Nothing to do
+    pixelIndex_ = pixelIndex;
+    sampleIndex_ = 0;
+    seedSample(rng_, sampleIndex_);
+}
+
+// The floats of the calls follow each other in the stream of every sample
+void RandomSampler::generateSamples(const SampleLayout& layout, uint32_t firstCall, uint32_t endCall,
+        uint32_t firstSample, uint32_t numSamples, float* samples, size_t stride) {
+    uint32_t firstFloat = layout.getFloatOffset(firstCall);
+    uint32_t endFloat = layout.getFloatOffset(endCall);
+    RandomSeries rng;
+    for (uint32_t i = 0; i < numSamples; i++) {
+        seedSample(rng, firstSample + i);
+        rng.advance(firstFloat);
+        for (uint32_t j = firstFloat; j < endFloat; j++) {
+            samples[j * stride + i] = rng.uniformFloat();
+        }
+    }
+}
+
+// Every sample gets its own random stream, and the position in the stream is the dimension
+void RandomSampler::seedSample(RandomSeries& rng, uint32_t sampleIndex) const {
+    uint64_t sampleKey = (static_cast<uint64_t>(pixelIndex_) << 32) | sampleIndex;
+    uint64_t seed = hash(sampleKey ^ hash(seed_));
+    constexpr uint64_t oddBitsMask = 0x5555555555555555ul;
+    constexpr uint64_t evenBitsMask = 0xaaaaaaaaaaaaaaaaul;
+    rng.seed(
+        RandomSeries::defaultState ^ (seed & oddBitsMask),
+        RandomSeries::defaultInc ^ (seed & evenBitsMask));
 }
 
 } // namespace pt
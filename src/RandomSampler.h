@@ -5,18 +5,26 @@
 
 namespace pt {
 
-class RandomSampler : public Sampler {
+class RandomSampler final : public Sampler {
 public:
-    RandomSampler(uint32_t samplesPerPixel);
+    RandomSampler(uint32_t samplesPerPixel, uint64_t seed = 0);
 
-    virtual std::unique_ptr<Sampler> clone(uint64_t seed) override;
+    virtual std::unique_ptr<Sampler> clone() const override;
+    virtual const char* getName() const override;
     virtual float get1D() override;
     virtual Vec2 get2D() override;
     virtual void startNextSample() override;
+    virtual void startSample(uint32_t sampleIndex) override;
     virtual void startPixel(uint32_t pixelIndex) override;
+    virtual void generateSamples(const SampleLayout& layout, uint32_t firstCall, uint32_t endCall,
+        uint32_t firstSample, uint32_t numSamples, float* samples, size_t stride) override;
 
 private:
+    void seedSample(RandomSeries& rng, uint32_t sampleIndex) const;
+
     RandomSeries rng_;
+    uint32_t pixelIndex_ = 0;
+    uint32_t sampleIndex_ = 0;
 };
 
 } // namespace pt
@@ -27,6 +27,25 @@ public:
         return (xorShifted >> rot) | (xorShifted << ((~rot + 1u) & 31));
     }
 
+    // Skips the next delta numbers in O(log(delta))
+    // See: Random Number Generation with Arbitrary Strides (1994), Forrest B. Brown
+    constexpr void advance(uint64_t delta) {
+        uint64_t multiplier = 6364136223846793005ull;
+        uint64_t increment = inc_ | 1;
+        uint64_t totalMultiplier = 1;
+        uint64_t totalIncrement = 0;
+        while (delta > 0) {
+            if (delta & 1) {
+                totalMultiplier *= multiplier;
+                totalIncrement = totalIncrement * multiplier + increment;
+            }
+            increment *= multiplier + 1;
+            multiplier *= multiplier;
+            delta >>= 1;
+        }
+        state_ = totalMultiplier * state_ + totalIncrement;
+    }
+
     // Range: [0,1)
     constexpr float uniformFloat() {
         return min(oneMinusEpsilon<float>, static_cast<float>(uniformUint32()) / 0xffffffff);
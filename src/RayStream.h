@@ -0,0 +1,79 @@
+#pragma once
+
+#include "Ray.h"
+
+#include <vector>
+#include <cstdint>
+
+namespace pt {
+
+// Vectors with one array per component
+struct Vec3Array {
+    void resize(size_t size) {
+        x.resize(size);
+        y.resize(size);
+        z.resize(size);
+    }
+
+    Vec3 get(size_t index) const {
+        return Vec3(x[index], y[index], z[index]);
+    }
+
+    void set(size_t index, const Vec3& v) {
+        x[index] = v.x;
+        y[index] = v.y;
+        z[index] = v.z;
+    }
+
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+};
+
+// Rays in SoA layout that are traced together, see BVH::intersect(RayStream&).
+// A trace only covers the rays in a list of indices, so a stream can hold a
+// ray for every path of a wavefront.
+struct RayStream {
+    void resize(size_t size) {
+        origins.resize(size);
+        directions.resize(size);
+        invDirections.resize(size);
+        tmax.resize(size);
+        hitDistances.resize(size);
+        hitNormals.resize(size);
+        hitShapes.resize(size);
+        traversalRays.reserve(size);
+    }
+
+    Ray getRay(size_t index) const {
+        Ray ray(origins.get(index), directions.get(index));
+        ray.tmax = tmax[index];
+        return ray;
+    }
+
+    void setRay(size_t index, const Ray& ray) {
+        origins.set(index, ray.origin);
+        directions.set(index, ray.direction);
+        invDirections.set(index, Vec3(1.0f) / ray.direction);
+        tmax[index] = ray.tmax;
+    }
+
+    RayHit getHit(size_t index) const {
+        return RayHit(hitDistances[index], hitNormals.get(index), hitShapes[index]);
+    }
+
+    Vec3Array origins;
+    Vec3Array directions;
+    Vec3Array invDirections;
+    std::vector<float> tmax; // Shrinks to the closest hit during a trace
+
+    // The closest hit, or any hit for an occlusion test (rayMiss if there is none)
+    std::vector<float> hitDistances;
+    Vec3Array hitNormals;
+    std::vector<const Shape*> hitShapes;
+
+    // The indices of the rays that reach the current node of a trace
+    std::vector<uint32_t> traversalRays;
+};
+
+} // namespace pt
@@ -0,0 +1,168 @@
+#include "RenderServer.h"
+#include "SceneFileParser.h"
+#include "Renderer.h"
+#include "Camera.h"
+#include "Film.h"
+
+#include <chrono>
+#include <exception>
+
+namespace {
+
+using json = nlohmann::json;
+using Clock = std::chrono::steady_clock;
+
+float secondsSince(Clock::time_point start) {
+    return std::chrono::duration<float>(Clock::now() - start).count();
+}
+
+json errorResponse(const std::string& message) {
+    return { { "status", "error" }, { "message", message } };
+}
+
+} // namespace
+
+
+namespace pt {
+
+void RenderServer::run(std::istream& input, std::ostream& output) {
+    std::string line;
+    while (std::getline(input, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+
+        json job = json::parse(line, nullptr, false, true);
+        json response = job.is_object() ? processJob(job) : errorResponse("Invalid JSON job");
+        output << response.dump() << std::endl;
+
+        if (job.is_object() && job.value("command", "") == "quit") {
+            break;
+        }
+    }
+}
+
+json RenderServer::processJob(const json& job) {
+    // A bad job must never take down the server and its resident scenes
+    try {
+        std::string command = job.value("command", "render");
+        if (command == "render") {
+            return render(job);
+        }
+        else if (command == "load") {
+            bool wasCached;
+            auto start = Clock::now();
+            if (!getScene(job.at("scene").get<std::string>(), wasCached)) {
+                return errorResponse("Failed to load the scene");
+            }
+            return { { "status", "ok" }, { "cached", wasCached }, { "loadTime", secondsSince(start) } };
+        }
+        else if (command == "unload") {
+            std::filesystem::path scenePath = job.at("scene").get<std::string>();
+            size_t numErased = scenes_.erase(std::filesystem::absolute(scenePath).lexically_normal().string());
+            return { { "status", "ok" }, { "unloaded", numErased > 0 } };
+        }
+        else if (command == "list") {
+            json sceneList = json::array();
+            for (const auto& [path, scene] : scenes_) {
+                sceneList.push_back(path);
+            }
+            return { { "status", "ok" }, { "scenes", sceneList } };
+        }
+        else if (command == "quit") {
+            return { { "status", "ok" } };
+        }
+        return errorResponse("Unknown command \"" + command + "\"");
+    }
+    catch (const std::exception& e) {
+        return errorResponse(e.what());
+    }
+}
+
+json RenderServer::render(const json& job) {
+    auto start = Clock::now();
+    std::filesystem::path scenePath = job.at("scene").get<std::string>();
+    std::string outputPath = job.value("output", "output.png");
+
+    bool wasCached;
+    const LoadedScene* loadedScene = getScene(scenePath, wasCached);
+    if (!loadedScene) {
+        return errorResponse("Failed to load the scene");
+    }
+    float loadTime = secondsSince(start);
+
+    json settings = loadedScene->settings;
+    for (const char* block : { "film", "camera", "sampler", "renderer" }) {
+        if (auto it = job.find(block); it != job.end()) {
+            settings[block].merge_patch(*it);
+        }
+    }
+
+    SceneFileParser parser(settings, scenePath);
+    Film film = parser.parseFilm();
+    Camera camera = parser.parseCamera(film.getWidth() / static_cast<float>(film.getHeight()));
+    auto sampler = parser.parseSampler(job.value("spp", 0u), job.value("seed", -1ll));
+    Renderer renderer = parser.parseRenderer();
+
+    auto renderStart = Clock::now();
+    renderer.render(loadedScene->scene, camera, film, *sampler);
+    float renderTime = secondsSince(renderStart);
+
+    if (!film.saveToFile(outputPath)) {
+        return errorResponse("Failed to write \"" + outputPath + "\"");
+    }
+
+    return {
+        { "status", "ok" },
+        { "output", outputPath },
+        { "cached", wasCached },
+        { "loadTime", loadTime },
+        { "renderTime", renderTime },
+        { "totalTime", secondsSince(start) }
+    };
+}
+
+const RenderServer::LoadedScene* RenderServer::getScene(const std::filesystem::path& scenePath, bool& wasCached) {
+    std::string key = std::filesystem::absolute(scenePath).lexically_normal().string();
+    auto lastWriteTime = std::filesystem::last_write_time(scenePath);
+
+    // Scenes are reloaded if the scene file changed (referenced obj files are not checked)
+    auto it = scenes_.find(key);
+    wasCached = it != scenes_.end() && it->second->lastWriteTime == lastWriteTime;
+    if (wasCached) {
+        return it->second.get();
+    }
+
+    auto loadedScene = loadScene(scenePath);
+    if (!loadedScene) {
+        return nullptr;
+    }
+    loadedScene->lastWriteTime = lastWriteTime;
+
+    auto& entry = scenes_[key];
+    entry = std::move(loadedScene);
+    return entry.get();
+}
+
+std::unique_ptr<RenderServer::LoadedScene> RenderServer::loadScene(const std::filesystem::path& scenePath) const {
+    SceneFileParser parser(scenePath);
+    if (!parser.isValid()) {
+        return nullptr;
+    }
+
+    auto loadedScene = std::make_unique<LoadedScene>();
+    parser.parseScene(loadedScene->spheres, loadedScene->triangles, loadedScene->materials);
+    for (const auto& shape : loadedScene->spheres) {
+        loadedScene->scene.add(shape);
+    }
+    for (const auto& shape : loadedScene->triangles) {
+        loadedScene->scene.add(shape);
+    }
+    loadedScene->scene.compile();
+
+    loadedScene->settings = parser.getRoot();
+    loadedScene->settings.erase("scene");
+    return loadedScene;
+}
+
+} // namespace pt
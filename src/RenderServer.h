@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Scene.h"
+#include "Sphere.h"
+#include "Triangle.h"
+#include "Material.h"
+
+#include <json.hpp>
+
+#include <filesystem>
+#include <istream>
+#include <ostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pt {
+
+// Long-lived render process that keeps compiled scenes (parsed shapes and the
+// BVH) in memory. Jobs are read as one JSON object per line, e.g.
+//   { "scene": "cornell.json", "output": "a.png", "spp": 64, "camera": { "fovY": 40 } }
+// The "film", "camera", "sampler" and "renderer" blocks of a job are merged into
+// the ones of the scene file. Other commands: "load", "unload", "list" and "quit".
+// Every job is answered with one JSON line containing at least a "status".
+class RenderServer {
+public:
+    void run(std::istream& input, std::ostream& output);
+    nlohmann::json processJob(const nlohmann::json& job);
+
+private:
+    struct LoadedScene {
+        nlohmann::json settings; // Everything except the "scene" block
+        std::filesystem::file_time_type lastWriteTime;
+        std::vector<Sphere> spheres;
+        std::vector<Triangle> triangles;
+        std::vector<Material> materials;
+        Scene scene;
+    };
+
+    nlohmann::json render(const nlohmann::json& job);
+    const LoadedScene* getScene(const std::filesystem::path& scenePath, bool& wasCached);
+    std::unique_ptr<LoadedScene> loadScene(const std::filesystem::path& scenePath) const;
+
+    std::unordered_map<std::string, std::unique_ptr<LoadedScene>> scenes_;
+};
+
+} // namespace pt
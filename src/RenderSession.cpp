@@ -0,0 +1,119 @@
+#include "RenderSession.h"
+#include "MathUtils.h"
+
+#include <cassert>
+
+namespace {
+
+bool isEmissive(const pt::Material& material) {
+    return pt::maxComponent(material.getEmittance()) > 0.0f;
+}
+
+} // namespace
+
+namespace pt {
+
+RenderSession::RenderSession(std::vector<Sphere>&& spheres, std::vector<Triangle>&& triangles,
+        std::vector<Material>&& materials, const Camera& camera, const Film& film,
+        std::unique_ptr<Sampler> sampler, Renderer&& renderer)
+    : materials_(std::move(materials))
+    , spheres_(std::move(spheres))
+    , triangles_(std::move(triangles))
+    , camera_(camera)
+    , film_(film)
+    , sampler_(std::move(sampler))
+    , renderer_(std::move(renderer))
+{
+    buildScene();
+    restartAccumulation();
+}
+
+void RenderSession::setCamera(const Camera& camera) {
+    camera_ = camera;
+    isAccumulationDirty_ = true;
+}
+
+void RenderSession::setMaterial(size_t index, const Material& material) {
+    assert(index < materials_.size());
+    areLightsDirty_ |= isEmissive(materials_[index]) || isEmissive(material);
+    materials_[index] = material;
+    isAccumulationDirty_ = true;
+}
+
+Renderer& RenderSession::editRenderer() {
+    isAccumulationDirty_ = true;
+    return renderer_;
+}
+
+void RenderSession::setSampler(std::unique_ptr<Sampler> sampler) {
+    sampler_ = std::move(sampler);
+    isAccumulationDirty_ = true;
+}
+
+std::vector<Sphere>& RenderSession::editSpheres() {
+    isGeometryDirty_ = true;
+    return spheres_;
+}
+
+std::vector<Triangle>& RenderSession::editTriangles() {
+    isGeometryDirty_ = true;
+    return triangles_;
+}
+
+void RenderSession::setMaxSamplesPerPass(uint32_t numSamples) {
+    maxSamplesPerPass_ = max(numSamples, 1u);
+}
+
+bool RenderSession::renderPass() {
+    if (isGeometryDirty_) {
+        buildScene();
+        restartAccumulation();
+    }
+    else if (areLightsDirty_) {
+        // The emission of a material can turn shapes into lights or back
+        scene_->updateLights();
+        areLightsDirty_ = false;
+        restartAccumulation();
+    }
+    else if (isAccumulationDirty_) {
+        restartAccumulation();
+    }
+
+    if (isComplete()) {
+        return false;
+    }
+
+    renderer_.renderProgressivePass(*scene_, camera_, film_, *sampler_, samplesPerPass_);
+    samplesPerPass_ = min(samplesPerPass_ * 2, maxSamplesPerPass_);
+    numPasses_++;
+    return true;
+}
+
+bool RenderSession::isComplete() const {
+    return !isGeometryDirty_ && !areLightsDirty_ && !isAccumulationDirty_ &&
+        film_.getTotalSamples() >= film_.getCropWindowArea() * sampler_->getSamplesPerPixel();
+}
+
+void RenderSession::restartAccumulation() {
+    film_.clearTile({ 0, 0, film_.getWidth() - 1, film_.getHeight() - 1 });
+    samplesPerPass_ = 1;
+    numPasses_ = 0;
+    isAccumulationDirty_ = false;
+}
+
+void RenderSession::buildScene() {
+    scene_ = std::make_unique<Scene>();
+    for (const Sphere& sphere : spheres_) {
+        scene_->add(sphere);
+    }
+    for (const Triangle& triangle : triangles_) {
+        scene_->add(triangle);
+    }
+    scene_->compile();
+
+    numSceneBuilds_++;
+    isGeometryDirty_ = false;
+    areLightsDirty_ = false;
+}
+
+} // namespace pt
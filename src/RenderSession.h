@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Camera.h"
+#include "Film.h"
+#include "Material.h"
+#include "Renderer.h"
+#include "Sampler.h"
+#include "Scene.h"
+#include "Sphere.h"
+#include "Triangle.h"
+
+#include <memory>
+#include <vector>
+
+namespace pt {
+
+// Keeps a scene, its BVH and the accumulated film between renders for
+// interactive edits. Changes are only recorded by the setters and applied
+// before the next pass: camera, material and renderer edits restart the
+// accumulation but reuse the geometry and the BVH, only geometry edits
+// rebuild the scene.
+class RenderSession {
+public:
+    // The shapes have to reference the given materials. The vectors are moved
+    // into the session, which keeps the elements (and the references) in place.
+    RenderSession(std::vector<Sphere>&& spheres, std::vector<Triangle>&& triangles,
+        std::vector<Material>&& materials, const Camera& camera, const Film& film,
+        std::unique_ptr<Sampler> sampler, Renderer&& renderer);
+
+    RenderSession(const RenderSession&) = delete;
+    RenderSession& operator=(const RenderSession&) = delete;
+
+    void setCamera(const Camera& camera);
+
+    size_t getNumMaterials() const { return materials_.size(); }
+    const Material& getMaterial(size_t index) const { return materials_[index]; }
+    // Replaces the material in place, so the shapes using it see the change
+    void setMaterial(size_t index, const Material& material);
+
+    // Settings like the max depth change the image, the tile callback doesn't
+    Renderer& editRenderer();
+    void setSampler(std::unique_ptr<Sampler> sampler);
+
+    // The shapes may be changed, added or removed (with materials of the session)
+    // until the next pass, which rebuilds the BVH
+    std::vector<Sphere>& editSpheres();
+    std::vector<Triangle>& editTriangles();
+
+    // Renders the next progressive pass after applying the pending edits. The
+    // first pass after a restart takes a single sample per pixel to show the
+    // change as soon as possible, later passes double up to the max samples per
+    // pass. Returns false without rendering once the film has all samples.
+    bool renderPass();
+    bool isComplete() const;
+    void setMaxSamplesPerPass(uint32_t numSamples);
+
+    const Film& getFilm() const { return film_; }
+    const Scene& getScene() const { return *scene_; }
+    uint32_t getNumPasses() const { return numPasses_; }
+    uint32_t getNumSceneBuilds() const { return numSceneBuilds_; }
+
+private:
+    void restartAccumulation();
+    void buildScene();
+
+    std::vector<Material> materials_;
+    std::vector<Sphere> spheres_;
+    std::vector<Triangle> triangles_;
+    std::unique_ptr<Scene> scene_;
+    Camera camera_;
+    Film film_;
+    std::unique_ptr<Sampler> sampler_;
+    Renderer renderer_;
+
+    bool isGeometryDirty_ = true;
+    bool areLightsDirty_ = false;
+    bool isAccumulationDirty_ = false;
+    uint32_t maxSamplesPerPass_ = 16;
+    uint32_t samplesPerPass_ = 1;
+    uint32_t numPasses_ = 0; // Since the last restart
+    uint32_t numSceneBuilds_ = 0;
+};
+
+} // namespace pt
@@ -8,10 +8,26 @@
 #include "BSDF.h"
 #include "ProgressBar.h"
 #include "Sampler.h"
-#include "HashUtils.h"
+#include "BufferedSampler.h"
+#include "PathPool.h"
+
+#include <algorithm>
+#include <utility>
+#include <mutex>
+#include <condition_variable>
+#include <queue>
 
 namespace {
 
+// Samples of a pixel that are generated together, the buffer of a batch stays in the cache
+constexpr uint32_t maxBatchSamples = 64;
+
+// Paths of a wavefront, the samples of larger tiles are traced in several waves
+constexpr uint32_t maxWavefrontPaths = 8192;
+
+// Materials below this roughness aren't guided
+constexpr float minGuidedRoughness = 0.2f;
+
 float powerHeuristic(int nf, float pdfF, int ng, float pdfG) {
     float f = nf * pdfF;
     float g = ng * pdfG;
@@ -19,21 +35,149 @@ float powerHeuristic(int nf, float pdfF, int ng, float pdfG) {
     return f2 / (f2 + g * g);
 }
 
+// The sample of light candidate i out of n, the candidates of a shading point
+// form a lattice that is shifted by the sample of the bounce (R2 sequence in 2D)
+float getCandidateSample(float u, uint32_t i, uint32_t n) {
+    float v = u + static_cast<float>(i) / static_cast<float>(n);
+    return pt::min(v < 1.0f ? v : v - 1.0f, pt::oneMinusEpsilon<float>);
+}
+
+pt::Vec2 getCandidateSample(const pt::Vec2& u, uint32_t i) {
+    float x = u.x + static_cast<float>(i) * 0.7548776662f;
+    float y = u.y + static_cast<float>(i) * 0.5698402910f;
+    return pt::Vec2(pt::min(x - std::floor(x), pt::oneMinusEpsilon<float>),
+        pt::min(y - std::floor(y), pt::oneMinusEpsilon<float>));
+}
+
 } // namespace
 
 namespace pt {
 
+struct Renderer::TileQueue {
+    std::mutex mutex;
+    std::condition_variable tileReturned;
+    std::priority_queue<std::pair<float, size_t>> tiles; // (priority, tile index)
+    uint32_t numRenderingTiles = 0; // Tiles out of the queue that may come back
+    uint64_t remainingSamples;
+    uint32_t stepSamples;
+    uint32_t maxSamples;
+};
+
 void Renderer::render(const Scene& scene, const Camera& camera, Film& film, Sampler& sampler) {
     auto filmTiles = film.getTiles(tileWidth_, tileHeight_);
+    uint32_t samplesPerPixel = sampler.getSamplesPerPixel();
+    renderStartTime_ = std::chrono::steady_clock::now();
+
+    if (previewCallback_ && film.getTotalSamples() == 0) {
+        renderPreviewPasses(scene, camera, film, sampler);
+    }
+
+    uint64_t sampleBudget = film.getCropWindowArea() * samplesPerPixel;
+    ProgressBar progressBar(sampleBudget, "Rendering", showProgress_);
+    progressBar.update(min(film.getTotalSamples(), sampleBudget));
+    if (pathGuiding_) {
+        guidingField_ = std::make_unique<GuidingField>(scene.getBounds());
+        renderGuidingPasses(scene, camera, film, sampler, filmTiles, progressBar);
+    }
+
+    // The schedules continue at the sample counts of the guiding passes
+    if (tileScheduling_ == TileScheduling::NoiseAware) {
+        renderNoiseAware(scene, camera, film, sampler, filmTiles, progressBar);
+    }
+    else if (adaptiveThreshold_ > 0.0f) {
+        renderAdaptive(scene, camera, film, sampler, filmTiles, progressBar);
+    }
+    else {
+        RenderPass pass;
+        pass.numSamples = samplesPerPixel;
+        pass.maxSamplesPerPixel = samplesPerPixel;
+        renderPass(scene, camera, film, sampler, filmTiles, pass, progressBar);
+    }
+    guidingField_.reset();
+}
+
+void Renderer::renderTiles(const Scene& scene, const Camera& camera, Film& film, Sampler& sampler,
+        const std::vector<Film::Tile>& tiles, uint32_t firstSample, uint32_t numSamples) {
+    renderStartTime_ = std::chrono::steady_clock::now();
+
+    uint64_t totalWork = 0;
+    for (const auto& tile : tiles) {
+        totalWork += static_cast<uint64_t>(tile.endX - tile.startX + 1) * (tile.endY - tile.startY + 1) * numSamples;
+    }
+
+    ProgressBar progressBar(totalWork, "Rendering", showProgress_);
+    RenderPass pass;
+    pass.numSamples = numSamples;
+    pass.maxSamplesPerPixel = numSamples;
+    pass.sampleOffset = firstSample;
+    renderPass(scene, camera, film, sampler, tiles, pass, progressBar);
+}
+
+uint64_t Renderer::renderProgressivePass(const Scene& scene, const Camera& camera, Film& film, Sampler& sampler,
+        uint32_t numSamples) {
+    auto filmTiles = film.getTiles(tileWidth_, tileHeight_);
+    uint32_t samplesPerPixel = sampler.getSamplesPerPixel();
+    renderStartTime_ = std::chrono::steady_clock::now();
+
+    uint64_t sampleBudget = film.getCropWindowArea() * samplesPerPixel;
+    uint64_t remainingSamples = sampleBudget - min(film.getTotalSamples(), sampleBudget);
+    ProgressBar progressBar(min(remainingSamples, film.getCropWindowArea() * numSamples), "Rendering", showProgress_);
+    RenderPass pass;
+    pass.numSamples = numSamples;
+    pass.maxSamplesPerPixel = samplesPerPixel;
+    return renderPass(scene, camera, film, sampler, filmTiles, pass, progressBar);
+}
+
+void Renderer::renderOutOfCore(const Scene& scene, const Camera& camera, const Film& film, Sampler& sampler,
+        const TileCallback& tileFinished) {
+    auto filmTiles = film.getTiles(tileWidth_, tileHeight_);
+    uint32_t samplesPerPixel = sampler.getSamplesPerPixel();
+    renderStartTime_ = std::chrono::steady_clock::now();
+
+    ProgressBar progressBar(film.getCropWindowArea() * samplesPerPixel, "Rendering", showProgress_);
+    RenderPass pass;
+    pass.numSamples = samplesPerPixel;
+    pass.maxSamplesPerPixel = samplesPerPixel;
+    std::atomic<size_t> nextTileIndex = 0;
+    uint32_t numThreads = getNumThreads();
+    workerThreads_.reserve(numThreads);
+
+    for (uint32_t i = 0; i < numThreads; i++) {
+        workerThreads_.emplace_back([&] {
+            auto localSampler = sampler.clone();
+
+            while (!isTimeLimitExceeded()) {
+                size_t tileIndex = nextTileIndex.fetch_add(1, std::memory_order_relaxed);
+                if (tileIndex >= filmTiles.size()) {
+                    break;
+                }
+
+                const Film::Tile& tile = filmTiles[tileIndex];
+                Film tileFilm(film.getWidth(), film.getHeight(), tile);
+                uint64_t numTileSamples = renderTile(scene, camera, tileFilm, *localSampler, pass, tile);
+                tileFinished(tileFilm, tile);
+                progressBar.update(numTileSamples);
+            }
+        });
+    }
+
+    for (std::thread& thread : workerThreads_) {
+        thread.join();
+    }
+    workerThreads_.clear();
+}
+
+uint64_t Renderer::renderPass(const Scene& scene, const Camera& camera, Film& film, Sampler& sampler,
+        const std::vector<Film::Tile>& filmTiles, const RenderPass& pass, ProgressBar& progressBar) {
     std::atomic<size_t> nextTileIndex = 0;
-    uint32_t numThreads = max(1u, std::thread::hardware_concurrency());
+    std::atomic<uint64_t> numSamplesRendered = 0;
+    uint32_t numThreads = getNumThreads();
     workerThreads_.reserve(numThreads);
 
-    ProgressBar progressBar(filmTiles.size(), "Rendering");
     for (uint32_t i = 0; i < numThreads; i++) {
         workerThreads_.emplace_back([&] {
-            workerThreadMain(i, scene, camera, film, sampler,
-                filmTiles, nextTileIndex, progressBar);
+            workerThreadMain(scene, camera, film, sampler, pass,
+                filmTiles, nextTileIndex, numSamplesRendered, progressBar);
         });
     }
 
@@ -41,49 +185,781 @@ void Renderer::render(const Scene& scene, const Camera& camera, Film& film, Samp
         thread.join();
     }
     workerThreads_.clear();
+
+    return numSamplesRendered;
 }
 
-void Renderer::workerThreadMain(uint32_t id, const Scene& scene,
-        const Camera& camera, Film& film, Sampler& sampler,
-        std::vector<Film::Tile>& filmTiles, std::atomic<size_t>& nextTileIndex,
-        ProgressBar& progressBar) {
-    auto localSampler = sampler.clone(hash(static_cast<uint64_t>(id) + 1));
+void Renderer::renderPreviewPasses(const Scene& scene, const Camera& camera, const Film& film, Sampler& sampler) {
+    const Film::Tile& window = film.getCropWindow();
+    for (uint32_t scale : { 8u, 4u, 2u }) {
+        // Rays are generated from coordinates normalized by (size - 1), which
+        // needs at least two pixels per axis
+        uint32_t width = max((film.getWidth() + scale - 1) / scale, 2u);
+        uint32_t height = max((film.getHeight() + scale - 1) / scale, 2u);
+        if (width >= film.getWidth() || height >= film.getHeight()) {
+            continue;
+        }
+
+        // The crop window rounded outwards to the pixels of the preview
+        auto toPreview = [](uint32_t x, uint32_t size, uint32_t previewSize, bool roundUp) {
+            uint64_t scaled = static_cast<uint64_t>(x) * (previewSize - 1) + (roundUp ? size - 2 : 0);
+            return static_cast<uint32_t>(scaled / (size - 1));
+        };
+        Film previewFilm(width, height);
+        previewFilm.setCropWindow({
+            toPreview(window.startX, film.getWidth(), width, false),
+            toPreview(window.startY, film.getHeight(), height, false),
+            toPreview(window.endX, film.getWidth(), width, true),
+            toPreview(window.endY, film.getHeight(), height, true) });
 
-    while (true) {
+        ProgressBar progressBar(previewFilm.getCropWindowArea(), "Preview", false);
+        RenderPass pass;
+        pass.numSamples = 1;
+        pass.maxSamplesPerPixel = 1;
+        pass.isPreview = true;
+        renderPass(scene, camera, previewFilm, sampler, previewFilm.getTiles(tileWidth_, tileHeight_),
+            pass, progressBar);
+        previewCallback_(previewFilm);
+
+        if (isTimeLimitExceeded()) {
+            break;
+        }
+    }
+}
+
+void Renderer::renderGuidingPasses(const Scene& scene, const Camera& camera, Film& film, Sampler& sampler,
+        const std::vector<Film::Tile>& filmTiles, ProgressBar& progressBar) {
+    // The samples of the guiding passes stay in the film, they are unbiased with
+    // any guide. A pass learns from twice the samples of the previous one.
+    uint32_t samplesPerPixel = sampler.getSamplesPerPixel();
+    uint32_t endSample = 0;
+    for (uint32_t numSamples = 1; endSample + numSamples <= samplesPerPixel / 2; numSamples *= 2) {
+        if (isTimeLimitExceeded()) {
+            break;
+        }
+
+        endSample += numSamples;
+        RenderPass pass;
+        pass.numSamples = numSamples;
+        pass.maxSamplesPerPixel = endSample;
+        pass.trainGuiding = true;
+        renderPass(scene, camera, film, sampler, filmTiles, pass, progressBar);
+        guidingField_->update();
+    }
+}
+
+void Renderer::renderAdaptive(const Scene& scene, const Camera& camera, Film& film, Sampler& sampler,
+        const std::vector<Film::Tile>& filmTiles, ProgressBar& progressBar) {
+    uint32_t minSamples, maxSamples, stepSamples;
+    computeAdaptiveSampleCounts(sampler.getSamplesPerPixel(), minSamples, maxSamples, stepSamples);
+    const uint32_t width = film.getWidth();
+    const size_t numPixels = static_cast<size_t>(width) * film.getHeight();
+    const uint64_t sampleBudget = film.getCropWindowArea() * sampler.getSamplesPerPixel();
+    const Film::Tile& window = film.getCropWindow();
+
+    // Initial pass over all pixels to get a first variance estimate
+    RenderPass pass;
+    pass.numSamples = minSamples;
+    pass.maxSamplesPerPixel = minSamples;
+    renderPass(scene, camera, film, sampler, filmTiles, pass, progressBar);
+    uint64_t numSamplesUsed = film.getTotalSamples(); // Includes samples of a resumed render
+
+    std::vector<bool> activePixels(numPixels);
+    std::vector<std::pair<float, size_t>> candidates;
+    candidates.reserve(film.getCropWindowArea());
+
+    while (numSamplesUsed < sampleBudget && !isTimeLimitExceeded()) {
+        candidates.clear();
+        for (uint32_t y = window.startY; y <= window.endY; y++) {
+            for (uint32_t x = window.startX; x <= window.endX; x++) {
+                float error = film.getRelativeError(x, y);
+                if (error > adaptiveThreshold_ && film.getNumSamples(x, y) < maxSamples) {
+                    candidates.emplace_back(error, x + static_cast<size_t>(y) * width);
+                }
+            }
+        }
+        if (candidates.empty()) {
+            break;
+        }
+
+        // Only the noisiest pixels get samples if the remaining budget is too small
+        size_t numAffordable = max<uint64_t>(1, (sampleBudget - numSamplesUsed) / stepSamples);
+        if (candidates.size() > numAffordable) {
+            std::nth_element(candidates.begin(), candidates.begin() + numAffordable, candidates.end(),
+                [](const auto& a, const auto& b) { return a.first > b.first; });
+            candidates.resize(numAffordable);
+        }
+
+        std::fill(activePixels.begin(), activePixels.end(), false);
+        for (const auto& candidate : candidates) {
+            activePixels[candidate.second] = true;
+        }
+
+        pass.numSamples = stepSamples;
+        pass.maxSamplesPerPixel = maxSamples;
+        pass.activePixels = &activePixels;
+        numSamplesUsed += renderPass(scene, camera, film, sampler, filmTiles, pass, progressBar);
+    }
+}
+
+void Renderer::renderNoiseAware(const Scene& scene, const Camera& camera, Film& film, Sampler& sampler,
+        const std::vector<Film::Tile>& filmTiles, ProgressBar& progressBar) {
+    uint32_t minSamples, maxSamples, stepSamples;
+    computeAdaptiveSampleCounts(sampler.getSamplesPerPixel(), minSamples, maxSamples, stepSamples);
+    const uint64_t sampleBudget = film.getCropWindowArea() * sampler.getSamplesPerPixel();
+
+    // Cheap first pass over the whole frame for the initial error estimates
+    RenderPass pass;
+    pass.numSamples = minSamples;
+    pass.maxSamplesPerPixel = minSamples;
+    renderPass(scene, camera, film, sampler, filmTiles, pass, progressBar);
+    uint64_t numSamplesUsed = film.getTotalSamples(); // Includes samples of a resumed render
+
+    TileQueue tileQueue;
+    tileQueue.remainingSamples = sampleBudget - min(numSamplesUsed, sampleBudget);
+    tileQueue.stepSamples = stepSamples;
+    tileQueue.maxSamples = maxSamples;
+    for (size_t tileIndex = 0; tileIndex < filmTiles.size(); tileIndex++) {
+        float priority = computeTilePriority(film, filmTiles[tileIndex], stepSamples, maxSamples);
+        if (priority > 0.0f) {
+            tileQueue.tiles.emplace(priority, tileIndex);
+        }
+    }
+
+    pass.numSamples = stepSamples;
+    pass.maxSamplesPerPixel = maxSamples;
+    pass.skipConvergedPixels = adaptiveThreshold_ > 0.0f;
+    uint32_t numThreads = getNumThreads();
+    workerThreads_.reserve(numThreads);
+
+    for (uint32_t i = 0; i < numThreads; i++) {
+        workerThreads_.emplace_back([&] {
+            tileQueueWorkerMain(scene, camera, film, sampler, pass,
+                filmTiles, tileQueue, progressBar);
+        });
+    }
+
+    for (std::thread& thread : workerThreads_) {
+        thread.join();
+    }
+    workerThreads_.clear();
+}
+
+void Renderer::workerThreadMain(const Scene& scene,
+        const Camera& camera, Film& film, Sampler& sampler, const RenderPass& pass,
+        const std::vector<Film::Tile>& filmTiles, std::atomic<size_t>& nextTileIndex,
+        std::atomic<uint64_t>& numSamplesRendered, ProgressBar& progressBar) {
+    auto localSampler = sampler.clone();
+
+    while (!isTimeLimitExceeded()) {
         size_t tileIndex = nextTileIndex.fetch_add(1, std::memory_order_relaxed);
         if (tileIndex >= filmTiles.size()) {
             break;
         }
-        Film::Tile tile = filmTiles[tileIndex];
 
-        for (uint32_t y = tile.startY; y <= tile.endY; y++) {
-            for (uint32_t x = tile.startX; x <= tile.endX; x++) {
-                localSampler->startPixel(x + y * film.getWidth());
+        const Film::Tile& tile = filmTiles[tileIndex];
+        uint64_t numTileSamples = renderTile(scene, camera, film, *localSampler, pass, tile);
+        if (numTileSamples > 0 && tileCallback_ && !pass.isPreview) {
+            tileCallback_(film, tile);
+        }
+        numSamplesRendered += numTileSamples;
+        progressBar.update(numTileSamples);
+    }
+}
+
+void Renderer::tileQueueWorkerMain(const Scene& scene,
+        const Camera& camera, Film& film, Sampler& sampler, const RenderPass& pass,
+        const std::vector<Film::Tile>& filmTiles, TileQueue& tileQueue, ProgressBar& progressBar) {
+    auto localSampler = sampler.clone();
+
+    while (!isTimeLimitExceeded()) {
+        size_t tileIndex;
+        {
+            // An empty queue only ends the work once no other worker can
+            // return a tile to it
+            std::unique_lock<std::mutex> lock(tileQueue.mutex);
+            tileQueue.tileReturned.wait(lock, [&] {
+                return !tileQueue.tiles.empty() || tileQueue.numRenderingTiles == 0
+                    || tileQueue.remainingSamples == 0;
+            });
+            if (tileQueue.tiles.empty() || tileQueue.remainingSamples == 0) {
+                break;
+            }
 
-                for (uint32_t s = 0; s < localSampler->getSamplesPerPixel(); s++) {
-                    Vec2 pixelOffset = localSampler->get2D();
+            // The tile is out of the queue while it's rendered, so no other
+            // worker can touch its pixels at the same time
+            tileIndex = tileQueue.tiles.top().second;
+            tileQueue.tiles.pop();
+            tileQueue.numRenderingTiles++;
+        }
+
+        const Film::Tile& tile = filmTiles[tileIndex];
+        uint64_t numTileSamples = renderTile(scene, camera, film, *localSampler, pass, tile);
+        float priority = computeTilePriority(film, tile, tileQueue.stepSamples, tileQueue.maxSamples);
+        if (numTileSamples > 0 && tileCallback_) {
+            tileCallback_(film, tile);
+        }
+        progressBar.update(numTileSamples);
+
+        {
+            std::lock_guard<std::mutex> lock(tileQueue.mutex);
+            tileQueue.remainingSamples -= min(numTileSamples, tileQueue.remainingSamples);
+            tileQueue.numRenderingTiles--;
+            if (numTileSamples > 0 && priority > 0.0f) {
+                tileQueue.tiles.emplace(priority, tileIndex);
+            }
+        }
+        tileQueue.tileReturned.notify_all();
+    }
+}
+
+uint64_t Renderer::renderTile(const Scene& scene, const Camera& camera, Film& film,
+        Sampler& sampler, const RenderPass& pass, const Film::Tile& tile) const {
+    if (integrator_ == Integrator::Wavefront) {
+        return renderTileWavefront(scene, camera, film, sampler, pass, tile);
+    }
+
+    SampleLayout layout = getSampleLayout();
+    BufferedSampler<Sampler> bufferedSampler(sampler, layout);
+    std::vector<GuidingVertex> guidingVertices(pass.trainGuiding ? maxDepth_ + 1 : 0);
+    uint64_t numTileSamples = 0;
+
+    for (uint32_t y = tile.startY; y <= tile.endY; y++) {
+        for (uint32_t x = tile.startX; x <= tile.endX; x++) {
+            uint32_t pixelIndex = x + y * film.getWidth();
+            if (pass.activePixels && !(*pass.activePixels)[pixelIndex]) {
+                continue;
+            }
+            if (pass.skipConvergedPixels && film.getRelativeError(x, y) <= adaptiveThreshold_) {
+                continue;
+            }
+
+            uint32_t firstSample = film.getNumSamples(x, y);
+            uint32_t endSample = min(firstSample + pass.numSamples, pass.maxSamplesPerPixel);
+            if (firstSample >= endSample) {
+                continue;
+            }
+
+            bufferedSampler.startPixel(pixelIndex);
+            for (uint32_t batchStart = firstSample; batchStart < endSample; batchStart += maxBatchSamples) {
+                uint32_t batchEnd = min(batchStart + maxBatchSamples, endSample);
+                bufferedSampler.startSamples(pass.sampleOffset + batchStart, batchEnd - batchStart);
+
+                for (uint32_t s = batchStart; s < batchEnd; s++) {
+                    Vec2 pixelOffset = bufferedSampler.get2D();
                     float u = (x + pixelOffset.x) / static_cast<float>(film.getWidth() - 1);
                     float v = (y + pixelOffset.y) / static_cast<float>(film.getHeight() - 1);
 
-                    Vec2 filmOffset = localSampler->get2D();
+                    Vec2 filmOffset = bufferedSampler.get2D();
                     Ray ray = camera.generateRay(u, v, filmOffset.x, filmOffset.y);
-                    Vec3 color = radiance(scene, *localSampler, ray);
+                    Vec3 color = radiance(scene, bufferedSampler, ray,
+                        pass.trainGuiding ? guidingVertices.data() : nullptr);
                     assert(isFinite(color) && color.r >= 0.0f && color.g >= 0.0f && color.b >= 0.0f);
                     film.addSample(x, y, color);
 
-                    localSampler->startNextSample();
+                    bufferedSampler.startNextSample();
+                }
+            }
+            numTileSamples += endSample - firstSample;
+        }
+    }
+
+    return numTileSamples;
+}
+
+uint64_t Renderer::renderTileWavefront(const Scene& scene, const Camera& camera, Film& film,
+        Sampler& sampler, const RenderPass& pass, const Film::Tile& tile) const {
+    // The pixels and samples of the tile like in renderTile()
+    std::vector<PixelSpan> spans;
+    uint64_t numTileSamples = 0;
+    for (uint32_t y = tile.startY; y <= tile.endY; y++) {
+        for (uint32_t x = tile.startX; x <= tile.endX; x++) {
+            uint32_t pixelIndex = x + y * film.getWidth();
+            if (pass.activePixels && !(*pass.activePixels)[pixelIndex]) {
+                continue;
+            }
+            if (pass.skipConvergedPixels && film.getRelativeError(x, y) <= adaptiveThreshold_) {
+                continue;
+            }
+
+            uint32_t firstSample = film.getNumSamples(x, y);
+            uint32_t endSample = min(firstSample + pass.numSamples, pass.maxSamplesPerPixel);
+            if (firstSample >= endSample) {
+                continue;
+            }
+
+            spans.push_back({ x, y, pixelIndex, pass.sampleOffset + firstSample, endSample - firstSample, 0 });
+            numTileSamples += endSample - firstSample;
+        }
+    }
+    if (spans.empty()) {
+        return 0;
+    }
+
+    SampleLayout layout = getSampleLayout();
+    PathPool pool(static_cast<uint32_t>(min(numTileSamples, uint64_t(maxWavefrontPaths))), layout.getNumFloats());
+    if (pass.trainGuiding) {
+        pool.maxGuidingVertices = maxDepth_ + 1;
+        pool.guidingVertices.resize(static_cast<size_t>(pool.capacity) * pool.maxGuidingVertices);
+        pool.numGuidingVertices.resize(pool.capacity);
+    }
+
+    // Every wave takes the next spans until the pool is full, the last one is
+    // split if it doesn't fit. The film gets the samples of a pixel in order.
+    std::vector<PixelSpan> waveSpans;
+    size_t spanIndex = 0;
+    uint32_t spanSamplesDone = 0;
+    while (spanIndex < spans.size()) {
+        waveSpans.clear();
+        uint32_t numPaths = 0;
+        while (spanIndex < spans.size() && numPaths < pool.capacity) {
+            PixelSpan span = spans[spanIndex];
+            span.firstSample += spanSamplesDone;
+            span.numSamples = min(span.numSamples - spanSamplesDone, pool.capacity - numPaths);
+            span.firstPath = numPaths;
+            waveSpans.push_back(span);
+            numPaths += span.numSamples;
+
+            spanSamplesDone += span.numSamples;
+            if (spanSamplesDone == spans[spanIndex].numSamples) {
+                spanIndex++;
+                spanSamplesDone = 0;
+            }
+        }
+        renderWavefront(scene, camera, film, sampler, layout, waveSpans, pool);
+    }
+
+    return numTileSamples;
+}
+
+void Renderer::renderWavefront(const Scene& scene, const Camera& camera, Film& film, Sampler& sampler,
+        const SampleLayout& layout, const std::vector<PixelSpan>& spans, PathPool& pool) const {
+    const std::vector<uint32_t>& groupEnds = layout.getGroupEnds();
+    std::vector<uint32_t> pathSpans(pool.capacity);
+
+    // Generates the calls of a group of the layout for the active paths, in runs
+    // of consecutive samples of a pixel. Runs with small gaps are merged, as the
+    // setup of a run costs about as much as a few samples.
+    auto generateSamples = [&](uint32_t firstCall, uint32_t endCall) {
+        constexpr uint32_t maxGap = 1;
+        size_t i = 0;
+        while (i < pool.activePaths.size()) {
+            uint32_t runStart = pool.activePaths[i];
+            uint32_t runEnd = runStart + 1;
+            const PixelSpan& span = spans[pathSpans[runStart]];
+            for (i++; i < pool.activePaths.size(); i++) {
+                uint32_t path = pool.activePaths[i];
+                if (pathSpans[path] != pathSpans[runStart] || path > runEnd + maxGap) {
+                    break;
                 }
+                runEnd = path + 1;
             }
+
+            sampler.startPixel(span.pixelIndex);
+            sampler.generateSamples(layout, firstCall, endCall, span.firstSample + runStart - span.firstPath,
+                runEnd - runStart, &pool.samples[runStart], pool.capacity);
+        }
+    };
+
+    // Camera rays
+    pool.activePaths.clear();
+    for (uint32_t spanIndex = 0; spanIndex < spans.size(); spanIndex++) {
+        const PixelSpan& span = spans[spanIndex];
+        for (uint32_t path = span.firstPath; path < span.firstPath + span.numSamples; path++) {
+            pathSpans[path] = spanIndex;
+            pool.activePaths.push_back(path);
+        }
+    }
+    generateSamples(0, groupEnds[0]);
+
+    uint32_t pixelOffsetFloat = layout.getFloatOffset(0);
+    uint32_t lensFloat = layout.getFloatOffset(1);
+    for (const PixelSpan& span : spans) {
+        for (uint32_t path = span.firstPath; path < span.firstPath + span.numSamples; path++) {
+            float u = (span.x + pool.getSample(pixelOffsetFloat, path)) / static_cast<float>(film.getWidth() - 1);
+            float v = (span.y + pool.getSample(pixelOffsetFloat + 1, path)) / static_cast<float>(film.getHeight() - 1);
+            Ray ray = camera.generateRay(u, v, pool.getSample(lensFloat, path), pool.getSample(lensFloat + 1, path));
+            pool.rays.setRay(path, ray);
+            pool.throughputs.set(path, Vec3(1.0f));
+            pool.radiances.set(path, Vec3(0.0f));
+        }
+    }
+    std::fill(pool.numGuidingVertices.begin(), pool.numGuidingVertices.end(), 0);
+    scene.intersect(pool.rays, pool.activePaths);
+
+    for (uint32_t depth = 0; depth <= maxDepth_ && !pool.activePaths.empty(); depth++) {
+        generateSamples(groupEnds[depth], groupEnds[depth + 1]);
+        shadePaths(scene, layout, depth, pool);
+        traceShadowRays(scene, pool);
+        scene.intersect(pool.rays, pool.extendedPaths);
+        finishBounce(scene, layout, depth, pool);
+    }
+
+    for (const PixelSpan& span : spans) {
+        for (uint32_t path = span.firstPath; path < span.firstPath + span.numSamples; path++) {
+            Vec3 color = pool.radiances.get(path);
+            assert(isFinite(color) && color.r >= 0.0f && color.g >= 0.0f && color.b >= 0.0f);
+            film.addSample(span.x, span.y, color);
+            if (!pool.guidingVertices.empty()) {
+                recordGuidingVertices(&pool.guidingVertices[static_cast<size_t>(path) * pool.maxGuidingVertices],
+                    pool.numGuidingVertices[path], color);
+            }
+        }
+    }
+}
+
+// Expected reduction of the squared relative error per sample if every pixel of
+// the tile gets another stepSamples, i.e. err^2 * step / (n + step) / step.
+// Returns 0 if the tile can't take any more samples or has fully converged.
+float Renderer::computeTilePriority(const Film& film, const Film::Tile& tile,
+        uint32_t stepSamples, uint32_t maxSamples) const {
+    float errorReduction = 0.0f;
+    uint32_t numActivePixels = 0;
+
+    for (uint32_t y = tile.startY; y <= tile.endY; y++) {
+        for (uint32_t x = tile.startX; x <= tile.endX; x++) {
+            uint32_t numSamples = film.getNumSamples(x, y);
+            float error = film.getRelativeError(x, y);
+            if (numSamples >= maxSamples || (adaptiveThreshold_ > 0.0f && error <= adaptiveThreshold_)) {
+                continue;
+            }
+
+            error = min(error, 100.0f); // Pixels with too few samples for an estimate
+            errorReduction += error * error / static_cast<float>(numSamples + stepSamples);
+            numActivePixels++;
+        }
+    }
+
+    uint32_t numPixels = (tile.endX - tile.startX + 1) * (tile.endY - tile.startY + 1);
+    return numActivePixels > 0 ? errorReduction / numPixels : 0.0f;
+}
+
+void Renderer::computeAdaptiveSampleCounts(uint32_t samplesPerPixel,
+        uint32_t& minSamples, uint32_t& maxSamples, uint32_t& stepSamples) const {
+    minSamples = clamp(adaptiveMinSamples_ ? adaptiveMinSamples_ : samplesPerPixel / 8,
+        min(2u, samplesPerPixel), samplesPerPixel);
+    maxSamples = max(adaptiveMaxSamples_ ? adaptiveMaxSamples_ : 8 * samplesPerPixel, minSamples);
+    stepSamples = max(1u, minSamples / 2);
+}
+
+uint32_t Renderer::getNumThreads() const {
+    return numThreads_ > 0 ? numThreads_ : max(1u, std::thread::hardware_concurrency());
+}
+
+bool Renderer::isTimeLimitExceeded() const {
+    if (timeLimit_ <= 0.0f) {
+        return false;
+    }
+
+    std::chrono::duration<float> elapsed = std::chrono::steady_clock::now() - renderStartTime_;
+    return elapsed.count() >= timeLimit_;
+}
+
+// The camera samples followed by the samples of every bounce in radiance()
+SampleLayout Renderer::getSampleLayout() const {
+    SampleLayout layout;
+    layout.add2D(); // Pixel offset
+    layout.add2D(); // Lens
+    layout.endGroup();
+    for (uint32_t depth = 0; depth <= maxDepth_; depth++) {
+        layout.add1D(); // Light index
+        layout.add2D(); // Light
+        layout.add2D(); // BSDF
+        layout.add1D(); // Russian roulette
+        if (directLightCandidates_ > 1) {
+            layout.add1D(); // Light candidate selection
+        }
+        layout.endGroup();
+    }
+    return layout;
+}
+
+Renderer::DirectLightSample Renderer::sampleDirectLight(const Scene& scene, const RayHit& hit, const Vec3& p,
+        const OrthonormalBasis& basis, const Vec3& wo, const DirectionalQuadtree* guide,
+        float lightIndexSample, const Vec2& lightSample, float candidateSample) const {
+    // Resampled importance sampling of a single light source. Every candidate is
+    // a light sample, weighted by its unshadowed contribution over its PDF. One
+    // candidate is kept with a probability proportional to its weight and only
+    // that one gets a shadow ray. A single candidate is plain light sampling.
+    // The PDFs of the light samples include the probability of picking the light.
+    // See: Importance Resampling for Global Illumination (2005), Talbot et al.
+    const Material* material = hit.shape->material;
+    const Shape* light = nullptr;
+    Vec3 lightDir(0.0f);
+    Vec3 lightContribution(0.0f);
+    float lightPdf = 0.0f;
+    float lightTarget = 0.0f;
+    float weightSum = 0.0f;
+    for (uint32_t i = 0; i < directLightCandidates_; i++) {
+        float u = getCandidateSample(lightIndexSample, i, directLightCandidates_);
+        Vec2 candidateLightSample = getCandidateSample(lightSample, i);
+        float candidateProb;
+        const Shape* candidate = lightSampling_ == LightSampling::BVH
+            ? scene.sampleLight(p, hit.normal, u, candidateProb)
+            : scene.sampleLight(u, candidateProb);
+        if (!candidate || candidate == hit.shape) {
+            continue;
         }
 
-        progressBar.update();
+        float candidatePdf;
+        Vec3 candidateDir = candidate->sampleDirection(p,
+            candidateLightSample.x, candidateLightSample.y, &candidatePdf);
+        candidatePdf *= candidateProb;
+        Vec3 wi = basis.worldToLocal(candidateDir);
+        float cosThetaI = abs(cosTheta(wi));
+        if (cosThetaI <= 0.0f || candidatePdf <= 0.0f) {
+            continue;
+        }
+
+        Vec3 contribution = candidate->material->getEmittance() * material->evaluate(wi, wo) * cosThetaI;
+        float target = luminance(contribution);
+        if (target <= 0.0f) {
+            continue;
+        }
+
+        // Weighted reservoir sampling, the selection sample is reused for the next candidate
+        float weight = target / candidatePdf;
+        weightSum += weight;
+        float selectionProb = weight / weightSum;
+        if (candidateSample < selectionProb) {
+            candidateSample = min(candidateSample / selectionProb, oneMinusEpsilon<float>);
+            light = candidate;
+            lightDir = candidateDir;
+            lightContribution = contribution;
+            lightPdf = candidatePdf;
+            lightTarget = target;
+        }
+        else {
+            candidateSample = min((candidateSample - selectionProb) / (1.0f - selectionProb),
+                oneMinusEpsilon<float>);
+        }
+    }
+
+    // MIS light sampling, counting the candidates like separate light samples.
+    // The weights use the PDF of a single candidate on both sides, so they still
+    // add up to one.
+    DirectLightSample directLight;
+    if (!light) {
+        return directLight;
+    }
+    Vec3 wi = basis.worldToLocal(lightDir);
+    float bsdfPdf = getScatteringPdf(*material, guide, basis, wi, wo);
+    if (bsdfPdf <= 0.0f) {
+        return directLight;
+    }
+
+    float misWeight = powerHeuristic(directLightCandidates_, lightPdf, 1, bsdfPdf);
+    float resamplingWeight = weightSum / (static_cast<float>(directLightCandidates_) * lightTarget);
+    directLight.shadowRay = Ray(p + sign(cosTheta(wi)) * hit.normal * 0.001f, lightDir);
+    directLight.light = light;
+    directLight.contribution = lightContribution * misWeight * resamplingWeight;
+    return directLight;
+}
+
+float Renderer::computeBsdfMisWeight(const Scene& scene, const Vec3& p, const Vec3& n, const Ray& ray,
+        const Shape* light, float bsdfPdf) const {
+    float lightProb = lightSampling_ == LightSampling::BVH
+        ? scene.getLightProbability(p, n, light)
+        : scene.getLightProbability(light);
+    float lightPdf = lightProb * light->pdf(p, ray.direction);
+    return lightPdf > 0.0f ? powerHeuristic(1, bsdfPdf, directLightCandidates_, lightPdf) : 0.0f;
+}
+
+const DirectionalQuadtree* Renderer::getGuide(const Material& material, const Vec3& p) const {
+    // Guided directions would hardly ever hit the lobe of a near-specular BSDF
+    if (!guidingField_ || material.getRoughness() < minGuidedRoughness) {
+        return nullptr;
+    }
+    return guidingField_->getDistribution(p);
+}
+
+Vec3 Renderer::sampleScattering(const Material& material, const DirectionalQuadtree* guide,
+        const OrthonormalBasis& basis, const Vec3& wo, const Vec2& u, float& pdf) const {
+    if (!guide) {
+        return material.sampleDirection(wo, u.x, u.y, &pdf);
+    }
+
+    // One-sample MIS of both strategies, the first sample dimension picks one
+    Vec3 wi;
+    if (u.x < guidingBsdfFraction_) {
+        float u1 = min(u.x / guidingBsdfFraction_, oneMinusEpsilon<float>);
+        wi = material.sampleDirection(wo, u1, u.y);
+        if (wi.x == 0.0f && wi.y == 0.0f && wi.z == 0.0f) {
+            pdf = 0.0f;
+            return wi;
+        }
+    }
+    else {
+        float u1 = min((u.x - guidingBsdfFraction_) / (1.0f - guidingBsdfFraction_), oneMinusEpsilon<float>);
+        float guidePdf;
+        wi = basis.worldToLocal(guide->sample(u1, u.y, guidePdf));
     }
+    pdf = getScatteringPdf(material, guide, basis, wi, wo);
+    return wi;
 }
 
-Vec3 Renderer::radiance(const Scene& scene, Sampler& sampler, Ray ray) const {
+float Renderer::getScatteringPdf(const Material& material, const DirectionalQuadtree* guide,
+        const OrthonormalBasis& basis, const Vec3& wi, const Vec3& wo) const {
+    // Directions the BSDF can't sample end the path the same way with guiding
+    float bsdfPdf = material.pdf(wi, wo);
+    if (!guide || bsdfPdf <= 0.0f) {
+        return bsdfPdf;
+    }
+    return guidingBsdfFraction_ * bsdfPdf + (1.0f - guidingBsdfFraction_) * guide->pdf(basis.localToWorld(wi));
+}
+
+void Renderer::recordGuidingVertices(const GuidingVertex* vertices, uint32_t numVertices, const Vec3& radiance) const {
+    for (uint32_t i = 0; i < numVertices; i++) {
+        const GuidingVertex& vertex = vertices[i];
+        Vec3 incident = radiance - vertex.radiance;
+        for (int c = 0; c < 3; c++) {
+            incident[c] = vertex.throughput[c] > 0.0f ? max(incident[c], 0.0f) / vertex.throughput[c] : 0.0f;
+        }
+        guidingField_->record(vertex.point, vertex.direction, luminance(incident) / vertex.pdf);
+    }
+}
+
+// The part of a bounce of radiance() up to the BSDF sampling. Terminated paths
+// leave the queues, the others get a shadow ray and a ray for the BSDF sample.
+void Renderer::shadePaths(const Scene& scene, const SampleLayout& layout, uint32_t depth, PathPool& pool) const {
+    uint32_t firstCall = layout.getGroupEnds()[depth];
+    uint32_t lightIndexFloat = layout.getFloatOffset(firstCall);
+    uint32_t lightFloat = layout.getFloatOffset(firstCall + 1);
+    uint32_t bsdfFloat = layout.getFloatOffset(firstCall + 2);
+    uint32_t candidateFloat = directLightCandidates_ > 1 ? layout.getFloatOffset(firstCall + 4) : 0;
+
+    pool.shadowPaths.clear();
+    pool.extendedPaths.clear();
+    for (uint32_t path : pool.activePaths) {
+        Vec3 lambda = pool.throughputs.get(path);
+        RayHit hit = pool.rays.getHit(path);
+        if (hit.t < 0.0f) {
+            pool.radiances.set(path, pool.radiances.get(path) + lambda * backgroundColor_);
+            continue;
+        }
+        if (hit.shape->isLight() && depth == 0) {
+            pool.radiances.set(path, pool.radiances.get(path) + lambda * hit.shape->material->getEmittance());
+            continue;
+        }
+
+        const Material* material = hit.shape->material;
+        Ray ray = pool.rays.getRay(path);
+        Vec3 intersectionPoint = ray.at(hit.t);
+        Vec3 wo = normalize(-ray.direction);
+        OrthonormalBasis basis(hit.normal);
+        wo = basis.worldToLocal(wo);
+
+        float lightIndexSample = pool.getSample(lightIndexFloat, path);
+        Vec2 lightPositionSample(pool.getSample(lightFloat, path), pool.getSample(lightFloat + 1, path));
+        Vec2 bsdfSample(pool.getSample(bsdfFloat, path), pool.getSample(bsdfFloat + 1, path));
+        float candidateSample = directLightCandidates_ > 1 ? pool.getSample(candidateFloat, path) : 0.0f;
+
+        const DirectionalQuadtree* guide = getGuide(*material, intersectionPoint);
+        DirectLightSample lightSample = sampleDirectLight(scene, hit, intersectionPoint, basis, wo, guide,
+            lightIndexSample, lightPositionSample, candidateSample);
+        if (lightSample.light) {
+            pool.shadowRays.setRay(path, lightSample.shadowRay);
+            pool.shadowLights[path] = lightSample.light;
+            pool.shadowContributions.set(path, lambda * lightSample.contribution);
+            pool.shadowPaths.push_back(path);
+        }
+
+        float bsdfPdf;
+        Vec3 wi = sampleScattering(*material, guide, basis, wo, bsdfSample, bsdfPdf);
+        float cosThetaI = abs(cosTheta(wi));
+        if (cosThetaI <= 0.0f || bsdfPdf <= 0.0f) {
+            continue;
+        }
+        Vec3 bsdf = material->evaluate(wi, wo);
+        if (maxComponent(bsdf) <= 0.0f) {
+            continue;
+        }
+
+        pool.rays.setRay(path, Ray(intersectionPoint + sign(cosTheta(wi)) * hit.normal * 0.001f, basis.localToWorld(wi)));
+        pool.vertexPoints.set(path, intersectionPoint);
+        pool.vertexNormals.set(path, hit.normal);
+        pool.vertexShapes[path] = hit.shape;
+        pool.bsdfs.set(path, bsdf);
+        pool.cosThetas[path] = cosThetaI;
+        pool.bsdfPdfs[path] = bsdfPdf;
+        pool.extendedPaths.push_back(path);
+    }
+}
+
+void Renderer::traceShadowRays(const Scene& scene, PathPool& pool) const {
+    // The light has to be the closest hit, so nothing may be hit before it
+    size_t numShadowPaths = 0;
+    for (uint32_t path : pool.shadowPaths) {
+        float lightDistance = pool.shadowLights[path]->intersect(pool.shadowRays.getRay(path)).t;
+        if (lightDistance >= 0.0f) {
+            pool.shadowRays.tmax[path] = lightDistance;
+            pool.shadowPaths[numShadowPaths++] = path;
+        }
+    }
+    pool.shadowPaths.resize(numShadowPaths);
+
+    scene.intersectAny(pool.shadowRays, pool.shadowPaths);
+    for (uint32_t path : pool.shadowPaths) {
+        if (!pool.shadowRays.hitShapes[path]) {
+            pool.radiances.set(path, pool.radiances.get(path) + pool.shadowContributions.get(path));
+        }
+    }
+}
+
+// The rest of a bounce of radiance() with the hits of the BSDF samples, the
+// paths that survive the russian roulette are shaded at the next depth
+void Renderer::finishBounce(const Scene& scene, const SampleLayout& layout, uint32_t depth, PathPool& pool) const {
+    uint32_t rrFloat = layout.getFloatOffset(layout.getGroupEnds()[depth] + 3);
+
+    pool.activePaths.clear();
+    for (uint32_t path : pool.extendedPaths) {
+        Vec3 lambda = pool.throughputs.get(path);
+        Vec3 bsdf = pool.bsdfs.get(path);
+        float cosThetaI = pool.cosThetas[path];
+        float bsdfPdf = pool.bsdfPdfs[path];
+
+        Vec3 vertexColor = pool.radiances.get(path);
+        const Shape* lightShape = pool.rays.hitShapes[path];
+        if (lightShape && lightShape->isLight() && lightShape != pool.vertexShapes[path]) {
+            Ray lightRay = pool.rays.getRay(path);
+            float misWeight = computeBsdfMisWeight(scene, pool.vertexPoints.get(path), pool.vertexNormals.get(path),
+                lightRay, lightShape, bsdfPdf);
+            if (misWeight > 0.0f) {
+                Vec3 color = pool.radiances.get(path)
+                    + lambda * lightShape->material->getEmittance() * bsdf * cosThetaI * misWeight / bsdfPdf;
+                assert(isFinite(color) && color.r >= 0.0f && color.g >= 0.0f && color.b >= 0.0f);
+                pool.radiances.set(path, color);
+            }
+        }
+
+        lambda *= bsdf * cosThetaI / bsdfPdf;
+        assert(isFinite(lambda) && lambda.r >= 0.0f && lambda.g >= 0.0f && lambda.b >= 0.0f);
+        if (!pool.guidingVertices.empty()) {
+            size_t vertexIndex = static_cast<size_t>(path) * pool.maxGuidingVertices + pool.numGuidingVertices[path]++;
+            pool.guidingVertices[vertexIndex] = { pool.vertexPoints.get(path), pool.rays.directions.get(path),
+                bsdfPdf, vertexColor, lambda };
+        }
+
+        float rrProb = min(0.95f, max(lambda.r, max(lambda.g, lambda.b)));
+        assert(rrProb > 0.0f && std::isfinite(rrProb));
+        if (depth >= minRRDepth_) {
+            if (pool.getSample(rrFloat, path) > rrProb) {
+                continue;
+            }
+            lambda /= rrProb;
+        }
+
+        pool.throughputs.set(path, lambda);
+        pool.activePaths.push_back(path);
+    }
+}
+
+Vec3 Renderer::radiance(const Scene& scene, BufferedSampler<Sampler>& sampler, Ray ray,
+        GuidingVertex* guidingVertices) const {
     Vec3 lambda(1.0f);
     Vec3 color(0.0f);
     RayHit hit = scene.intersect(ray);
+    uint32_t numGuidingVertices = 0;
 
     for (uint32_t depth = 0; depth <= maxDepth_; depth++) {
         if (hit.t < 0.0f) {
@@ -103,53 +979,40 @@ Vec3 Renderer::radiance(const Scene& scene, Sampler& sampler, Ray ray) const {
 
         // Request samples upfront to ensure exact same order every iteration
         float lightIndexSample = sampler.get1D();
-        Vec2 lightSample = sampler.get2D();
+        Vec2 lightPositionSample = sampler.get2D();
         Vec2 bsdfSample = sampler.get2D();
         float rrSample = sampler.get1D();
+        float candidateSample = directLightCandidates_ > 1 ? sampler.get1D() : 0.0f;
 
-        // Sample a single light source
-        size_t lightIndex = static_cast<size_t>(lightIndexSample * scene.getNumLights());
-        const Shape* light = scene.getLights()[lightIndex];
-        float lightProb = 1.0f / scene.getNumLights();
-
-        // MIS light sampling
-        float lightPdf;
-        Vec3 lightDir = light->sampleDirection(intersectionPoint,
-            lightSample.x, lightSample.y, &lightPdf);
-        Vec3 wi = basis.worldToLocal(lightDir);
-
-        float cosThetaI = abs(cosTheta(wi));
-        if (cosThetaI > 0.0f && lightPdf > 0.0f) {
-            Ray lightRay(intersectionPoint + sign(cosTheta(wi)) * hit.normal * 0.001f, lightDir);
-            RayHit lightHit = scene.intersect(lightRay);
-            if (lightHit.shape == light && lightHit.shape != hit.shape) {
-                float bsdfPdf = material->pdf(wi, wo);
-                if (bsdfPdf > 0.0f) {
-                    float misWeight = powerHeuristic(1, lightPdf, 1, bsdfPdf);
-                    Vec3 bsdf = material->evaluate(wi, wo);
-                    color += lambda * light->material->getEmittance() * bsdf * cosThetaI * misWeight / (lightPdf * lightProb);
-                    assert(isFinite(color) && color.r >= 0.0f && color.g >= 0.0f && color.b >= 0.0f);
-                }
-            }
+        // Next event estimation with a single shadow ray
+        const DirectionalQuadtree* guide = getGuide(*material, intersectionPoint);
+        DirectLightSample lightSample = sampleDirectLight(scene, hit, intersectionPoint, basis, wo, guide,
+            lightIndexSample, lightPositionSample, candidateSample);
+        if (lightSample.light && scene.intersect(lightSample.shadowRay).shape == lightSample.light) {
+            color += lambda * lightSample.contribution;
+            assert(isFinite(color) && color.r >= 0.0f && color.g >= 0.0f && color.b >= 0.0f);
         }
 
         // Sample BSDF for direct and indirect illumination
         float bsdfPdf;
-        wi = material->sampleDirection(wo, bsdfSample.x, bsdfSample.y, &bsdfPdf);
-        cosThetaI = abs(cosTheta(wi));
+        Vec3 wi = sampleScattering(*material, guide, basis, wo, bsdfSample, bsdfPdf);
+        float cosThetaI = abs(cosTheta(wi));
         if (cosThetaI <= 0.0f || bsdfPdf <= 0.0f) {
             break;
         }
         Vec3 bsdf = material->evaluate(wi, wo);
+        if (maxComponent(bsdf) <= 0.0f) {
+            break; // Guided directions can miss the BSDF
+        }
+        Vec3 vertexColor = color;
 
-        // MIS BSDF sampling
+        // MIS BSDF sampling, any light that is hit could have been sampled as well
         Ray lightRay(intersectionPoint + sign(cosTheta(wi)) * hit.normal * 0.001f, basis.localToWorld(wi));
         RayHit lightHit = scene.intersect(lightRay);
-        if (lightHit.shape == light && lightHit.shape != hit.shape) {
-            lightPdf = light->pdf(intersectionPoint, lightRay.direction);
-            if (lightPdf > 0.0f) {
-                float misWeight = powerHeuristic(1, bsdfPdf, 1, lightPdf);
-                color += lambda * light->material->getEmittance() * bsdf * cosThetaI * misWeight / (bsdfPdf * lightProb);
+        if (lightHit.t >= 0.0f && lightHit.shape->isLight() && lightHit.shape != hit.shape) {
+            float misWeight = computeBsdfMisWeight(scene, intersectionPoint, hit.normal, lightRay, lightHit.shape, bsdfPdf);
+            if (misWeight > 0.0f) {
+                color += lambda * lightHit.shape->material->getEmittance() * bsdf * cosThetaI * misWeight / bsdfPdf;
                 assert(isFinite(color) && color.r >= 0.0f && color.g >= 0.0f && color.b >= 0.0f);
             }
         }
@@ -157,6 +1020,9 @@ Vec3 Renderer::radiance(const Scene& scene, Sampler& sampler, Ray ray) const {
         // Update path throughput
         lambda *= bsdf * cosThetaI / bsdfPdf;
         assert(isFinite(lambda) && lambda.r >= 0.0f && lambda.g >= 0.0f && lambda.b >= 0.0f);
+        if (guidingVertices) {
+            guidingVertices[numGuidingVertices++] = { intersectionPoint, lightRay.direction, bsdfPdf, vertexColor, lambda };
+        }
 
         // Russian roulette
         float rrProb = min(0.95f, max(lambda.r, max(lambda.g, lambda.b)));
@@ -173,6 +1039,9 @@ Vec3 Renderer::radiance(const Scene& scene, Sampler& sampler, Ray ray) const {
         hit = lightHit;
     }
 
+    if (guidingVertices) {
+        recordGuidingVertices(guidingVertices, numGuidingVertices, color);
+    }
     return color;
 }
 
@@ -1,44 +1,250 @@
 #pragma once
 
+#include "Vector2.h"
 #include "Vector3.h"
 #include "Ray.h"
 #include "RandomSeries.h"
 #include "Film.h"
+#include "GuidingField.h"
 
 #include <vector>
 #include <thread>
 #include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
 #include <cstdint>
 
 namespace pt {
 
 class Scene;
+class Shape;
 class Camera;
+class OrthonormalBasis;
+class Material;
 class Film;
 class Sampler;
+class SampleLayout;
+template <typename SamplerType>
+class BufferedSampler;
 class ProgressBar;
+struct PathPool;
+
+enum class TileScheduling {
+    Linear,     // Every tile is rendered once in scanline order
+    NoiseAware  // Sample passes go to the tiles with the highest estimated error first
+};
+
+enum class Integrator {
+    Megakernel, // Every path is traced from start to end, see radiance()
+    Wavefront   // The paths of a tile are traced together in stages, see renderTileWavefront()
+};
+
+enum class LightSampling {
+    Power, // Lights are picked by their power, see Scene::sampleLight()
+    BVH    // Lights are picked by their importance for the shading point from the light BVH
+};
 
 class Renderer {
 public:
+    // Called from the worker threads after samples were added to a tile. No other
+    // thread writes to the tile until the callback returns.
+    using TileCallback = std::function<void(const Film& film, const Film::Tile& tile)>;
+    // Called with the film of every preview pass, see setPreviewCallback()
+    using PreviewCallback = std::function<void(const Film& previewFilm)>;
+
+    // Pixels that already have samples in the film (e.g. from a checkpoint)
+    // continue at their next sample index. The result is bit-identical for any
+    // number of threads, except for the noise-aware scheduling and time limits
+    // which depend on the timing of the workers.
     void render(const Scene& scene, const Camera& camera, Film& film, Sampler& sampler);
 
+    // Renders the samples [firstSample, firstSample + numSamples) of the tiles,
+    // which have to be empty in the film. Used to split a frame across processes.
+    void renderTiles(const Scene& scene, const Camera& camera, Film& film, Sampler& sampler,
+        const std::vector<Film::Tile>& tiles, uint32_t firstSample, uint32_t numSamples);
+
+    // Adds up to numSamples to every pixel of the crop window, continuing at the
+    // sample index of each pixel until the samples per pixel of the sampler are
+    // reached. Returns the number of added samples, 0 once the film is complete.
+    // Rendering in passes gives the same result as a single render.
+    uint64_t renderProgressivePass(const Scene& scene, const Camera& camera, Film& film, Sampler& sampler,
+        uint32_t numSamples);
+
+    // Renders every tile of the crop window into its own film that only stores the
+    // tile and passes it to the callback, so the memory use doesn't depend on the
+    // film size. The film itself only provides the size and crop window.
+    void renderOutOfCore(const Scene& scene, const Camera& camera, const Film& film, Sampler& sampler,
+        const TileCallback& tileFinished);
+
     void setMaxDepth(uint32_t depth) { maxDepth_ = depth; }
     void setMinRRDepth(uint32_t depth) { minRRDepth_ = depth; }
     void setTileSize(uint32_t width, uint32_t height) { tileWidth_ = width; tileHeight_ = height; }
+    uint32_t getTileWidth() const { return tileWidth_; }
+    uint32_t getTileHeight() const { return tileHeight_; }
+
     void setBackgroundColor(const Vec3& color) { backgroundColor_ = color; }
+    // Both integrators produce the same image, up to the rounding of the float math
+    void setIntegrator(Integrator integrator) { integrator_ = integrator; }
+    void setLightSampling(LightSampling sampling) { lightSampling_ = sampling; }
+    // Light samples that are drawn per shading point, of which the one with the
+    // highest contribution is most likely to get the shadow ray (1 = no resampling)
+    void setDirectLightCandidates(uint32_t candidates) { directLightCandidates_ = max(candidates, 1u); }
+
+    // With path guiding, render() first traces passes of 1, 2, 4, ... samples per
+    // pixel up to half of the samples, which teach a guiding field where the light
+    // comes from (see GuidingField). Every pass samples directions from what the
+    // previous ones learned, mixed with the BSDF sampling, and so does the rest
+    // of the render, also with adaptive sampling or noise-aware tile scheduling.
+    // renderTiles(), renderProgressivePass() and the other render functions don't
+    // use guiding.
+    void setPathGuiding(bool enabled) { pathGuiding_ = enabled; }
+    // The probability of sampling the BSDF instead of the guiding field, at least
+    // 0.1 so directions the field missed are still sampled
+    void setGuidingBsdfFraction(float fraction) { guidingBsdfFraction_ = clamp(fraction, 0.1f, 1.0f); }
+
+    // Adaptive sampling is enabled with a relative error threshold > 0. The total
+    // sample budget stays the same, but converged pixels stop early and the saved
+    // samples are spent on the noisiest pixels (up to maxSamples per pixel).
+    // A value of 0 for the min/max samples selects a default based on the spp.
+    void setAdaptiveThreshold(float threshold) { adaptiveThreshold_ = threshold; }
+    void setAdaptiveMinSamples(uint32_t samples) { adaptiveMinSamples_ = samples; }
+    void setAdaptiveMaxSamples(uint32_t samples) { adaptiveMaxSamples_ = samples; }
+
+    // The noise-aware scheduling renders adaptiveMinSamples for every tile and then
+    // hands out further passes to the tiles with the highest expected error reduction.
+    // Pixels below the adaptive threshold (if enabled) are skipped in those passes.
+    void setTileScheduling(TileScheduling scheduling) { tileScheduling_ = scheduling; }
+
+    // Workers stop picking up new tiles after this many seconds (0 = no limit)
+    void setTimeLimit(float seconds) { timeLimit_ = seconds; }
+
+    void setTileCallback(const TileCallback& callback) { tileCallback_ = callback; }
+
+    // With a preview callback, render() starts an empty film with cheap passes at
+    // 1/8, 1/4 and 1/2 of the resolution with one sample per pixel, so a whole
+    // frame can be shown long before the first full quality tile is finished.
+    // The preview films have the same aspect and view but aren't part of the result.
+    void setPreviewCallback(const PreviewCallback& callback) { previewCallback_ = callback; }
+
+    // Number of worker threads (0 = one per hardware thread)
+    void setNumThreads(uint32_t numThreads) { numThreads_ = numThreads; }
+    void setShowProgress(bool showProgress) { showProgress_ = showProgress; }
 
 private:
-    void workerThreadMain(uint32_t id, const Scene& scene,
-        const Camera& camera, Film& film, Sampler& sampler,
-        std::vector<Film::Tile>& filmTiles, std::atomic<size_t>& nextTileIndex,
-        ProgressBar& progressBar);
-    Vec3 radiance(const Scene& scene, Sampler& sampler, Ray ray) const;
+    struct RenderPass {
+        uint32_t numSamples = 0; // Samples added to every active pixel
+        uint32_t maxSamplesPerPixel = 0;
+        const std::vector<bool>* activePixels = nullptr; // All pixels are active if null
+        bool skipConvergedPixels = false; // Skips pixels below the adaptive error threshold
+        uint32_t sampleOffset = 0; // Added to the sample index of every pixel
+        bool isPreview = false; // Renders into a preview film, the tile callback is skipped
+        bool trainGuiding = false; // Records the paths into the guiding field
+    };
+
+    struct TileQueue;
+
+    uint64_t renderPass(const Scene& scene, const Camera& camera, Film& film, Sampler& sampler,
+        const std::vector<Film::Tile>& filmTiles, const RenderPass& pass, ProgressBar& progressBar);
+    void renderGuidingPasses(const Scene& scene, const Camera& camera, Film& film, Sampler& sampler,
+        const std::vector<Film::Tile>& filmTiles, ProgressBar& progressBar);
+    void renderPreviewPasses(const Scene& scene, const Camera& camera, const Film& film, Sampler& sampler);
+    void renderAdaptive(const Scene& scene, const Camera& camera, Film& film, Sampler& sampler,
+        const std::vector<Film::Tile>& filmTiles, ProgressBar& progressBar);
+    void renderNoiseAware(const Scene& scene, const Camera& camera, Film& film, Sampler& sampler,
+        const std::vector<Film::Tile>& filmTiles, ProgressBar& progressBar);
+    void workerThreadMain(const Scene& scene,
+        const Camera& camera, Film& film, Sampler& sampler, const RenderPass& pass,
+        const std::vector<Film::Tile>& filmTiles, std::atomic<size_t>& nextTileIndex,
+        std::atomic<uint64_t>& numSamplesRendered, ProgressBar& progressBar);
+    void tileQueueWorkerMain(const Scene& scene,
+        const Camera& camera, Film& film, Sampler& sampler, const RenderPass& pass,
+        const std::vector<Film::Tile>& filmTiles, TileQueue& tileQueue, ProgressBar& progressBar);
+    // The samples of a pixel are generated in batches into a buffer (see BufferedSampler),
+    // so the sampler is only called once per batch and bounce
+    uint64_t renderTile(const Scene& scene, const Camera& camera, Film& film,
+        Sampler& sampler, const RenderPass& pass, const Film::Tile& tile) const;
+    // A range of samples of a pixel, traced by consecutive paths of a wavefront
+    struct PixelSpan {
+        uint32_t x;
+        uint32_t y;
+        uint32_t pixelIndex;
+        uint32_t firstSample;
+        uint32_t numSamples;
+        uint32_t firstPath;
+    };
+
+    // Breadth-first version of renderTile(): the samples of the tile are
+    // traced in waves of paths that go through every stage of a bounce together
+    // (generate, intersect, shade, shadow, intersect, finish bounce), each a loop
+    // over the queue of paths with work for it
+    uint64_t renderTileWavefront(const Scene& scene, const Camera& camera, Film& film,
+        Sampler& sampler, const RenderPass& pass, const Film::Tile& tile) const;
+    void renderWavefront(const Scene& scene, const Camera& camera, Film& film, Sampler& sampler,
+        const SampleLayout& layout, const std::vector<PixelSpan>& spans, PathPool& pool) const;
+    void shadePaths(const Scene& scene, const SampleLayout& layout, uint32_t depth, PathPool& pool) const;
+    void traceShadowRays(const Scene& scene, PathPool& pool) const;
+    void finishBounce(const Scene& scene, const SampleLayout& layout, uint32_t depth, PathPool& pool) const;
+
+    SampleLayout getSampleLayout() const;
+    float computeTilePriority(const Film& film, const Film::Tile& tile,
+        uint32_t stepSamples, uint32_t maxSamples) const;
+    void computeAdaptiveSampleCounts(uint32_t samplesPerPixel,
+        uint32_t& minSamples, uint32_t& maxSamples, uint32_t& stepSamples) const;
+    uint32_t getNumThreads() const;
+    bool isTimeLimitExceeded() const;
+    // The vertices of the path are stored for the guiding field if there's a buffer for them
+    Vec3 radiance(const Scene& scene, BufferedSampler<Sampler>& sampler, Ray ray,
+        GuidingVertex* guidingVertices) const;
+
+    // Next event estimation at the hit point p, with the candidates of the light
+    // sampling resampled into one light sample (see setDirectLightCandidates())
+    struct DirectLightSample {
+        Ray shadowRay;
+        const Shape* light = nullptr; // Null if there is no light to trace
+        Vec3 contribution = Vec3(0.0f); // Including the MIS weight, without the path throughput
+    };
+    DirectLightSample sampleDirectLight(const Scene& scene, const RayHit& hit, const Vec3& p,
+        const OrthonormalBasis& basis, const Vec3& wo, const DirectionalQuadtree* guide,
+        float lightIndexSample, const Vec2& lightSample, float candidateSample) const;
+    // MIS weight of a BSDF sample from p with the normal n that hits the light,
+    // 0 if the light sampling can't reach the light from p
+    float computeBsdfMisWeight(const Scene& scene, const Vec3& p, const Vec3& n, const Ray& ray,
+        const Shape* light, float bsdfPdf) const;
+
+    // The guiding distribution for the material at p, null without path guiding
+    // or if nothing was learned there
+    const DirectionalQuadtree* getGuide(const Material& material, const Vec3& p) const;
+    // BSDF sampling mixed with the guide if there is one. The directions are in
+    // the local space of the basis, the PDF is the one of the mix.
+    Vec3 sampleScattering(const Material& material, const DirectionalQuadtree* guide,
+        const OrthonormalBasis& basis, const Vec3& wo, const Vec2& u, float& pdf) const;
+    float getScatteringPdf(const Material& material, const DirectionalQuadtree* guide,
+        const OrthonormalBasis& basis, const Vec3& wi, const Vec3& wo) const;
+    // Records the light every vertex of a finished path received along its sampled direction
+    void recordGuidingVertices(const GuidingVertex* vertices, uint32_t numVertices, const Vec3& radiance) const;
 
     uint32_t maxDepth_ = 10;
     uint32_t minRRDepth_ = 3;
     uint32_t tileWidth_ = 64;
     uint32_t tileHeight_ = 64;
     Vec3 backgroundColor_ = Vec3(0.0f);
+    Integrator integrator_ = Integrator::Megakernel;
+    LightSampling lightSampling_ = LightSampling::Power;
+    uint32_t directLightCandidates_ = 1;
+    bool pathGuiding_ = false;
+    float guidingBsdfFraction_ = 0.5f;
+    std::unique_ptr<GuidingField> guidingField_; // Only during render() with path guiding
+    float adaptiveThreshold_ = 0.0f;
+    uint32_t adaptiveMinSamples_ = 0;
+    uint32_t adaptiveMaxSamples_ = 0;
+    TileScheduling tileScheduling_ = TileScheduling::Linear;
+    float timeLimit_ = 0.0f;
+    std::chrono::steady_clock::time_point renderStartTime_;
+    TileCallback tileCallback_;
+    PreviewCallback previewCallback_;
+    uint32_t numThreads_ = 0;
+    bool showProgress_ = true;
     std::vector<std::thread> workerThreads_;
 };
 
@@ -0,0 +1,28 @@
+#include "Sampler.h"
+
+namespace pt {
+
+void Sampler::generateSamples(const SampleLayout& layout, uint32_t firstCall, uint32_t endCall,
+        uint32_t firstSample, uint32_t numSamples, float* samples, size_t stride) {
+    for (uint32_t i = 0; i < numSamples; i++) {
+        startSample(firstSample + i);
+        for (uint32_t call = 0; call < endCall; call++) {
+            float* values = samples + layout.getFloatOffset(call) * stride + i;
+            if (layout.getCallSize(call) == 1) {
+                float value = get1D();
+                if (call >= firstCall) {
+                    values[0] = value;
+                }
+            }
+            else {
+                Vec2 value = get2D();
+                if (call >= firstCall) {
+                    values[0] = value.x;
+                    values[stride] = value.y;
+                }
+            }
+        }
+    }
+}
+
+} // namespace pt
@@ -3,29 +3,89 @@
 #include "Vector2.h"
 
 #include <memory>
+#include <vector>
 #include <cstdint>
 
 namespace pt {
 
+// The order of the 1D and 2D samples an integrator takes for every sample of a
+// pixel. The calls are split into groups (e.g. the camera and every bounce),
+// which are generated together for a batch of samples by BufferedSampler.
+class SampleLayout {
+public:
+    void add1D() { addCall(1); }
+    void add2D() { addCall(2); }
+    // Ends the current group, calls after it start a new one
+    void endGroup() {
+        if (groupEnds_.empty() || groupEnds_.back() < getNumCalls()) {
+            groupEnds_.push_back(getNumCalls());
+        }
+    }
+
+    uint32_t getNumCalls() const { return static_cast<uint32_t>(callSizes_.size()); }
+    uint32_t getNumFloats() const { return floatOffsets_.back(); }
+    uint32_t getCallSize(uint32_t call) const { return callSizes_[call]; }
+    // Offset of the call within the floats of a sample, the number of floats
+    // for getNumCalls()
+    uint32_t getFloatOffset(uint32_t call) const { return floatOffsets_[call]; }
+    const std::vector<uint32_t>& getGroupEnds() const { return groupEnds_; }
+
+private:
+    void addCall(uint8_t size) {
+        callSizes_.push_back(size);
+        floatOffsets_.push_back(floatOffsets_.back() + size);
+    }
+
+    std::vector<uint8_t> callSizes_;
+    std::vector<uint32_t> floatOffsets_ = { 0 };
+    std::vector<uint32_t> groupEnds_;
+};
+
+// The samples only depend on the pixel index, sample index, dimension (the
+// number of previous get1D/get2D calls for the sample) and the global seed.
+// This makes renders independent of the thread count and tile scheduling.
 class Sampler {
 public:
-    Sampler(uint32_t samplesPerPixel)
+    Sampler(uint32_t samplesPerPixel, uint64_t seed)
         : samplesPerPixel_(samplesPerPixel)
+        , seed_(seed)
     {
     }
+    virtual ~Sampler() = default;
 
-    virtual std::unique_ptr<Sampler> clone(uint64_t seed) = 0;
+    // Returns an independent sampler that generates the same samples
+    virtual std::unique_ptr<Sampler> clone() const = 0;
+    // The sampler type as in the scene file, e.g. "sobol"
+    virtual const char* getName() const = 0;
     virtual float get1D() = 0;
     virtual Vec2 get2D() = 0;
     virtual void startNextSample() = 0;
+    // Jumps to an arbitrary sample of the current pixel. Indices past the
+    // samples per pixel are valid and continue with fresh sample patterns.
+    virtual void startSample(uint32_t sampleIndex) = 0;
     virtual void startPixel(uint32_t pixelIndex) = 0;
 
+    // Generates the calls [firstCall, endCall) of the layout for the samples
+    // [firstSample, firstSample + numSamples) of the current pixel, with the same
+    // values as startSample() followed by the get1D/get2D calls of the layout.
+    // The float at offset f of sample s is written to samples[f * stride + s - firstSample],
+    // so the samples of every float are contiguous. Leaves the current sample
+    // undefined. The default goes through the calls one by one, samplers override
+    // it to share the work of a dimension across the samples.
+    virtual void generateSamples(const SampleLayout& layout, uint32_t firstCall, uint32_t endCall,
+        uint32_t firstSample, uint32_t numSamples, float* samples, size_t stride);
+
     uint32_t getSamplesPerPixel() const {
         return samplesPerPixel_;
     }
 
+    uint64_t getSeed() const {
+        return seed_;
+    }
+
 protected:
     uint32_t samplesPerPixel_;
+    uint64_t seed_;
 };
 
 } // namespace pt
@@ -8,18 +8,36 @@ RayHit Scene::intersect(const Ray& ray) const {
     return bvh_->intersect(ray);
 }
 
+void Scene::intersect(RayStream& stream, const std::vector<uint32_t>& rays) const {
+    bvh_->intersect(stream, rays);
+}
+
+void Scene::intersectAny(RayStream& stream, const std::vector<uint32_t>& rays) const {
+    bvh_->intersectAny(stream, rays);
+}
+
 void Scene::add(const Shape& shape) {
     shapes_.push_back(&shape);
 }
 
 void Scene::compile() {
+    updateLights();
+    bvh_ = std::make_unique<BVH>(shapes_, 1);
+}
+
+void Scene::updateLights() {
+    lights_.clear();
+    lightIndices_.clear();
+    std::vector<float> powers;
     for (const Shape* shape : shapes_) {
         if (shape->isLight()) {
+            lightIndices_[shape] = static_cast<uint32_t>(lights_.size());
             lights_.push_back(shape);
+            powers.push_back(shape->getPower());
         }
     }
-
-    bvh_ = std::make_unique<BVH>(shapes_, 1);
+    lightDistribution_ = AliasTable(powers);
+    lightBVH_ = LightBVH(lights_);
 }
 
 } // namespace pt
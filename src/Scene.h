@@ -2,29 +2,66 @@
 
 #include "Ray.h"
 #include "BVH.h"
+#include "AliasTable.h"
+#include "LightBVH.h"
 
 #include <vector>
 #include <memory>
+#include <unordered_map>
 
 namespace pt {
 
 class Shape;
 class Sphere;
+struct RayStream;
 
 class Scene {
 public:
     RayHit intersect(const Ray& ray) const;
+    // Traces the listed rays of the stream together, see BVH::intersect(RayStream&)
+    void intersect(RayStream& stream, const std::vector<uint32_t>& rays) const;
+    // Finds any hit before the tmax of every listed ray
+    void intersectAny(RayStream& stream, const std::vector<uint32_t>& rays) const;
+    // Bounds of all shapes, only valid after compile()
+    const BoundingBox& getBounds() const { return bvh_->getBounds(); }
     void add(const Shape& shape);
     void compile();
 
+    // Collects the emissive shapes again after materials were changed, the
+    // geometry and the BVH stay as they are. Rebuilds the light BVH.
+    void updateLights();
+
     const std::vector<const Shape*>& getLights() const {
         return lights_;
     }
     size_t getNumLights() const { return lights_.size(); }
 
+    // Picks a light proportional to its emitted power (emittance times area)
+    // and returns the probability of picking it, null if there are no lights
+    const Shape* sampleLight(float u, float& probability) const {
+        return lights_.empty() ? nullptr : lights_[lightDistribution_.sample(u, &probability)];
+    }
+    // The probability of sampling the given emissive shape with sampleLight()
+    float getLightProbability(const Shape* light) const {
+        return lightDistribution_.getProbability(lightIndices_.at(light));
+    }
+
+    // Picks a light for the point p with the surface normal n with the light
+    // BVH, null if no light reaches the point
+    const Shape* sampleLight(const Vec3& p, const Vec3& n, float u, float& probability) const {
+        uint32_t lightIndex;
+        return lightBVH_.sample(p, n, u, lightIndex, probability) ? lights_[lightIndex] : nullptr;
+    }
+    float getLightProbability(const Vec3& p, const Vec3& n, const Shape* light) const {
+        return lightBVH_.getProbability(p, n, lightIndices_.at(light));
+    }
+
 private:
     std::vector<const Shape*> shapes_;
     std::vector<const Shape*> lights_;
+    AliasTable lightDistribution_;
+    LightBVH lightBVH_;
+    std::unordered_map<const Shape*, uint32_t> lightIndices_;
     std::unique_ptr<BVH> bvh_;
 };
 
@@ -2,10 +2,13 @@
 #include "Vector2.h"
 #include "RandomSampler.h"
 #include "CMJSampler.h"
+#include "SobolSampler.h"
+#include "ZSobolSampler.h"
 
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tiny_obj_loader.h>
 
+#include <array>
 #include <fstream>
 #include <iostream>
 
@@ -39,6 +42,7 @@ SceneFileParser::SceneFileParser(const std::filesystem::path& sceneFilePath)
     std::ifstream fileStream(sceneFilePath);
     if (!fileStream.is_open()) {
         std::cout << "[ERROR]: The scene file \"" << sceneFilePath << "\" doesn't exist.\n";
+        root_ = json(json::value_t::discarded);
         return;
     }
 
@@ -49,65 +53,113 @@ SceneFileParser::SceneFileParser(const std::filesystem::path& sceneFilePath)
     }
 }
 
-Film SceneFileParser::parseFilm() {
+SceneFileParser::SceneFileParser(const json& root, const std::filesystem::path& sceneFilePath)
+    : sceneFilePath_(sceneFilePath)
+    , root_(root)
+{
+}
+
+Film SceneFileParser::parseFilm(bool storePixels) {
     Vector2<uint32_t> filmSize;
+    std::array<uint32_t, 4> cropWindow = { 0, 0, 0, 0 }; // x, y, width, height
+    bool fullSizeOutput = false;
     if (auto it = root_.find("film"); it != root_.end()) {
         for (const auto& item : it->items()) {
             const json& v = item.value();
             if (item.key() == "size") {
                 filmSize = parseSize(v);
             }
+            else if (item.key() == "crop") {
+                v.get_to(cropWindow);
+            }
+            else if (item.key() == "fullSizeOutput") {
+                v.get_to(fullSizeOutput);
+            }
         }
     }
 
-    return Film(filmSize.x, filmSize.y);
+    Film film = storePixels ? Film(filmSize.x, filmSize.y) : Film(filmSize.x, filmSize.y, { 0, 0, 0, 0 });
+    if (cropWindow[2] > 0 && cropWindow[3] > 0) {
+        film.setCropWindow({ cropWindow[0], cropWindow[1],
+            cropWindow[0] + cropWindow[2] - 1, cropWindow[1] + cropWindow[3] - 1 }, fullSizeOutput);
+    }
+
+    return film;
 }
 
 Camera SceneFileParser::parseCamera(float filmAspectRatio) {
-    float fovY = 60.0f;
-    float aspect = filmAspectRatio;
-    float aperture = 0.0f;
-    float focalDistance = 0.0f;
-    Mat4 viewMatrix(1.0f);
-
+    CameraKeyframe properties;
+    bool hasView = false;
     if (auto it = root_.find("camera"); it != root_.end()) {
-        for (const auto& item : it->items()) {
-            const json& v = item.value();
-            if (item.key() == "fovY") {
-                v.get_to(fovY);
-            }
-            else if (item.key() == "aspect") {
-                if (float temp = v.get<float>(); temp > 0.0f) {
-                    aspect = temp;
-                }
-            }
-            else if (item.key() == "aperture") {
-                v.get_to(aperture);
-            }
-            else if (item.key() == "focalDistance") {
-                v.get_to(focalDistance);
-            }
-            else if (item.key() == "lookAt") {
-                Vec3 pos(v[0].get<float>(), v[1].get<float>(), v[2].get<float>());
-                Vec3 target(v[3].get<float>(), v[4].get<float>(), v[5].get<float>());
-                Vec3 up(v[6].get<float>(), v[7].get<float>(), v[8].get<float>());
-                viewMatrix = lookAt(pos, target, up);
-            }
-            else if (item.key() == "lookTo") {
-                Vec3 pos(v[0].get<float>(), v[1].get<float>(), v[2].get<float>());
-                Vec3 dir(v[3].get<float>(), v[4].get<float>(), v[5].get<float>());
-                Vec3 up(v[6].get<float>(), v[7].get<float>(), v[8].get<float>());
-                viewMatrix = lookAt(pos, pos + dir, up);
-            }
+        hasView = parseCameraProperties(*it, properties);
+    }
+
+    Mat4 viewMatrix = hasView ? lookAt(properties.position, properties.target, properties.up) : Mat4(1.0f);
+    return Camera(radians(properties.fovY), parseCameraAspect(filmAspectRatio),
+        properties.aperture, properties.focalDistance, viewMatrix);
+}
+
+CameraPath SceneFileParser::parseCameraPath(float filmAspectRatio) {
+    CameraPath path(parseCameraAspect(filmAspectRatio));
+    auto it = root_.find("camera");
+    if (it == root_.end() || !it->contains("keyframes")) {
+        return path;
+    }
+
+    // Every keyframe starts from the previous one, the first from the camera itself
+    CameraKeyframe keyframe;
+    parseCameraProperties(*it, keyframe);
+    for (const auto& node : it->at("keyframes")) {
+        keyframe.frame = node.value("frame", keyframe.frame);
+        parseCameraProperties(node, keyframe);
+        path.addKeyframe(keyframe);
+    }
+
+    return path;
+}
+
+float SceneFileParser::parseCameraAspect(float filmAspectRatio) {
+    if (auto it = root_.find("camera"); it != root_.end() && it->contains("aspect")) {
+        if (float aspect = (*it)["aspect"].get<float>(); aspect > 0.0f) {
+            return aspect;
         }
     }
+    return filmAspectRatio;
+}
 
-    return Camera(radians(fovY), aspect, aperture, focalDistance, viewMatrix);
+bool SceneFileParser::parseCameraProperties(const nlohmann::json& node, CameraKeyframe& properties) {
+    bool hasView = false;
+    for (const auto& item : node.items()) {
+        const json& v = item.value();
+        if (item.key() == "fovY") {
+            v.get_to(properties.fovY);
+        }
+        else if (item.key() == "aperture") {
+            v.get_to(properties.aperture);
+        }
+        else if (item.key() == "focalDistance") {
+            v.get_to(properties.focalDistance);
+        }
+        else if (item.key() == "lookAt") {
+            properties.position = Vec3(v[0].get<float>(), v[1].get<float>(), v[2].get<float>());
+            properties.target = Vec3(v[3].get<float>(), v[4].get<float>(), v[5].get<float>());
+            properties.up = Vec3(v[6].get<float>(), v[7].get<float>(), v[8].get<float>());
+            hasView = true;
+        }
+        else if (item.key() == "lookTo") {
+            properties.position = Vec3(v[0].get<float>(), v[1].get<float>(), v[2].get<float>());
+            properties.target = properties.position + Vec3(v[3].get<float>(), v[4].get<float>(), v[5].get<float>());
+            properties.up = Vec3(v[6].get<float>(), v[7].get<float>(), v[8].get<float>());
+            hasView = true;
+        }
+    }
+    return hasView;
 }
 
-std::unique_ptr<Sampler> SceneFileParser::parseSampler(uint32_t samplesPerPixelOverride) {
+std::unique_ptr<Sampler> SceneFileParser::parseSampler(uint32_t samplesPerPixelOverride, int64_t seedOverride) {
     std::string type = "cmj";
     uint32_t samplesPerPixel = 128;
+    uint64_t seed = 0;
     
     if (auto it = root_.find("sampler"); it != root_.end()) {
         for (const auto& item : it->items()) {
@@ -118,19 +170,36 @@ std::unique_ptr<Sampler> SceneFileParser::parseSampler(uint32_t samplesPerPixelO
             else if (item.key() == "samplesPerPixel" || item.key() == "spp") {
                 v.get_to(samplesPerPixel);
             }
+            else if (item.key() == "seed") {
+                v.get_to(seed);
+            }
         }
     }
 
     if (samplesPerPixelOverride) {
         samplesPerPixel = samplesPerPixelOverride;
     }
+    if (seedOverride >= 0) {
+        seed = static_cast<uint64_t>(seedOverride);
+    }
 
     std::unique_ptr<Sampler> sampler;
     if (type == "random") {
-        sampler = std::make_unique<RandomSampler>(samplesPerPixel);
+        sampler = std::make_unique<RandomSampler>(samplesPerPixel, seed);
+    }
+    else if (type == "sobol") {
+        sampler = std::make_unique<SobolSampler>(samplesPerPixel, seed);
+    }
+    else if (type == "zsobol") {
+        // Blue noise needs the pixel positions
+        Vector2<uint32_t> filmSize(0u);
+        if (auto it = root_.find("film"); it != root_.end() && it->contains("size")) {
+            filmSize = parseSize(it->at("size"));
+        }
+        sampler = std::make_unique<ZSobolSampler>(samplesPerPixel, filmSize.x, filmSize.y, seed);
     }
     else {
-        sampler = std::make_unique<CMJSampler>(samplesPerPixel);
+        sampler = std::make_unique<CMJSampler>(samplesPerPixel, seed);
     }
 
     if (sampler->getSamplesPerPixel() != samplesPerPixel) {
@@ -159,6 +228,66 @@ Renderer SceneFileParser::parseRenderer() {
                 Vector2<uint32_t> tileSize = parseSize(v);
                 renderer.setTileSize(tileSize.x, tileSize.y);
             }
+            else if (item.key() == "tileScheduling") {
+                std::string scheduling = v.get<std::string>();
+                if (scheduling == "noiseAware") {
+                    renderer.setTileScheduling(TileScheduling::NoiseAware);
+                }
+                else if (scheduling == "linear") {
+                    renderer.setTileScheduling(TileScheduling::Linear);
+                }
+                else {
+                    std::cout << "[ERROR]: Unknown tile scheduling \"" << scheduling
+                        << "\", expected \"linear\" or \"noiseAware\"\n";
+                }
+            }
+            else if (item.key() == "integrator") {
+                if (v.get<std::string>() == "wavefront") {
+                    renderer.setIntegrator(Integrator::Wavefront);
+                }
+                else {
+                    renderer.setIntegrator(Integrator::Megakernel);
+                }
+            }
+            else if (item.key() == "lightSampling") {
+                std::string sampling = v.get<std::string>();
+                if (sampling == "power") {
+                    renderer.setLightSampling(LightSampling::Power);
+                }
+                else if (sampling == "bvh") {
+                    renderer.setLightSampling(LightSampling::BVH);
+                }
+                else {
+                    std::cout << "[ERROR]: Unknown light sampling \"" << sampling
+                        << "\", expected \"power\" or \"bvh\"\n";
+                }
+            }
+            else if (item.key() == "directLightCandidates") {
+                renderer.setDirectLightCandidates(v.get<uint32_t>());
+            }
+            else if (item.key() == "pathGuiding") {
+                renderer.setPathGuiding(v.get<bool>());
+            }
+            else if (item.key() == "guidingBsdfFraction") {
+                renderer.setGuidingBsdfFraction(v.get<float>());
+            }
+            else if (item.key() == "timeLimit") {
+                renderer.setTimeLimit(v.get<float>());
+            }
+            else if (item.key() == "adaptiveSampling") {
+                for (const auto& adaptiveItem : v.items()) {
+                    const json& av = adaptiveItem.value();
+                    if (adaptiveItem.key() == "threshold") {
+                        renderer.setAdaptiveThreshold(av.get<float>());
+                    }
+                    else if (adaptiveItem.key() == "minSamples") {
+                        renderer.setAdaptiveMinSamples(av.get<uint32_t>());
+                    }
+                    else if (adaptiveItem.key() == "maxSamples") {
+                        renderer.setAdaptiveMaxSamples(av.get<uint32_t>());
+                    }
+                }
+            }
         }
     }
 
@@ -2,6 +2,7 @@
 
 #include "Film.h"
 #include "Camera.h"
+#include "CameraPath.h"
 #include "Renderer.h"
 #include "Scene.h"
 #include "Triangle.h"
@@ -21,17 +22,29 @@ class SceneFileParser {
 public:
     SceneFileParser(const std::filesystem::path& sceneFilePath);
 
-    pt::Film parseFilm();
+    // Uses an already parsed scene description. Relative paths (e.g. of obj
+    // files) are still resolved against the directory of the scene file.
+    SceneFileParser(const nlohmann::json& root, const std::filesystem::path& sceneFilePath);
+
+    // Without pixel storage the film only describes the size and crop window,
+    // e.g. for out-of-core renders
+    pt::Film parseFilm(bool storePixels = true);
     pt::Camera parseCamera(float filmAspectRatio);
-    std::unique_ptr<Sampler> parseSampler(uint32_t samplesPerPixelOverride);
+    // Keyframes of the "keyframes" array in the camera block, empty without one
+    pt::CameraPath parseCameraPath(float filmAspectRatio);
+    std::unique_ptr<Sampler> parseSampler(uint32_t samplesPerPixelOverride, int64_t seedOverride = -1);
     pt::Renderer parseRenderer();
     void parseScene(std::vector<pt::Sphere>& spheres,
         std::vector<pt::Triangle>& triangles,
         std::vector<pt::Material>& materials);
 
     bool isValid() const { return !root_.is_discarded(); }
+    const nlohmann::json& getRoot() const { return root_; }
 
 private:
+    float parseCameraAspect(float filmAspectRatio);
+    // Returns whether the node sets the view (lookAt or lookTo)
+    bool parseCameraProperties(const nlohmann::json& node, CameraKeyframe& properties);
     void parseMaterials(const nlohmann::json& node, std::vector<pt::Material>& materials);
     void parseShapes(const nlohmann::json& node, const std::vector<pt::Material>& materials,
         std::vector<pt::Sphere>& spheres, std::vector<pt::Triangle>& triangles);
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "BoundingBox.h"
+#include "ColorUtils.h"
+#include "DirectionCone.h"
 #include "Material.h"
 #include "Ray.h"
 
@@ -16,6 +18,9 @@ public:
 
     virtual RayHit intersect(const Ray& ray) const = 0;
     virtual BoundingBox getWorldBounds() const = 0;
+    virtual float getArea() const = 0;
+    // Bounds the normals of the surface, which is only lit from the front
+    virtual DirectionCone getNormalBounds() const = 0;
 
     // Returns a uniformly sampled direction in world space from the point p to this shape
     virtual Vec3 sampleDirection(const Vec3& p, float u1, float u2, float* pdf = nullptr) const = 0;
@@ -29,6 +34,11 @@ public:
             || material->getEmittance().b > 0.0f;
     }
 
+    // Emitted power up to a constant factor, used to pick between lights
+    float getPower() const {
+        return luminance(material->getEmittance()) * getArea();
+    }
+
     const Material* material;
 };
 
@@ -0,0 +1,294 @@
+#include "SharedPreview.h"
+#include "MathUtils.h"
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <thread>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char previewMagic[4] = { 'P', 'T', 'P', 'V' };
+constexpr uint32_t previewVersion = 1;
+constexpr uint32_t rowSequenceOffset = 64;
+
+static_assert(sizeof(pt::SharedPreviewHeader) <= rowSequenceOffset, "The header overlaps the row sequences");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "The sequences have to work across processes");
+
+size_t getBytesPerPixel(pt::PreviewFormat format) {
+    return format == pt::PreviewFormat::Radiance ? 3 * sizeof(float) : 3;
+}
+
+// The pixels start on a cache line after the row sequences
+uint64_t getDataOffset(uint32_t height) {
+    return (rowSequenceOffset + static_cast<uint64_t>(height) * sizeof(uint64_t) + 63) / 64 * 64;
+}
+
+size_t getSegmentSize(uint32_t width, uint32_t height, pt::PreviewFormat format) {
+    return getDataOffset(height) + static_cast<size_t>(width) * height * getBytesPerPixel(format);
+}
+
+// POSIX wants names like "/name"
+std::string getSegmentName(const std::string& name) {
+    return name.empty() || name[0] != '/' ? "/" + name : name;
+}
+
+} // namespace
+
+namespace pt {
+
+#ifndef _WIN32
+
+SharedPreviewPublisher::SharedPreviewPublisher(const std::string& name, uint32_t width, uint32_t height,
+        PreviewFormat format)
+    : name_(getSegmentName(name))
+{
+    size_ = getSegmentSize(width, height, format);
+
+    // A segment left behind by a crashed render would keep its old size
+    shm_unlink(name_.c_str());
+    int handle = shm_open(name_.c_str(), O_CREAT | O_RDWR | O_EXCL, 0644);
+    if (handle < 0) {
+        std::cout << "[ERROR]: Couldn't create the shared memory segment \"" << name_ << "\"\n";
+        return;
+    }
+
+    void* memory = MAP_FAILED;
+    if (ftruncate(handle, static_cast<off_t>(size_)) == 0) {
+        memory = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, handle, 0);
+    }
+    ::close(handle);
+    if (memory == MAP_FAILED) {
+        std::cout << "[ERROR]: Couldn't map the shared memory segment \"" << name_ << "\"\n";
+        shm_unlink(name_.c_str());
+        return;
+    }
+
+    // The new segment is zero filled, i.e. a black image with even row sequences
+    header_ = new (memory) SharedPreviewHeader;
+    std::memcpy(header_->magic, previewMagic, sizeof(previewMagic));
+    header_->version = previewVersion;
+    header_->width = width;
+    header_->height = height;
+    header_->format = format;
+    header_->rowSequenceOffset = rowSequenceOffset;
+    header_->dataOffset = getDataOffset(height);
+    header_->isFinished.store(0, std::memory_order_relaxed);
+    header_->generation.store(0, std::memory_order_release);
+}
+
+SharedPreviewPublisher::~SharedPreviewPublisher() {
+    if (header_) {
+        munmap(header_, size_);
+        shm_unlink(name_.c_str());
+    }
+}
+
+void SharedPreviewPublisher::setFinished() {
+    if (header_) {
+        header_->isFinished.store(1, std::memory_order_release);
+    }
+}
+
+SharedPreviewReader::~SharedPreviewReader() {
+    close();
+}
+
+bool SharedPreviewReader::open(const std::string& name) {
+    close();
+
+    int handle = shm_open(getSegmentName(name).c_str(), O_RDONLY, 0);
+    if (handle < 0) {
+        return false;
+    }
+
+    struct stat status;
+    void* memory = MAP_FAILED;
+    if (fstat(handle, &status) == 0 && static_cast<size_t>(status.st_size) >= rowSequenceOffset) {
+        size_ = static_cast<size_t>(status.st_size);
+        memory = mmap(nullptr, size_, PROT_READ, MAP_SHARED, handle, 0);
+    }
+    ::close(handle);
+    if (memory == MAP_FAILED) {
+        return false;
+    }
+
+    header_ = static_cast<const SharedPreviewHeader*>(memory);
+    if (std::memcmp(header_->magic, previewMagic, sizeof(previewMagic)) != 0 || header_->version != previewVersion ||
+            header_->rowSequenceOffset != rowSequenceOffset || header_->dataOffset != getDataOffset(header_->height) ||
+            size_ < getSegmentSize(header_->width, header_->height, header_->format)) {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void SharedPreviewReader::close() {
+    if (header_) {
+        munmap(const_cast<SharedPreviewHeader*>(header_), size_);
+        header_ = nullptr;
+    }
+}
+
+#else
+
+SharedPreviewPublisher::SharedPreviewPublisher(const std::string& name, uint32_t, uint32_t, PreviewFormat)
+    : name_(name)
+{
+    std::cout << "[ERROR]: Shared memory previews are not supported on this platform\n";
+}
+
+SharedPreviewPublisher::~SharedPreviewPublisher() {}
+void SharedPreviewPublisher::setFinished() {}
+SharedPreviewReader::~SharedPreviewReader() {}
+bool SharedPreviewReader::open(const std::string&) { return false; }
+void SharedPreviewReader::close() {}
+
+#endif
+
+void SharedPreviewPublisher::publishTile(const Film& film, const Film::Tile& tile) {
+    if (!header_) {
+        return;
+    }
+
+    const size_t bytesPerPixel = getBytesPerPixel(header_->format);
+    const size_t tileRowSize = (tile.endX - tile.startX + 1) * bytesPerPixel;
+    thread_local std::vector<uint8_t> pixels;
+    pixels.resize((tile.endY - tile.startY + 1) * tileRowSize);
+    for (uint32_t y = tile.startY; y <= tile.endY; y++) {
+        uint8_t* row = &pixels[(y - tile.startY) * tileRowSize];
+        if (header_->format == PreviewFormat::Radiance) {
+            film.getRadianceRow(y, tile.startX, tile.endX, reinterpret_cast<float*>(row));
+        }
+        else {
+            film.getImageRow(y, tile.startX, tile.endX, true, row);
+        }
+    }
+
+    writeTile(tile, pixels.data());
+}
+
+void SharedPreviewPublisher::publishUpsampled(const Film& previewFilm, const Film::Tile& region) {
+    if (!header_) {
+        return;
+    }
+
+    // Nearest neighbor in the normalized film coordinates of the camera, which
+    // map the first and last pixel of both films onto each other
+    const Film::Tile& window = previewFilm.getCropWindow();
+    auto toPreview = [](uint32_t x, uint32_t size, uint32_t previewSize, uint32_t start, uint32_t end) {
+        uint64_t scaled = (static_cast<uint64_t>(x) * (previewSize - 1) + (size - 1) / 2) / max(size - 1, 1u);
+        return clamp(static_cast<uint32_t>(scaled), start, end);
+    };
+
+    const size_t bytesPerPixel = getBytesPerPixel(header_->format);
+    std::vector<uint8_t> previewRow((window.endX - window.startX + 1) * bytesPerPixel);
+    std::vector<size_t> columnOffsets;
+    for (uint32_t x = region.startX; x <= region.endX; x++) {
+        uint32_t previewX = toPreview(x, header_->width, previewFilm.getWidth(), window.startX, window.endX);
+        columnOffsets.push_back((previewX - window.startX) * bytesPerPixel);
+    }
+
+    // Bands of rows keep the buffer small for huge films
+    const uint32_t bandHeight = 16;
+    const size_t rowSize = columnOffsets.size() * bytesPerPixel;
+    std::vector<uint8_t> pixels(bandHeight * rowSize);
+    uint32_t loadedPreviewY = ~0u;
+    for (uint32_t bandY = region.startY; bandY <= region.endY; bandY += bandHeight) {
+        Film::Tile band = { region.startX, bandY, region.endX, min(bandY + bandHeight - 1, region.endY) };
+        for (uint32_t y = band.startY; y <= band.endY; y++) {
+            uint32_t previewY = toPreview(y, header_->height, previewFilm.getHeight(), window.startY, window.endY);
+            if (previewY != loadedPreviewY) {
+                if (header_->format == PreviewFormat::Radiance) {
+                    previewFilm.getRadianceRow(previewY, window.startX, window.endX,
+                        reinterpret_cast<float*>(previewRow.data()));
+                }
+                else {
+                    previewFilm.getImageRow(previewY, window.startX, window.endX, true, previewRow.data());
+                }
+                loadedPreviewY = previewY;
+            }
+
+            uint8_t* row = &pixels[(y - band.startY) * rowSize];
+            for (size_t i = 0; i < columnOffsets.size(); i++) {
+                std::memcpy(row + i * bytesPerPixel, &previewRow[columnOffsets[i]], bytesPerPixel);
+            }
+        }
+        writeTile(band, pixels.data());
+    }
+}
+
+void SharedPreviewPublisher::writeTile(const Film::Tile& tile, const uint8_t* pixels) {
+    const size_t bytesPerPixel = getBytesPerPixel(header_->format);
+    const size_t tileRowSize = (tile.endX - tile.startX + 1) * bytesPerPixel;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto* rowSequences = reinterpret_cast<std::atomic<uint64_t>*>(
+        reinterpret_cast<uint8_t*>(header_) + header_->rowSequenceOffset);
+    uint8_t* data = reinterpret_cast<uint8_t*>(header_) + header_->dataOffset;
+    for (uint32_t y = tile.startY; y <= tile.endY; y++) {
+        uint64_t sequence = rowSequences[y].load(std::memory_order_relaxed);
+        rowSequences[y].store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(data + (static_cast<size_t>(y) * header_->width + tile.startX) * bytesPerPixel,
+            &pixels[(y - tile.startY) * tileRowSize], tileRowSize);
+        rowSequences[y].store(sequence + 2, std::memory_order_release);
+    }
+    header_->generation.fetch_add(1, std::memory_order_release);
+}
+
+void SharedPreviewPublisher::publishFilm(const Film& film) {
+    if (!header_) {
+        return;
+    }
+
+    // Row by row keeps the conversion buffer small
+    for (uint32_t y = 0; y < header_->height; y++) {
+        publishTile(film, { 0, y, header_->width - 1, y });
+    }
+}
+
+bool SharedPreviewReader::read(std::vector<uint8_t>& pixels, uint64_t& generation, float timeoutSeconds) const {
+    if (!header_) {
+        return false;
+    }
+
+    const auto* rowSequences = reinterpret_cast<const std::atomic<uint64_t>*>(
+        reinterpret_cast<const uint8_t*>(header_) + header_->rowSequenceOffset);
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(header_) + header_->dataOffset;
+    const size_t rowSize = header_->width * getBytesPerPixel(header_->format);
+    pixels.resize(rowSize * header_->height);
+
+    // Every row is read after the generation, so it contains at least those updates
+    generation = header_->generation.load(std::memory_order_acquire);
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t y = 0; y < header_->height; y++) {
+        while (true) {
+            uint64_t before = rowSequences[y].load(std::memory_order_acquire);
+            if (before % 2 == 0) {
+                std::memcpy(&pixels[y * rowSize], data + y * rowSize, rowSize);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (rowSequences[y].load(std::memory_order_relaxed) == before) {
+                    break;
+                }
+            }
+            if (std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count() > timeoutSeconds) {
+                return false;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    return true;
+}
+
+} // namespace pt
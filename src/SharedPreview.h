@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Film.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace pt {
+
+enum class PreviewFormat : uint32_t {
+    Tonemapped = 0, // 8-bit RGB like the PNG output
+    Radiance = 1 // Linear float RGB
+};
+
+// Layout of the start of the shared memory segment. It's followed by one
+// sequence number per row at rowSequenceOffset and the rows of the image at
+// dataOffset. Writers make the sequence of a row odd while they change it and
+// even again afterwards (a seqlock per row), so readers can detect torn rows
+// without waiting for the whole image to be quiet. The generation counts the
+// published updates, so readers can tell whether anything changed.
+struct SharedPreviewHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    PreviewFormat format;
+    uint32_t rowSequenceOffset;
+    uint64_t dataOffset;
+    std::atomic<uint32_t> isFinished;
+    std::atomic<uint64_t> generation;
+};
+
+// Publishes the state of a film into a POSIX shared memory segment as tiles
+// are finished. The segment is removed again when the publisher is destroyed,
+// processes that mapped it keep their view of the final image.
+// Only implemented for POSIX systems, elsewhere the publisher is never valid.
+class SharedPreviewPublisher {
+public:
+    SharedPreviewPublisher(const std::string& name, uint32_t width, uint32_t height, PreviewFormat format);
+    ~SharedPreviewPublisher();
+
+    SharedPreviewPublisher(const SharedPreviewPublisher&) = delete;
+    SharedPreviewPublisher& operator=(const SharedPreviewPublisher&) = delete;
+
+    bool isValid() const { return header_ != nullptr; }
+
+    // Can be called from multiple threads, e.g. from the tile callback of the
+    // renderer. The pixels are converted before taking the lock, so readers
+    // only have to wait for the copy of a tile row.
+    void publishTile(const Film& film, const Film::Tile& tile);
+    void publishFilm(const Film& film);
+    // Fills the region (in pixels of the preview) from a lower resolution film
+    // of the same view, e.g. from the preview passes of the renderer
+    void publishUpsampled(const Film& previewFilm, const Film::Tile& region);
+    void setFinished();
+
+private:
+    // Copies the converted pixels of the tile into the segment
+    void writeTile(const Film::Tile& tile, const uint8_t* pixels);
+
+    std::string name_;
+    SharedPreviewHeader* header_ = nullptr;
+    size_t size_ = 0;
+    std::mutex mutex_;
+};
+
+// Reference reader of the shared memory preview
+class SharedPreviewReader {
+public:
+    SharedPreviewReader() = default;
+    ~SharedPreviewReader();
+
+    SharedPreviewReader(const SharedPreviewReader&) = delete;
+    SharedPreviewReader& operator=(const SharedPreviewReader&) = delete;
+
+    bool open(const std::string& name);
+
+    // Copies the image. Every row is consistent, but rows may be from different
+    // updates while rendering goes on. The image contains at least all updates up
+    // to the returned generation. Fails if a row is busy for longer than the timeout.
+    bool read(std::vector<uint8_t>& pixels, uint64_t& generation, float timeoutSeconds = 1.0f) const;
+
+    uint32_t getWidth() const { return header_ ? header_->width : 0; }
+    uint32_t getHeight() const { return header_ ? header_->height : 0; }
+    PreviewFormat getFormat() const { return header_ ? header_->format : PreviewFormat::Tonemapped; }
+    bool isFinished() const { return header_ && header_->isFinished.load(std::memory_order_acquire) != 0; }
+
+private:
+    void close();
+
+    const SharedPreviewHeader* header_ = nullptr;
+    size_t size_ = 0;
+};
+
+} // namespace pt
@@ -0,0 +1,97 @@
+#include "SobolSampler.h"
+#include "SobolUtils.h"
+#include "HashUtils.h"
+
+namespace {
+
+using namespace pt;
+
+// Every dimension shuffles the order of the samples and scrambles the points
+inline uint32_t sobolIndex(uint32_t sampleIndex, uint32_t dimensionSeed) {
+    return owenScramble(sampleIndex, dimensionSeed);
+}
+
+inline float sobolX(uint32_t index, uint32_t dimensionSeed) {
+    return fixedPointToFloat(owenScramble(reverseBits(index), hash(dimensionSeed ^ 0x68bc21eb)));
+}
+
+inline float sobolY(uint32_t index, uint32_t dimensionSeed) {
+    return fixedPointToFloat(owenScramble(sobolDimension1(index), hash(dimensionSeed ^ 0x02e5be93)));
+}
+
+} // namespace
+
+namespace pt {
+
+SobolSampler::SobolSampler(uint32_t samplesPerPixel, uint64_t seed)
+    : Sampler(samplesPerPixel, seed)
+{
+    startPixel(0);
+}
+
+std::unique_ptr<Sampler> SobolSampler::clone() const {
+    return std::make_unique<SobolSampler>(samplesPerPixel_, seed_);
+}
+
+const char* SobolSampler::getName() const {
+    return "sobol";
+}
+
+float SobolSampler::get1D() {
+    dimension_++;
+    uint32_t dimensionSeed = getDimensionSeed(dimension_);
+    return sobolX(sobolIndex(sampleIndex_, dimensionSeed), dimensionSeed);
+}
+
+Vec2 SobolSampler::get2D() {
+    dimension_++;
+    uint32_t dimensionSeed = getDimensionSeed(dimension_);
+    uint32_t index = sobolIndex(sampleIndex_, dimensionSeed);
+    return Vec2(sobolX(index, dimensionSeed), sobolY(index, dimensionSeed));
+}
+
+void SobolSampler::startNextSample() {
+    sampleIndex_++;
+    dimension_ = 0;
+}
+
+void SobolSampler::startSample(uint32_t sampleIndex) {
+    sampleIndex_ = sampleIndex;
+    dimension_ = 0;
+}
+
+void SobolSampler::startPixel(uint32_t pixelIndex) {
+    pixelSeed_ = static_cast<uint32_t>(hash(pixelIndex ^ hash(seed_)));
+    sampleIndex_ = 0;
+    dimension_ = 0;
+}
+
+// The dimension seed is hashed once per call and the samples only differ in the
+// index, so the loops over the samples are integer math that vectorizes
+void SobolSampler::generateSamples(const SampleLayout& layout, uint32_t firstCall, uint32_t endCall,
+        uint32_t firstSample, uint32_t numSamples, float* samples, size_t stride) {
+    for (uint32_t call = firstCall; call < endCall; call++) {
+        uint32_t dimensionSeed = getDimensionSeed(call + 1);
+        float* values = samples + layout.getFloatOffset(call) * stride;
+        if (layout.getCallSize(call) == 1) {
+            for (uint32_t i = 0; i < numSamples; i++) {
+                uint32_t index = sobolIndex(firstSample + i, dimensionSeed);
+                values[i] = sobolX(index, dimensionSeed);
+            }
+        }
+        else {
+            for (uint32_t i = 0; i < numSamples; i++) {
+                uint32_t index = sobolIndex(firstSample + i, dimensionSeed);
+                values[i] = sobolX(index, dimensionSeed);
+                values[stride + i] = sobolY(index, dimensionSeed);
+            }
+        }
+    }
+}
+
+// The seed of a 1D or 2D sample of the current pixel, dimensions start at 1
+uint32_t SobolSampler::getDimensionSeed(uint32_t dimension) const {
+    return hash(pixelSeed_ + dimension * 0x9e3779b9);
+}
+
+} // namespace pt
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "Sampler.h"
+
+namespace pt {
+
+// The first two dimensions of the Sobol sequence with hash-based Owen scrambling.
+// Every 1D or 2D sample uses its own scrambling and its own shuffled order of the
+// sequence (seeded with the pixel and dimension), so every projection is well
+// stratified without the correlation of the higher Sobol dimensions, and all
+// dimensions cost the same. The first 2^k samples of a pixel form a (0, k, 2)-net,
+// so powers of two are the best sample counts, but all counts work.
+// See: Practical Hash-based Owen Scrambling (2020), Brent Burley
+class SobolSampler final : public Sampler {
+public:
+    SobolSampler(uint32_t samplesPerPixel, uint64_t seed = 0);
+
+    virtual std::unique_ptr<Sampler> clone() const override;
+    virtual const char* getName() const override;
+    virtual float get1D() override;
+    virtual Vec2 get2D() override;
+    virtual void startNextSample() override;
+    virtual void startSample(uint32_t sampleIndex) override;
+    virtual void startPixel(uint32_t pixelIndex) override;
+    virtual void generateSamples(const SampleLayout& layout, uint32_t firstCall, uint32_t endCall,
+        uint32_t firstSample, uint32_t numSamples, float* samples, size_t stride) override;
+
+private:
+    uint32_t getDimensionSeed(uint32_t dimension) const;
+
+    uint32_t sampleIndex_ = 0;
+    uint32_t dimension_ = 0;
+    uint32_t pixelSeed_ = 0;
+};
+
+} // namespace pt
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "MathUtils.h"
+
+#include <array>
+#include <cstdint>
+
+namespace pt {
+
+// Generator matrix of the second Sobol dimension, one column per index bit. The
+// first dimension is the van der Corput sequence, i.e. the reversed index bits.
+// Index bits past the 32 bit precision still change the points.
+constexpr std::array<uint32_t, 64> computeSobolMatrix1() {
+    std::array<uint32_t, 64> matrix = {};
+    matrix[0] = 1u << 31;
+    for (size_t i = 1; i < matrix.size(); i++) {
+        matrix[i] = matrix[i - 1] ^ (matrix[i - 1] >> 1); // Primitive polynomial x + 1
+    }
+    return matrix;
+}
+
+inline constexpr std::array<uint32_t, 64> sobolMatrix1 = computeSobolMatrix1();
+
+inline uint32_t sobolDimension1(uint64_t index) {
+    uint32_t result = 0;
+    for (uint32_t bit = 0; index != 0; index >>= 1, bit++) {
+        result ^= sobolMatrix1[bit] & (0u - static_cast<uint32_t>(index & 1));
+    }
+    return result;
+}
+
+// Same for 32 bit indices without a loop, so loops over indices vectorize. The
+// matrix is the Pascal matrix mod 2, which is the Kronecker product of five 2x2
+// blocks [1 0; 1 1], one per level of bits of the reversed index.
+inline uint32_t sobolDimension1(uint32_t index) {
+    uint32_t x = reverseBits(index);
+    x ^= (x & 0x55555555) << 1;
+    x ^= (x & 0x33333333) << 2;
+    x ^= (x & 0x0f0f0f0f) << 4;
+    x ^= (x & 0x00ff00ff) << 8;
+    x ^= (x & 0x0000ffff) << 16;
+    return x;
+}
+
+// Hash that only lets the bits of x influence more significant bits
+// See: Practical Hash-based Owen Scrambling (2020), Brent Burley
+inline uint32_t laineKarrasPermutation(uint32_t x, uint32_t seed) {
+    x += seed;
+    x ^= x * 0x6c50b47c;
+    x ^= x * 0xb82f1e52;
+    x ^= x * 0xc7afe638;
+    x ^= x * 0x8d22f6e6;
+    return x;
+}
+
+// Owen scrambling of a 0.32 fixed point value: every digit is flipped based on a
+// hash of the more significant digits, which keeps the stratification intact
+inline uint32_t owenScramble(uint32_t x, uint32_t seed) {
+    return reverseBits(laineKarrasPermutation(reverseBits(x), seed));
+}
+
+// Maps a 0.32 fixed point value to [0, 1)
+inline float fixedPointToFloat(uint32_t x) {
+    return static_cast<float>(x >> 8) * 0x1p-24f;
+}
+
+} // namespace pt
@@ -43,6 +43,10 @@ BoundingBox Sphere::getWorldBounds() const {
     return BoundingBox(center_ - radiusVec, center_ + radiusVec);
 }
 
+float Sphere::getArea() const {
+    return 4.0f * pi<float> * radiusSq_;
+}
+
 Vec3 Sphere::sampleDirection(const Vec3& p, float u1, float u2, float* pdf) const {
     Vec3 w = center_ - p;
     float distSq = lengthSq(w);
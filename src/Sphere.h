@@ -12,6 +12,8 @@ public:
 
     virtual RayHit intersect(const Ray& ray) const override;
     virtual BoundingBox getWorldBounds() const override;
+    virtual float getArea() const override;
+    virtual DirectionCone getNormalBounds() const override { return DirectionCone::entireSphere(); }
     virtual Vec3 sampleDirection(const Vec3& p, float u1, float u2, float* pdf = nullptr) const override;
     virtual float pdf(const Vec3& p, const Vec3& wi) const override;
 
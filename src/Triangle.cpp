@@ -121,6 +121,17 @@ BoundingBox Triangle::getWorldBounds() const {
     );
 }
 
+DirectionCone Triangle::getNormalBounds() const {
+    // The interpolated normals are within the cone of the vertex normals
+    Vec3 axis = normals_[0] + normals_[1] + normals_[2];
+    if (lengthSq(axis) == 0.0f) {
+        return DirectionCone::entireSphere();
+    }
+    axis = normalize(axis);
+    float cosTheta = min(dot(axis, normals_[0]), min(dot(axis, normals_[1]), dot(axis, normals_[2])));
+    return DirectionCone(axis, cosTheta);
+}
+
 Vec3 Triangle::sampleDirection(const Vec3& p, float u1, float u2, float* pdf) const {
     Vec2 uv = sampleUniformTriangle(u1, u2);
     float w = (1.0f - uv.x - uv.y);
@@ -135,8 +146,8 @@ Vec3 Triangle::sampleDirection(const Vec3& p, float u1, float u2, float* pdf) co
             *pdf = 0.0f;
         }
         else {
-            // pdf = 1/A * |T|^-1 = 1/A * r^2/(cos(theta)*A) = r^2/cos(theta)
-            *pdf = lengthSq(q - p) / cosThetaI;
+            // Area measure to solid angle: pdf = 1/A * r^2/cos(theta)
+            *pdf = lengthSq(q - p) / (cosThetaI * area_);
         }
     }
 
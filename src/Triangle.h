@@ -14,6 +14,8 @@ public:
 
     virtual RayHit intersect(const Ray& ray) const override;
     virtual BoundingBox getWorldBounds() const override;
+    virtual float getArea() const override { return area_; }
+    virtual DirectionCone getNormalBounds() const override;
     virtual Vec3 sampleDirection(const Vec3& p, float u1, float u2, float* pdf = nullptr) const override;
     virtual float pdf(const Vec3& p, const Vec3& wi) const override;
 
@@ -0,0 +1,169 @@
+#include "ZSobolSampler.h"
+#include "SobolUtils.h"
+#include "HashUtils.h"
+#include "MathUtils.h"
+
+#include <cassert>
+
+namespace {
+
+// All orders of the four base 4 digits
+constexpr uint8_t digitPermutations[24][4] = {
+    { 0, 1, 2, 3 }, { 0, 1, 3, 2 }, { 0, 2, 1, 3 }, { 0, 2, 3, 1 }, { 0, 3, 2, 1 }, { 0, 3, 1, 2 },
+    { 1, 0, 2, 3 }, { 1, 0, 3, 2 }, { 1, 2, 0, 3 }, { 1, 2, 3, 0 }, { 1, 3, 2, 0 }, { 1, 3, 0, 2 },
+    { 2, 1, 0, 3 }, { 2, 1, 3, 0 }, { 2, 0, 1, 3 }, { 2, 0, 3, 1 }, { 2, 3, 0, 1 }, { 2, 3, 1, 0 },
+    { 3, 1, 2, 0 }, { 3, 1, 0, 2 }, { 3, 2, 1, 0 }, { 3, 2, 0, 1 }, { 3, 0, 2, 1 }, { 3, 0, 1, 2 }
+};
+
+// Inserts a zero bit after every bit of the lower 32 bits
+uint64_t spreadBits(uint64_t x) {
+    x &= 0xffffffff;
+    x = (x | (x << 16)) & 0x0000ffff0000ffff;
+    x = (x | (x << 8)) & 0x00ff00ff00ff00ff;
+    x = (x | (x << 4)) & 0x0f0f0f0f0f0f0f0f;
+    x = (x | (x << 2)) & 0x3333333333333333;
+    x = (x | (x << 1)) & 0x5555555555555555;
+    return x;
+}
+
+uint32_t ceilLog2(uint32_t x) {
+    return x <= 1 ? 0 : 32 - pt::countLeadingZeros(x - 1);
+}
+
+float zsobolX(uint64_t index, uint32_t seed) {
+    return pt::fixedPointToFloat(pt::owenScramble(pt::reverseBits(static_cast<uint32_t>(index)), seed));
+}
+
+float zsobolY(uint64_t index, uint32_t seed) {
+    return pt::fixedPointToFloat(pt::owenScramble(pt::sobolDimension1(index), seed));
+}
+
+} // namespace
+
+namespace pt {
+
+ZSobolSampler::ZSobolSampler(uint32_t samplesPerPixel, uint32_t filmWidth, uint32_t filmHeight, uint64_t seed)
+    : Sampler(samplesPerPixel, seed)
+    , filmWidth_(max(filmWidth, 1u))
+    , filmHeight_(max(filmHeight, 1u))
+{
+    log2SamplesPerPixel_ = ceilLog2(max(samplesPerPixel, 1u));
+    samplesPerPixel_ = 1u << log2SamplesPerPixel_;
+    numSampleDigits_ = (log2SamplesPerPixel_ + 1) / 2;
+    numBase4Digits_ = ceilLog2(max(filmWidth_, filmHeight_)) + numSampleDigits_;
+    assert(2 * numBase4Digits_ <= 64);
+}
+
+std::unique_ptr<Sampler> ZSobolSampler::clone() const {
+    return std::make_unique<ZSobolSampler>(samplesPerPixel_, filmWidth_, filmHeight_, seed_);
+}
+
+const char* ZSobolSampler::getName() const {
+    return "zsobol";
+}
+
+float ZSobolSampler::get1D() {
+    uint64_t dimensionKey = getDimensionKey();
+    dimension_++;
+
+    uint32_t seed = static_cast<uint32_t>(hash(dimensionKey ^ hash(seed_)));
+    return zsobolX(getSobolIndex(dimensionKey), seed);
+}
+
+Vec2 ZSobolSampler::get2D() {
+    uint64_t dimensionKey = getDimensionKey();
+    dimension_ += 2;
+
+    uint64_t seeds = hash(dimensionKey ^ hash(seed_));
+    uint64_t index = getSobolIndex(dimensionKey);
+    return Vec2(zsobolX(index, static_cast<uint32_t>(seeds)), zsobolY(index, static_cast<uint32_t>(seeds >> 32)));
+}
+
+void ZSobolSampler::startNextSample() {
+    startSample(pattern_ * samplesPerPixel_ + sampleIndex_ + 1);
+}
+
+void ZSobolSampler::startSample(uint32_t sampleIndex) {
+    sampleIndex_ = sampleIndex & (samplesPerPixel_ - 1);
+    pattern_ = sampleIndex >> log2SamplesPerPixel_;
+    dimension_ = 0;
+}
+
+void ZSobolSampler::startPixel(uint32_t pixelIndex) {
+    uint32_t x = pixelIndex % filmWidth_;
+    uint32_t y = pixelIndex / filmWidth_;
+    pixelMortonIndex_ = (spreadBits(y) << 1) | spreadBits(x);
+    sampleIndex_ = 0;
+    pattern_ = 0;
+    dimension_ = 0;
+}
+
+// The permuted digits of the pixel are the same for all samples of a pattern, so
+// only the sample digits are permuted per sample. 1D samples take one dimension
+// and 2D samples two, like the floats of the layout.
+void ZSobolSampler::generateSamples(const SampleLayout& layout, uint32_t firstCall, uint32_t endCall,
+        uint32_t firstSample, uint32_t numSamples, float* samples, size_t stride) {
+    const uint64_t seedHash = hash(seed_);
+    for (uint32_t call = firstCall; call < endCall; call++) {
+        float* values = samples + layout.getFloatOffset(call) * stride;
+        uint32_t dimension = layout.getFloatOffset(call);
+        uint64_t dimensionKey = 0;
+        uint64_t seeds = 0;
+        uint64_t pixelDigits = 0;
+        for (uint32_t i = 0; i < numSamples; i++) {
+            uint32_t sampleIndex = firstSample + i;
+            uint32_t pattern = sampleIndex >> log2SamplesPerPixel_;
+            if (i == 0 || (sampleIndex & (samplesPerPixel_ - 1)) == 0) {
+                dimensionKey = dimension | (static_cast<uint64_t>(pattern) << 32);
+                seeds = hash(dimensionKey ^ seedHash);
+                pixelDigits = permuteDigits(pixelMortonIndex_ << log2SamplesPerPixel_, dimensionKey,
+                    numSampleDigits_, numBase4Digits_);
+            }
+
+            uint64_t mortonIndex = (pixelMortonIndex_ << log2SamplesPerPixel_) | (sampleIndex & (samplesPerPixel_ - 1));
+            uint64_t index = pixelDigits | permuteDigits(mortonIndex, dimensionKey, 0, numSampleDigits_);
+            values[i] = zsobolX(index, static_cast<uint32_t>(seeds));
+            if (layout.getCallSize(call) == 2) {
+                values[stride + i] = zsobolY(index, static_cast<uint32_t>(seeds >> 32));
+            }
+        }
+    }
+}
+
+// Samples past the samples per pixel continue with the patterns of new dimensions
+uint64_t ZSobolSampler::getDimensionKey() const {
+    return dimension_ | (static_cast<uint64_t>(pattern_) << 32);
+}
+
+// Index of the sample in the Sobol sequence that is shared by all pixels. The
+// Morton index of the sample (pixel and sample bits) gets every base 4 digit
+// permuted based on the more significant digits, so the pixels of every
+// aligned block stay together in the sequence while their order is random.
+uint64_t ZSobolSampler::getSobolIndex(uint64_t dimensionKey) const {
+    const uint64_t mortonIndex = (pixelMortonIndex_ << log2SamplesPerPixel_) | sampleIndex_;
+    return permuteDigits(mortonIndex, dimensionKey, 0, numBase4Digits_);
+}
+
+// The digits [firstDigit, endDigit) of the index, counted from the least significant
+uint64_t ZSobolSampler::permuteDigits(uint64_t mortonIndex, uint64_t dimensionKey,
+        uint32_t firstDigit, uint32_t endDigit) const {
+    const uint64_t dimensionHash = 0x55555555u * dimensionKey;
+
+    // With an odd power of two samples the least significant digit is base 2
+    const uint32_t lastDigitShift = log2SamplesPerPixel_ & 1;
+    uint64_t index = 0;
+    for (uint32_t i = max(firstDigit, lastDigitShift); i < endDigit; i++) {
+        uint32_t digitShift = 2 * i - lastDigitShift;
+        uint32_t digit = (mortonIndex >> digitShift) & 3;
+        uint64_t higherDigits = mortonIndex >> (digitShift + 2);
+        uint32_t permutation = static_cast<uint32_t>(hash(higherDigits ^ dimensionHash) >> 24) % 24;
+        index |= static_cast<uint64_t>(digitPermutations[permutation][digit]) << digitShift;
+    }
+    if (lastDigitShift && firstDigit == 0 && endDigit > 0) {
+        index |= (mortonIndex & 1) ^ (hash((mortonIndex >> 1) ^ dimensionHash) & 1);
+    }
+
+    return index;
+}
+
+} // namespace pt
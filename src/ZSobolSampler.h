@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Sampler.h"
+
+namespace pt {
+
+// Owen-scrambled Sobol samples ordered along a Morton curve over the pixels, so
+// neighboring pixels share one sequence and get complementary samples. The error
+// is distributed as blue noise in screen space, which looks much better at low
+// sample counts and is easier to denoise. The base 4 digits of the Morton index
+// are randomly permuted per dimension to avoid structured artifacts.
+// Pixel indices have to belong to a film of the given size. The samples per
+// pixel are rounded up to a power of two.
+// See: Screen-Space Blue-Noise Diffusion of Monte Carlo Sampling Error via
+// Hierarchical Ordering of Pixels (2020), Abdalla G. M. Ahmed and Peter Wonka
+class ZSobolSampler final : public Sampler {
+public:
+    ZSobolSampler(uint32_t samplesPerPixel, uint32_t filmWidth, uint32_t filmHeight, uint64_t seed = 0);
+
+    virtual std::unique_ptr<Sampler> clone() const override;
+    virtual const char* getName() const override;
+    virtual float get1D() override;
+    virtual Vec2 get2D() override;
+    virtual void startNextSample() override;
+    virtual void startSample(uint32_t sampleIndex) override;
+    virtual void startPixel(uint32_t pixelIndex) override;
+    virtual void generateSamples(const SampleLayout& layout, uint32_t firstCall, uint32_t endCall,
+        uint32_t firstSample, uint32_t numSamples, float* samples, size_t stride) override;
+
+private:
+    uint64_t getDimensionKey() const;
+    uint64_t getSobolIndex(uint64_t dimensionKey) const;
+    uint64_t permuteDigits(uint64_t mortonIndex, uint64_t dimensionKey, uint32_t firstDigit, uint32_t endDigit) const;
+
+    uint32_t filmWidth_;
+    uint32_t filmHeight_;
+    uint32_t log2SamplesPerPixel_;
+    uint32_t numBase4Digits_;
+    uint32_t numSampleDigits_; // The lowest digits of the Morton index are the sample index
+    uint64_t pixelMortonIndex_ = 0;
+    uint32_t sampleIndex_ = 0; // Index within the current pattern
+    uint32_t pattern_ = 0; // Selects a new pattern for every samplesPerPixel samples
+    uint32_t dimension_ = 0;
+};
+
+} // namespace pt
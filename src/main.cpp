@@ -8,24 +8,307 @@
 #include "SceneFileParser.h"
 #include "RandomSampler.h"
 #include "CMJSampler.h"
+#include "Checkpointer.h"
+#include "RenderServer.h"
+#include "DistributedRenderer.h"
+#include "Network.h"
+#include "SharedPreview.h"
+#include "PngWriter.h"
+#include "HdrImageWriter.h"
 
 #include <chrono>
+#include <cmath>
+#include <cstdio>
 #include <iostream>
 #include <vector>
+#include <memory>
 #include <filesystem>
+#include <thread>
+#include <atomic>
+#include <future>
 
-int loadAndRenderScene(const std::filesystem::path& scenePath,
-        const std::filesystem::path& outputPath, uint32_t samplesPerPixelOverride) {
-    pt::SceneFileParser sceneParser(scenePath);
+struct CommandLineOptions {
+    std::string scenePath = "../scenes/cornell.json"; // Default scene for debugging
+    std::string outputPath = "output.png";
+    uint32_t samplesPerPixel = 0;
+    int64_t seed = -1;
+    uint32_t numThreads = 0;
+    float adaptiveThreshold = -1.0f;
+    float timeLimit = 0.0f;
+    std::string checkpointPath;
+    float checkpointInterval = 60.0f;
+    bool resume = false;
+    int32_t coordinatorPort = -1; // Renders with worker processes if >= 0
+    uint32_t numLocalWorkers = 0;
+    uint32_t samplesPerJob = 0;
+    uint32_t minWorkers = 1;
+    std::string cropWindow; // "x,y,width,height", overrides the scene file
+    bool fullSizeOutput = false;
+    bool outOfCore = false;
+    std::string previewName; // Shared memory segment of the live preview
+    bool previewPasses = false; // Low resolution passes for a quick first preview image
+    bool renderSequence = false; // Renders the camera keyframes of the scene
+    int32_t firstFrame = -1; // Frame range of the sequence, all keyframes by default
+    int32_t lastFrame = -1;
+    pt::PreviewFormat previewFormat = pt::PreviewFormat::Tonemapped;
+    uint32_t firstSample = 0; // Sample range of a partial render if numSamples > 0
+    uint32_t numSamples = 0;
+    std::string executablePath;
+};
+
+// The settings a checkpoint of this render has to match to be resumed
+pt::CheckpointJob getCheckpointJob(const CommandLineOptions& options, const pt::Sampler& sampler) {
+    pt::CheckpointJob job;
+    job.samplerName = sampler.getName();
+    job.seed = sampler.getSeed();
+    job.samplesPerPixel = sampler.getSamplesPerPixel();
+    job.firstSample = options.numSamples > 0 ? options.firstSample : 0;
+    job.numSamples = options.numSamples;
+    return job;
+}
+
+int coordinateRender(const CommandLineOptions& options, pt::SceneFileParser& sceneParser,
+        pt::Film& film, const pt::Sampler& sampler, const pt::Renderer& renderer, pt::SharedPreviewPublisher* preview) {
+    if (options.resume || options.adaptiveThreshold >= 0.0f || options.timeLimit > 0.0f) {
+        std::cout << "[ERROR]: Resuming, adaptive sampling and time limits are not supported with workers\n";
+        return 1;
+    }
+
+    nlohmann::json job = {
+        { "scene", sceneParser.getRoot() },
+        { "scenePath", std::filesystem::absolute(options.scenePath).string() },
+        { "spp", sampler.getSamplesPerPixel() },
+        { "seed", sampler.getSeed() }
+    };
+
+    pt::RenderCoordinator coordinator(job, options.samplesPerJob);
+    coordinator.setMinWorkers(options.minWorkers);
+    if (!coordinator.listen(static_cast<uint16_t>(options.coordinatorPort))) {
+        return 1;
+    }
+
+    if (options.numLocalWorkers > 0) {
+        uint32_t threadsPerWorker = options.numThreads > 0 ? options.numThreads :
+            pt::max(1u, std::thread::hardware_concurrency() / options.numLocalWorkers);
+        if (!coordinator.spawnLocalWorkers(options.executablePath, options.numLocalWorkers, threadsPerWorker)) {
+            return 1;
+        }
+    }
+
+    std::unique_ptr<pt::Checkpointer> checkpointer;
+    if (!options.checkpointPath.empty()) {
+        checkpointer = std::make_unique<pt::Checkpointer>(film,
+            options.checkpointPath, options.checkpointInterval, getCheckpointJob(options, sampler));
+    }
+    if (checkpointer || preview) {
+        coordinator.setTileCallback([&](const pt::Film& film, const pt::Film::Tile& tile) {
+            if (checkpointer) {
+                checkpointer->commitTile(film, tile);
+            }
+            if (preview) {
+                preview->publishTile(film, tile);
+            }
+        });
+    }
+
+    auto start = std::chrono::high_resolution_clock::now();
+    if (!coordinator.render(film, sampler.getSamplesPerPixel(), renderer.getTileWidth(), renderer.getTileHeight())) {
+        return 1;
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    std::cout << "Render completed in " << (end - start).count() * 1.0e-9 << " seconds\n";
+    checkpointer.reset(); // Writes the final checkpoint
+    film.saveToFile(options.outputPath);
+
+    return 0;
+}
+
+int renderOutOfCore(const CommandLineOptions& options, const pt::Scene& scene, const pt::Camera& camera,
+        const pt::Film& film, pt::Sampler& sampler, pt::Renderer& renderer, pt::SharedPreviewPublisher* preview) {
+    if (std::filesystem::path(options.outputPath).extension() != ".ptraw") {
+        std::cout << "[ERROR]: Out-of-core renders can only be written to raw films (.ptraw)\n";
+        return 1;
+    }
+
+    pt::RawFilmTileWriter writer(options.outputPath, film.getWidth(), film.getHeight());
+    if (!writer.isValid()) {
+        std::cout << "[ERROR]: Couldn't create \"" << options.outputPath << "\"\n";
+        return 1;
+    }
+
+    std::atomic<bool> hasWriteFailed = false;
+    auto start = std::chrono::high_resolution_clock::now();
+    renderer.renderOutOfCore(scene, camera, film, sampler, [&](const pt::Film& tileFilm, const pt::Film::Tile& tile) {
+        if (!writer.writeTile(tileFilm, tile)) {
+            hasWriteFailed = true;
+        }
+        if (preview) {
+            preview->publishTile(tileFilm, tile);
+        }
+    });
+    auto end = std::chrono::high_resolution_clock::now();
+    std::cout << "Render completed in " << (end - start).count() * 1.0e-9 << " seconds\n";
+
+    if (hasWriteFailed) {
+        std::cout << "[ERROR]: Failed to write tiles to \"" << options.outputPath << "\"\n";
+        return 1;
+    }
+    return 0;
+}
+
+// Replaces the last run of '#' with the zero-padded frame number, or appends
+// "_0001" style numbers before the extension if there is none
+std::string getFrameOutputPath(const std::string& pattern, int32_t frame) {
+    std::string path = pattern;
+    size_t end = path.rfind('#');
+    if (end == std::string::npos) {
+        std::filesystem::path filePath(pattern);
+        path = (filePath.parent_path() / filePath.stem()).string() + "_####" + filePath.extension().string();
+        end = path.rfind('#');
+    }
+
+    size_t start = path.find_last_not_of('#', end);
+    start = start == std::string::npos ? 0 : start + 1;
+    std::string number = std::to_string(frame);
+    if (number.size() < end - start + 1) {
+        number.insert(0, end - start + 1 - number.size(), '0');
+    }
+    return path.replace(start, end - start + 1, number);
+}
+
+// Renders the frames of the camera path back to back with the same scene. Saving
+// a frame happens in the background while the next one renders.
+int renderSequence(const CommandLineOptions& options, const pt::Scene& scene, const pt::CameraPath& cameraPath,
+        const pt::Film& film, pt::Sampler& sampler, pt::Renderer& renderer, pt::SharedPreviewPublisher* preview) {
+    if (cameraPath.isEmpty()) {
+        std::cout << "[ERROR]: The scene has no camera keyframes\n";
+        return 1;
+    }
+
+    int32_t firstFrame = options.firstFrame >= 0 ? options.firstFrame
+        : static_cast<int32_t>(std::ceil(cameraPath.getFirstFrame()));
+    int32_t lastFrame = options.lastFrame >= 0 ? options.lastFrame
+        : static_cast<int32_t>(std::floor(cameraPath.getLastFrame()));
+    if (lastFrame < firstFrame) {
+        std::cout << "[ERROR]: The sequence has no frames\n";
+        return 1;
+    }
+
+    if (preview) {
+        renderer.setTileCallback([&](const pt::Film& film, const pt::Film::Tile& tile) {
+            preview->publishTile(film, tile);
+        });
+    }
+
+    std::future<bool> pendingSave;
+    std::string pendingPath;
+    bool hasSaveFailed = false;
+    auto waitForPendingSave = [&] {
+        if (pendingSave.valid() && !pendingSave.get()) {
+            std::cout << "[ERROR]: Couldn't write \"" << pendingPath << "\"\n";
+            hasSaveFailed = true;
+        }
+    };
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int32_t frame = firstFrame; frame <= lastFrame; frame++) {
+        std::cout << "[INFO]: Frame " << frame << " (" << frame - firstFrame + 1 << "/"
+            << lastFrame - firstFrame + 1 << ")\n";
+        pt::Film frameFilm = film; // Empty, but with the crop window of the scene
+        renderer.render(scene, cameraPath.getCamera(static_cast<float>(frame)), frameFilm, sampler);
+
+        // At most one frame is saved while the next one renders
+        waitForPendingSave();
+        pendingPath = getFrameOutputPath(options.outputPath, frame);
+        pendingSave = std::async(std::launch::async, [film = std::move(frameFilm), path = pendingPath] {
+            return film.saveToFile(path);
+        });
+    }
+    waitForPendingSave();
+    auto end = std::chrono::high_resolution_clock::now();
+    std::cout << "Sequence of " << lastFrame - firstFrame + 1 << " frames completed in "
+        << (end - start).count() * 1.0e-9 << " seconds\n";
+
+    return hasSaveFailed ? 1 : 0;
+}
+
+int loadAndRenderScene(const CommandLineOptions& options) {
+    pt::SceneFileParser sceneParser(options.scenePath);
     if (!sceneParser.isValid()) {
         return 1;
     }
 
-    pt::Film film = sceneParser.parseFilm();
+    pt::Film film = sceneParser.parseFilm(!options.outOfCore);
+    if (!options.cropWindow.empty()) {
+        uint32_t x, y, width, height;
+        if (std::sscanf(options.cropWindow.c_str(), "%u,%u,%u,%u", &x, &y, &width, &height) != 4 ||
+                width == 0 || height == 0) {
+            std::cout << "[ERROR]: Invalid crop window \"" << options.cropWindow << "\"\n";
+            return 1;
+        }
+        film.setCropWindow({ x, y, x + width - 1, y + height - 1 }, options.fullSizeOutput);
+    }
+    else if (options.fullSizeOutput) {
+        film.setCropWindow(film.getCropWindow(), true);
+    }
     float filmAspectRatio = film.getWidth() / static_cast<float>(film.getHeight());
     pt::Camera camera = sceneParser.parseCamera(filmAspectRatio);
-    auto sampler = sceneParser.parseSampler(samplesPerPixelOverride);
+    auto sampler = sceneParser.parseSampler(options.samplesPerPixel, options.seed);
     pt::Renderer renderer = sceneParser.parseRenderer();
+    if (options.adaptiveThreshold >= 0.0f) {
+        renderer.setAdaptiveThreshold(options.adaptiveThreshold);
+    }
+    if (options.timeLimit > 0.0f) {
+        renderer.setTimeLimit(options.timeLimit);
+    }
+    renderer.setNumThreads(options.numThreads);
+
+    if (options.outOfCore && (options.resume || options.coordinatorPort >= 0 || options.numSamples > 0 ||
+            !options.checkpointPath.empty() || options.adaptiveThreshold >= 0.0f)) {
+        std::cout << "[ERROR]: Out-of-core renders can't be combined with resuming, checkpoints, workers, sample ranges or adaptive sampling\n";
+        return 1;
+    }
+
+    if (options.renderSequence && (options.resume || options.coordinatorPort >= 0 || options.numSamples > 0 ||
+            !options.checkpointPath.empty() || options.outOfCore)) {
+        std::cout << "[ERROR]: Sequences can't be combined with resuming, checkpoints, workers, sample ranges or out-of-core renders\n";
+        return 1;
+    }
+
+    bool isPartialRender = options.numSamples > 0;
+    if (isPartialRender && (options.resume || options.coordinatorPort >= 0)) {
+        std::cout << "[ERROR]: A sample range can't be combined with resuming or workers\n";
+        return 1;
+    }
+
+    // The preview always shows the whole film, like the raw outputs
+    std::unique_ptr<pt::SharedPreviewPublisher> preview;
+    if (!options.previewName.empty()) {
+        preview = std::make_unique<pt::SharedPreviewPublisher>(options.previewName,
+            film.getWidth(), film.getHeight(), options.previewFormat);
+        if (!preview->isValid()) {
+            return 1;
+        }
+        std::cout << "[INFO]: Publishing the preview to the shared memory segment \"" << options.previewName << "\"\n";
+
+        if (options.previewPasses) {
+            renderer.setPreviewCallback([&preview, window = film.getCropWindow()](const pt::Film& previewFilm) {
+                preview->publishUpsampled(previewFilm, window);
+            });
+        }
+    }
+    else if (options.previewPasses) {
+        std::cout << "[WARNING]: Preview passes are only shown in a shared memory preview (--preview-shm)\n";
+    }
+
+    // The coordinator only hands out work, the workers load the scene themselves
+    if (options.coordinatorPort >= 0) {
+        int result = coordinateRender(options, sceneParser, film, *sampler, renderer, preview.get());
+        if (preview) {
+            preview->setFinished();
+        }
+        return result;
+    }
 
     std::vector<pt::Sphere> spheres;
     std::vector<pt::Triangle> triangles;
@@ -41,30 +324,329 @@ int loadAndRenderScene(const std::filesystem::path& scenePath,
     }
     scene.compile();
 
+    if (options.renderSequence) {
+        int result = renderSequence(options, scene, sceneParser.parseCameraPath(filmAspectRatio),
+            film, *sampler, renderer, preview.get());
+        if (preview) {
+            preview->setFinished();
+        }
+        return result;
+    }
+
+    if (options.outOfCore) {
+        int result = renderOutOfCore(options, scene, camera, film, *sampler, renderer, preview.get());
+        if (preview) {
+            preview->setFinished();
+        }
+        return result;
+    }
+
+    if (options.resume && std::filesystem::exists(options.checkpointPath)) {
+        pt::Film checkpointFilm(0, 0);
+        if (!checkpointFilm.loadRaw(options.checkpointPath)) {
+            std::cout << "[ERROR]: The checkpoint \"" << options.checkpointPath << "\" is not a valid raw film file.\n";
+            return 1;
+        }
+        if (checkpointFilm.getWidth() != film.getWidth() || checkpointFilm.getHeight() != film.getHeight()) {
+            std::cout << "[ERROR]: The checkpoint doesn't match the film size of the scene.\n";
+            return 1;
+        }
+        pt::CheckpointJob checkpointJob;
+        if (!pt::Checkpointer::loadJob(options.checkpointPath, checkpointJob)) {
+            std::cout << "[ERROR]: The checkpoint \"" << options.checkpointPath
+                << "\" has no valid job file, so it can't be checked against this render.\n";
+            return 1;
+        }
+        std::string difference = checkpointJob.describeDifference(getCheckpointJob(options, *sampler));
+        if (!difference.empty()) {
+            std::cout << "[ERROR]: The checkpoint was rendered with " << difference << ".\n";
+            return 1;
+        }
+        film.copyTile(checkpointFilm, { 0, 0, film.getWidth() - 1, film.getHeight() - 1 }); // Keeps the crop window
+        std::cout << "[INFO]: Resuming from \"" << options.checkpointPath << "\" with "
+            << film.getTotalSamples() << " samples\n";
+        if (preview) {
+            preview->publishFilm(film);
+        }
+    }
+
+    std::unique_ptr<pt::Checkpointer> checkpointer;
+    if (!options.checkpointPath.empty()) {
+        checkpointer = std::make_unique<pt::Checkpointer>(film,
+            options.checkpointPath, options.checkpointInterval, getCheckpointJob(options, *sampler));
+    }
+    if (checkpointer || preview) {
+        renderer.setTileCallback([&](const pt::Film& film, const pt::Film::Tile& tile) {
+            if (checkpointer) {
+                checkpointer->commitTile(film, tile);
+            }
+            if (preview) {
+                preview->publishTile(film, tile);
+            }
+        });
+    }
+
     auto start = std::chrono::high_resolution_clock::now();
-    renderer.render(scene, camera, film, *sampler);
+    if (isPartialRender) {
+        // Same samples as in a full render, so the merged partial films match it
+        auto tiles = film.getTiles(renderer.getTileWidth(), renderer.getTileHeight());
+        renderer.renderTiles(scene, camera, film, *sampler, tiles, options.firstSample, options.numSamples);
+    }
+    else {
+        renderer.render(scene, camera, film, *sampler);
+    }
     auto end = std::chrono::high_resolution_clock::now();
     std::cout << "Render completed in " << (end - start).count() * 1.0e-9 << " seconds\n";
-    film.saveToFile(outputPath.generic_u8string());
+    checkpointer.reset(); // Writes the final checkpoint
+    if (preview) {
+        preview->setFinished();
+    }
+    film.saveToFile(options.outputPath);
 
     return 0;
 }
 
-int main(int argc, char** argv) {
-    std::string scenePath = "../scenes/cornell.json"; // Default scene for debugging
+int runRenderServer() {
+    // Responses go to stdout, all log messages and progress bars to stderr
+    std::ostream protocolOutput(std::cout.rdbuf());
+    std::cout.rdbuf(std::cerr.rdbuf());
+
+    pt::RenderServer server;
+    server.run(std::cin, protocolOutput);
+
+    std::cout.rdbuf(protocolOutput.rdbuf());
+    return 0;
+}
+
+int runRenderWorker(int argc, char** argv) {
+    if (argc < 3) {
+        std::cout << "[ERROR]: Usage: worker <host:port> [--threads N] [--connect-timeout seconds]\n";
+        return 1;
+    }
+
+    std::string host;
+    uint16_t port;
+    if (!pt::parseAddress(argv[2], host, port)) {
+        std::cout << "[ERROR]: Invalid coordinator address \"" << argv[2] << "\"\n";
+        return 1;
+    }
+
+    uint32_t numThreads = 0;
+    float connectTimeout = 30.0f;
+    for (int i = 3; i < argc; i++) {
+        std::string arg(argv[i]);
+        if (arg == "-j" || arg == "--threads") {
+            numThreads = std::atoi(argv[++i]);
+        }
+        else if (arg == "--connect-timeout") {
+            connectTimeout = static_cast<float>(std::atof(argv[++i]));
+        }
+        else {
+            std::cout << "[ERROR]: Unknown argument \"" << arg << "\"\n";
+            return 1;
+        }
+    }
+
+    pt::RenderWorker worker(numThreads);
+    return worker.run(host, port, connectTimeout);
+}
+
+int mergeFilms(int argc, char** argv) {
     std::string outputPath = "output.png";
-    uint32_t samplesPerPixel = 0;
+    std::vector<std::string> inputPaths;
+    for (int i = 2; i < argc; i++) {
+        std::string arg(argv[i]);
+        if (arg == "-o" || arg == "--output") {
+            outputPath = std::string(argv[++i]);
+        }
+        else {
+            inputPaths.push_back(arg);
+        }
+    }
+
+    if (inputPaths.empty()) {
+        std::cout << "[ERROR]: Usage: merge [-o output] <film.ptraw>...\n";
+        return 1;
+    }
+
+    if (!pt::Film::mergeRawFiles(inputPaths, outputPath)) {
+        std::cout << "[ERROR]: Merging into \"" << outputPath << "\" failed\n";
+        return 1;
+    }
+
+    return 0;
+}
+
+// Reference reader of the shared memory preview: saves a snapshot of it
+int readPreview(int argc, char** argv) {
+    if (argc < 3) {
+        std::cout << "[ERROR]: Usage: preview <name> [-o output] [--wait]\n";
+        return 1;
+    }
+
+    std::string outputPath;
+    bool waitUntilFinished = false;
+    for (int i = 3; i < argc; i++) {
+        std::string arg(argv[i]);
+        if (arg == "-o" || arg == "--output") {
+            outputPath = std::string(argv[++i]);
+        }
+        else if (arg == "--wait") {
+            waitUntilFinished = true;
+        }
+        else {
+            std::cout << "[ERROR]: Unknown argument \"" << arg << "\"\n";
+            return 1;
+        }
+    }
+
+    pt::SharedPreviewReader reader;
+    if (!reader.open(argv[2])) {
+        std::cout << "[ERROR]: Couldn't open the preview \"" << argv[2] << "\"\n";
+        return 1;
+    }
+    while (waitUntilFinished && !reader.isFinished()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+
+    std::vector<uint8_t> pixels;
+    uint64_t generation;
+    if (!reader.read(pixels, generation)) {
+        std::cout << "[ERROR]: Timed out reading the preview\n";
+        return 1;
+    }
+
+    uint32_t width = reader.getWidth();
+    uint32_t height = reader.getHeight();
+    bool isRadiance = reader.getFormat() == pt::PreviewFormat::Radiance;
+    std::cout << "[INFO]: " << width << "x" << height << (isRadiance ? " radiance" : " tonemapped")
+        << " preview after " << generation << " updates" << (reader.isFinished() ? ", finished\n" : "\n");
+
+    if (outputPath.empty()) {
+        outputPath = isRadiance ? "preview.exr" : "preview.png";
+    }
+    bool isWritten = false;
+    if (isRadiance) {
+        const float* rgb = reinterpret_cast<const float*>(pixels.data());
+        auto readRow = [&](uint32_t y, float* row) {
+            std::copy(rgb + y * width * 3, rgb + (y + 1) * width * 3, row);
+        };
+        bool isPfm = std::filesystem::path(outputPath).extension() == ".pfm";
+        isWritten = isPfm ? pt::writePfm(outputPath, width, height, readRow) : pt::writeExr(outputPath, width, height, readRow);
+    }
+    else {
+        isWritten = pt::writePng(outputPath, width, height, pixels);
+    }
+
+    if (!isWritten) {
+        std::cout << "[ERROR]: Couldn't write \"" << outputPath << "\"\n";
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    CommandLineOptions options;
+    options.executablePath = argv[0];
+
+    if (argc > 1 && std::string(argv[1]) == "server") {
+        return runRenderServer();
+    }
+    if (argc > 1 && std::string(argv[1]) == "worker") {
+        return runRenderWorker(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "merge") {
+        return mergeFilms(argc, argv);
+    }
+    if (argc > 1 && std::string(argv[1]) == "preview") {
+        return readPreview(argc, argv);
+    }
 
     if (argc > 1) {
-        scenePath = std::string(argv[1]);
+        options.scenePath = std::string(argv[1]);
     
         for (int i = 2; i < argc; i++) {
             std::string arg(argv[i]);
             if (arg == "-o" || arg == "--output") {
-                outputPath = std::string(argv[++i]);
+                options.outputPath = std::string(argv[++i]);
             }
             else if (arg == "-s" || arg == "--spp") {
-                samplesPerPixel = std::atoi(argv[++i]);
+                options.samplesPerPixel = std::atoi(argv[++i]);
+            }
+            else if (arg == "--seed") {
+                options.seed = std::atoll(argv[++i]);
+            }
+            else if (arg == "-j" || arg == "--threads") {
+                options.numThreads = std::atoi(argv[++i]);
+            }
+            else if (arg == "-a" || arg == "--adaptive") {
+                options.adaptiveThreshold = static_cast<float>(std::atof(argv[++i]));
+            }
+            else if (arg == "-t" || arg == "--time-limit") {
+                options.timeLimit = static_cast<float>(std::atof(argv[++i]));
+            }
+            else if (arg == "--checkpoint") {
+                options.checkpointPath = std::string(argv[++i]);
+            }
+            else if (arg == "--checkpoint-interval") {
+                options.checkpointInterval = static_cast<float>(std::atof(argv[++i]));
+            }
+            else if (arg == "--resume") {
+                options.resume = true;
+            }
+            else if (arg == "--coordinator") {
+                options.coordinatorPort = std::atoi(argv[++i]);
+            }
+            else if (arg == "--spawn-workers") {
+                options.numLocalWorkers = std::atoi(argv[++i]);
+            }
+            else if (arg == "--crop") {
+                options.cropWindow = std::string(argv[++i]);
+            }
+            else if (arg == "--full-size-output") {
+                options.fullSizeOutput = true;
+            }
+            else if (arg == "--out-of-core") {
+                options.outOfCore = true;
+            }
+            else if (arg == "--sequence") {
+                options.renderSequence = true;
+            }
+            else if (arg == "--frames") {
+                // first:last, both included
+                std::string range(argv[++i]);
+                if (std::sscanf(range.c_str(), "%d:%d", &options.firstFrame, &options.lastFrame) != 2 ||
+                        options.firstFrame < 0 || options.lastFrame < options.firstFrame) {
+                    std::cout << "[ERROR]: Invalid frame range \"" << range << "\"\n";
+                    return 1;
+                }
+                options.renderSequence = true;
+            }
+            else if (arg == "--sample-range") {
+                // first:count of the sample indices, e.g. 128:64
+                std::string range(argv[++i]);
+                size_t separator = range.find(':');
+                options.firstSample = std::atoi(range.substr(0, separator).c_str());
+                options.numSamples = separator == std::string::npos ? 0 : std::atoi(range.substr(separator + 1).c_str());
+                if (options.numSamples == 0) {
+                    std::cout << "[ERROR]: Invalid sample range \"" << range << "\"\n";
+                    return 1;
+                }
+            }
+            else if (arg == "--min-workers") {
+                options.minWorkers = std::atoi(argv[++i]);
+            }
+            else if (arg == "--samples-per-job") {
+                options.samplesPerJob = std::atoi(argv[++i]);
+            }
+            else if (arg == "--preview-shm") {
+                options.previewName = std::string(argv[++i]);
+            }
+            else if (arg == "--preview-passes") {
+                options.previewPasses = true;
+            }
+            else if (arg == "--preview-radiance") {
+                options.previewFormat = pt::PreviewFormat::Radiance;
             }
             else {
                 std::cout << "[ERROR]: Unknown argument \"" << arg << "\"\n";
@@ -73,5 +655,15 @@ int main(int argc, char** argv) {
         }
     }
 
-    return loadAndRenderScene(scenePath, outputPath, samplesPerPixel);
+    // Local workers connect to a free port unless one was given
+    if (options.numLocalWorkers > 0 && options.coordinatorPort < 0) {
+        options.coordinatorPort = 0;
+    }
+
+    // Resuming always keeps writing checkpoints, by default next to the output
+    if (options.resume && options.checkpointPath.empty()) {
+        options.checkpointPath = options.outputPath + ".ckpt";
+    }
+
+    return loadAndRenderScene(options);
 }
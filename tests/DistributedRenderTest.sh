@@ -0,0 +1,66 @@
+#!/bin/sh
+# Renders a scene locally and with a coordinator and three worker processes on
+# localhost, one of which is killed while it holds work units. The raw films have
+# to be identical since every pixel gets the same samples in both cases.
+#
+# Usage: DistributedRenderTest.sh <PathTracer> <scene> <work directory>
+
+PATH_TRACER="$1"
+SCENE="$2"
+WORK_DIR="$3"
+LOCAL_RAW="$WORK_DIR/local.raw"
+DISTRIBUTED_RAW="$WORK_DIR/distributed.raw"
+COORDINATOR_LOG="$WORK_DIR/coordinator.log"
+
+fail() {
+    echo "$1"
+    [ -f "$COORDINATOR_LOG" ] && cat "$COORDINATOR_LOG"
+    [ -n "$VICTIM_PID" ] && kill -9 "$VICTIM_PID" 2>/dev/null
+    [ -n "$COORDINATOR_PID" ] && kill -9 "$COORDINATOR_PID" 2>/dev/null
+    exit 1
+}
+
+# Waits up to 20 seconds for a line of the coordinator output
+waitForLog() {
+    for i in $(seq 200); do
+        grep -q "$1" "$COORDINATOR_LOG" 2>/dev/null && return 0
+        sleep 0.1
+    done
+    fail "Timed out waiting for \"$1\""
+}
+
+mkdir -p "$WORK_DIR"
+rm -f "$LOCAL_RAW" "$DISTRIBUTED_RAW" "$COORDINATOR_LOG"
+
+"$PATH_TRACER" "$SCENE" -o "$WORK_DIR/local.png" --checkpoint "$LOCAL_RAW" -j 2 > /dev/null ||
+    fail "Local render failed"
+
+# The coordinator picks a free port, its spawned worker gets it directly and the
+# others read it from the output. No work is sent before all three are ready.
+"$PATH_TRACER" "$SCENE" -o "$WORK_DIR/distributed.png" --checkpoint "$DISTRIBUTED_RAW" \
+    --coordinator 0 --spawn-workers 1 --threads 1 --min-workers 3 > "$COORDINATOR_LOG" &
+COORDINATOR_PID=$!
+waitForLog "Waiting for workers on port"
+PORT=$(sed -n 's/.*Waiting for workers on port \([0-9]*\).*/\1/p' "$COORDINATOR_LOG")
+
+# The failing worker is stopped once it's ready, so it can't finish the units
+# it gets when the last worker connects, and then killed
+"$PATH_TRACER" worker "127.0.0.1:$PORT" --threads 3 --connect-timeout 10 > /dev/null &
+VICTIM_PID=$!
+waitForLog "Worker with 3 threads connected"
+kill -STOP "$VICTIM_PID"
+
+"$PATH_TRACER" worker "127.0.0.1:$PORT" --threads 2 --connect-timeout 10 > /dev/null &
+WORKER_PID=$!
+waitForLog "Worker with 2 threads connected"
+sleep 1
+kill -9 "$VICTIM_PID"
+VICTIM_PID=
+
+wait "$COORDINATOR_PID" || fail "Distributed render failed"
+COORDINATOR_PID=
+wait "$WORKER_PID"
+grep -q "Lost a worker, reassigning" "$COORDINATOR_LOG" || fail "The killed worker had no work units"
+
+cmp -s "$LOCAL_RAW" "$DISTRIBUTED_RAW" || fail "The distributed film differs from the local one"
+exit 0
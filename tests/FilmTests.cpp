@@ -0,0 +1,214 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "TestHelpers.h"
+#include "Film.h"
+#include "Checkpointer.h"
+#include "RandomSeries.h"
+
+#include <filesystem>
+#include <fstream>
+#include <cstdio>
+
+TEST_CASE("Film Relative Error") {
+    pt::Film film(2, 1);
+
+    SECTION("Undefined with less than two samples") {
+        CHECK(film.getRelativeError(0, 0) == std::numeric_limits<float>::max());
+        film.addSample(0, 0, pt::Vec3(1.0f));
+        CHECK(film.getRelativeError(0, 0) == std::numeric_limits<float>::max());
+    }
+
+    SECTION("Zero for constant samples") {
+        for (int i = 0; i < 16; i++) {
+            film.addSample(0, 0, pt::Vec3(0.5f));
+        }
+        CHECK(film.getNumSamples(0, 0) == 16);
+        CHECK(film.getNumSamples(1, 0) == 0);
+        CHECK(film.getRelativeError(0, 0) == pt::Approx(0.0f));
+    }
+
+    SECTION("Decreases with the number of samples") {
+        pt::RandomSeries rng;
+        float previousError = std::numeric_limits<float>::max();
+        for (int n = 16; n <= 4096; n *= 4) {
+            pt::Film noisyFilm(1, 1);
+            for (int i = 0; i < n; i++) {
+                noisyFilm.addSample(0, 0, pt::Vec3(rng.uniformFloat()));
+            }
+
+            // Standard error of a uniform distribution: sqrt(1/12) / sqrt(n)
+            float expected = std::sqrt(1.0f / 12.0f) / std::sqrt(static_cast<float>(n)) / (0.5f + 0.01f);
+            float error = noisyFilm.getRelativeError(0, 0);
+            CHECK(error == pt::Approx(expected).epsilon(0.25f * expected));
+            CHECK(error < previousError);
+            previousError = error;
+        }
+    }
+}
+
+TEST_CASE("Film Raw File") {
+    pt::RandomSeries rng;
+    pt::Film film(7, 5);
+    for (uint32_t y = 0; y < film.getHeight(); y++) {
+        for (uint32_t x = 0; x < film.getWidth(); x++) {
+            for (uint32_t i = 0; i < x + y; i++) {
+                film.addSample(x, y, pt::Vec3(rng.uniformFloat(), rng.uniformFloat(), rng.uniformFloat()));
+            }
+        }
+    }
+
+    SECTION("Round trip") {
+        REQUIRE(film.saveRaw("film_test.ptraw"));
+        pt::Film loadedFilm(1, 1);
+        REQUIRE(loadedFilm.loadRaw("film_test.ptraw"));
+        REQUIRE(loadedFilm.getWidth() == film.getWidth());
+        REQUIRE(loadedFilm.getHeight() == film.getHeight());
+        CHECK(loadedFilm.getTotalSamples() == film.getTotalSamples());
+        CHECK(loadedFilm.getImageBuffer() == film.getImageBuffer());
+        CHECK(loadedFilm.getRelativeError(3, 2) == film.getRelativeError(3, 2));
+        std::remove("film_test.ptraw");
+    }
+
+    SECTION("Invalid file") {
+        pt::Film loadedFilm(1, 1);
+        CHECK(!loadedFilm.loadRaw("does_not_exist.ptraw"));
+        CHECK(loadedFilm.getWidth() == 1);
+
+        REQUIRE(film.saveRaw("film_test.ptraw"));
+        std::filesystem::resize_file("film_test.ptraw", std::filesystem::file_size("film_test.ptraw") - 1);
+        CHECK(!loadedFilm.loadRaw("film_test.ptraw"));
+        CHECK(loadedFilm.getWidth() == 1);
+
+        // A corrupt size in the header is rejected before the pixels are allocated
+        REQUIRE(film.saveRaw("film_test.ptraw"));
+        {
+            std::fstream file("film_test.ptraw", std::ios::binary | std::ios::in | std::ios::out);
+            uint32_t size[2] = { 65536, 65536 };
+            file.seekp(8);
+            file.write(reinterpret_cast<const char*>(size), sizeof(size));
+        }
+        CHECK(!loadedFilm.loadRaw("film_test.ptraw"));
+        CHECK(!pt::Film::mergeRawFiles({ "film_test.ptraw" }, "film_test_merged.ptraw"));
+        CHECK(loadedFilm.getWidth() == 1);
+        std::remove("film_test.ptraw");
+    }
+
+    SECTION("Copy tile") {
+        pt::Film copiedFilm(film.getWidth(), film.getHeight());
+        copiedFilm.copyTile(film, { 2, 1, 4, 3 });
+        for (uint32_t y = 0; y < film.getHeight(); y++) {
+            for (uint32_t x = 0; x < film.getWidth(); x++) {
+                bool inTile = x >= 2 && x <= 4 && y >= 1 && y <= 3;
+                CHECK(copiedFilm.getNumSamples(x, y) == (inTile ? film.getNumSamples(x, y) : 0));
+            }
+        }
+    }
+
+    SECTION("Tile data") {
+        pt::Film::Tile tile = { 1, 2, 5, 4 };
+        auto tileData = film.getTileData(tile);
+        pt::Film mergedFilm(film.getWidth(), film.getHeight());
+        REQUIRE(mergedFilm.addTileData(tile, tileData));
+        REQUIRE(mergedFilm.addTileData(tile, tileData));
+        CHECK(!mergedFilm.addTileData({ 0, 0, 1, 1 }, tileData));
+        CHECK(mergedFilm.getNumSamples(3, 3) == 2 * film.getNumSamples(3, 3));
+        CHECK(mergedFilm.getNumSamples(0, 0) == 0);
+
+        mergedFilm.clearTile(tile);
+        CHECK(mergedFilm.getTotalSamples() == 0);
+    }
+
+    SECTION("Merge") {
+        pt::Film otherFilm(film.getWidth(), film.getHeight());
+        otherFilm.addSample(6, 4, pt::Vec3(1.0f, 2.0f, 3.0f));
+        REQUIRE(film.saveToFile("film_test_a.ptraw"));
+        REQUIRE(otherFilm.saveToFile("film_test_b.ptraw"));
+
+        REQUIRE(pt::Film::mergeRawFiles({ "film_test_a.ptraw", "film_test_b.ptraw" }, "film_test_merged.ptraw"));
+        pt::Film mergedFilm(1, 1);
+        REQUIRE(mergedFilm.loadRaw("film_test_merged.ptraw"));
+        CHECK(mergedFilm.getTotalSamples() == film.getTotalSamples() + 1);
+        CHECK(mergedFilm.getNumSamples(6, 4) == film.getNumSamples(6, 4) + 1);
+
+        // Merging with an empty film changes nothing
+        pt::Film emptyFilm(film.getWidth(), film.getHeight());
+        REQUIRE(emptyFilm.saveRaw("film_test_b.ptraw"));
+        REQUIRE(pt::Film::mergeRawFiles({ "film_test_a.ptraw", "film_test_b.ptraw" }, "film_test_merged.ptraw"));
+        REQUIRE(mergedFilm.loadRaw("film_test_merged.ptraw"));
+        CHECK(mergedFilm.getImageBuffer() == film.getImageBuffer());
+
+        // An input that is also the output is kept
+        CHECK(!pt::Film::mergeRawFiles({ "film_test_a.ptraw", "film_test_b.ptraw" }, "./film_test_a.ptraw"));
+        REQUIRE(mergedFilm.loadRaw("film_test_a.ptraw"));
+        CHECK(mergedFilm.getImageBuffer() == film.getImageBuffer());
+
+        pt::Film smallFilm(2, 2);
+        REQUIRE(smallFilm.saveRaw("film_test_b.ptraw"));
+        CHECK(!pt::Film::mergeRawFiles({ "film_test_a.ptraw", "film_test_b.ptraw" }, "film_test_merged.ptraw"));
+
+        std::remove("film_test_a.ptraw");
+        std::remove("film_test_b.ptraw");
+        std::remove("film_test_merged.ptraw");
+    }
+}
+
+TEST_CASE("Film Checkpoint Job") {
+    pt::Film film(4, 3);
+    film.addSample(1, 2, pt::Vec3(1.0f));
+    pt::CheckpointJob job;
+    job.samplerName = "sobol";
+    job.seed = 3;
+    job.samplesPerPixel = 64;
+
+    {
+        pt::Checkpointer checkpointer(film, "film_test.ptraw", 60.0f, job);
+        checkpointer.commitTile(film, { 0, 0, 3, 2 });
+    }
+    pt::CheckpointJob loadedJob;
+    REQUIRE(pt::Checkpointer::loadJob("film_test.ptraw", loadedJob));
+    CHECK(loadedJob.describeDifference(job).empty());
+
+    pt::CheckpointJob otherJob = job;
+    otherJob.seed = 0;
+    otherJob.samplerName = "cmj";
+    CHECK(loadedJob.describeDifference(otherJob) == "sampler \"sobol\" instead of \"cmj\", seed 3 instead of 0");
+    otherJob = job;
+    otherJob.numSamples = 16;
+    CHECK(loadedJob.describeDifference(otherJob) == "all samples instead of sample range 0:16");
+
+    // Another job drops the job file until its first snapshot replaces the checkpoint
+    {
+        pt::Checkpointer checkpointer(film, "film_test.ptraw", 60.0f, otherJob);
+        CHECK(!pt::Checkpointer::loadJob("film_test.ptraw", loadedJob));
+    }
+    CHECK(!pt::Checkpointer::loadJob("film_test.ptraw", loadedJob));
+
+    std::remove("film_test.ptraw");
+    std::remove("film_test.ptraw.job");
+}
+
+TEST_CASE("Film Crop Window") {
+    pt::Film film(20, 10);
+    film.setCropWindow({ 3, 2, 12, 6 });
+    CHECK(film.getCropWindowArea() == 50);
+    CHECK(film.getImageWidth() == 10);
+    CHECK(film.getImageHeight() == 5);
+    CHECK(film.getImageBuffer().size() == 10 * 5 * 3);
+
+    uint64_t tileArea = 0;
+    for (const auto& tile : film.getTiles(4, 4)) {
+        CHECK(tile.startX >= 3);
+        CHECK(tile.startY >= 2);
+        CHECK(tile.endX <= 12);
+        CHECK(tile.endY <= 6);
+        tileArea += (tile.endX - tile.startX + 1) * (tile.endY - tile.startY + 1);
+    }
+    CHECK(tileArea == film.getCropWindowArea());
+
+    film.setCropWindow({ 15, 8, 30, 30 }, true);
+    CHECK(film.getCropWindow().endX == 19);
+    CHECK(film.getCropWindow().endY == 9);
+    CHECK(film.getImageWidth() == 20);
+    CHECK(film.getImageHeight() == 10);
+}
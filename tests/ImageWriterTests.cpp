@@ -0,0 +1,498 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "TestHelpers.h"
+#include "ColorUtils.h"
+#include "Deflate.h"
+#include "Film.h"
+#include "HdrImageWriter.h"
+#include "PngWriter.h"
+#include "RandomSeries.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+
+namespace {
+
+// Minimal inflate for the block types the encoder produces: stored and fixed Huffman
+class Inflater {
+public:
+    explicit Inflater(const std::vector<uint8_t>& input) : input_(input) {}
+
+    bool inflate(std::vector<uint8_t>& output) {
+        bool isFinal = false;
+        while (!isFinal) {
+            isFinal = readBits(1) == 1;
+            uint32_t type = readBits(2);
+            if (type == 0) {
+                bitPosition_ = (bitPosition_ + 7) & ~size_t(7);
+                uint32_t length = readBits(16);
+                uint32_t complement = readBits(16);
+                if ((length ^ 0xffff) != complement) {
+                    return false;
+                }
+                for (uint32_t i = 0; i < length; i++) {
+                    output.push_back(static_cast<uint8_t>(readBits(8)));
+                }
+            }
+            else if (type == 1) {
+                if (!inflateFixedBlock(output)) {
+                    return false;
+                }
+            }
+            else {
+                return false;
+            }
+            if (bitPosition_ > input_.size() * 8) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t getBytesRead() const { return (bitPosition_ + 7) / 8; }
+
+private:
+    uint32_t readBits(uint32_t count) {
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < count; i++, bitPosition_++) {
+            size_t byte = bitPosition_ / 8;
+            uint32_t bit = byte < input_.size() ? (input_[byte] >> (bitPosition_ % 8)) & 1 : 0;
+            value |= bit << i;
+        }
+        return value;
+    }
+
+    // Huffman codes are stored starting with the most significant bit
+    uint32_t readCode(uint32_t count) {
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            value = (value << 1) | readBits(1);
+        }
+        return value;
+    }
+
+    uint32_t readLiteralLength() {
+        uint32_t code = readCode(7);
+        if (code <= 0x17) {
+            return 256 + code;
+        }
+        code = (code << 1) | readBits(1);
+        if (code >= 0x30 && code <= 0xbf) {
+            return code - 0x30;
+        }
+        if (code >= 0xc0 && code <= 0xc7) {
+            return 280 + code - 0xc0;
+        }
+        code = (code << 1) | readBits(1);
+        return 144 + code - 0x190;
+    }
+
+    bool inflateFixedBlock(std::vector<uint8_t>& output) {
+        static const uint16_t lengthBase[] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+            35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+        static const uint8_t lengthExtra[] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+            3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+        static const uint16_t distanceBase[] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+            257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+        static const uint8_t distanceExtra[] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+            7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+        while (bitPosition_ <= input_.size() * 8) {
+            uint32_t symbol = readLiteralLength();
+            if (symbol < 256) {
+                output.push_back(static_cast<uint8_t>(symbol));
+            }
+            else if (symbol == 256) {
+                return true;
+            }
+            else if (symbol <= 285) {
+                uint32_t length = lengthBase[symbol - 257] + readBits(lengthExtra[symbol - 257]);
+                uint32_t distanceCode = readCode(5);
+                if (distanceCode >= 30) {
+                    return false;
+                }
+                uint32_t distance = distanceBase[distanceCode] + readBits(distanceExtra[distanceCode]);
+                if (distance > output.size()) {
+                    return false;
+                }
+                for (uint32_t i = 0; i < length; i++) {
+                    output.push_back(output[output.size() - distance]);
+                }
+            }
+            else {
+                return false;
+            }
+        }
+        return false;
+    }
+
+    const std::vector<uint8_t>& input_;
+    size_t bitPosition_ = 0;
+};
+
+std::vector<uint8_t> createTestData(size_t size, uint32_t seed) {
+    // Mix of repetitive and random data, so there are both matches and literals
+    pt::RandomSeries rng;
+    rng.seed(seed, 0);
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; i++) {
+        bool repeat = i >= 100 && (i / 1000) % 2 == 0;
+        data[i] = repeat ? data[i - 100] : static_cast<uint8_t>(rng.uniformUint32() % 16);
+    }
+    return data;
+}
+
+uint32_t readUint32(const uint8_t* data) {
+    return (uint32_t(data[0]) << 24) | (uint32_t(data[1]) << 16) | (uint32_t(data[2]) << 8) | data[3];
+}
+
+template <typename T>
+T readLittleEndian(const uint8_t* data) {
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+std::vector<uint8_t> readAndRemoveFile(const char* path) {
+    std::ifstream file(path, std::ios::binary);
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+    std::remove(path);
+    return data;
+}
+
+// Just enough of an OpenEXR reader for the files of the writer
+struct ExrImage {
+    std::map<std::string, std::vector<uint8_t>> attributes;
+    int32_t dataWindow[4];
+    int32_t displayWindow[4];
+    std::vector<std::vector<uint8_t>> lines; // Uncompressed, planar B, G, R
+};
+
+std::vector<uint8_t> decompressExrRle(const uint8_t* data, size_t size, size_t outputSize) {
+    std::vector<uint8_t> deltas;
+    for (size_t i = 0; i < size;) {
+        int count = static_cast<int8_t>(data[i++]);
+        if (count < 0) {
+            deltas.insert(deltas.end(), data + i, data + i - count);
+            i -= count;
+        }
+        else {
+            deltas.insert(deltas.end(), count + 1, data[i++]);
+        }
+    }
+    if (deltas.size() != outputSize) {
+        return {};
+    }
+
+    for (size_t i = 1; i < deltas.size(); i++) {
+        deltas[i] = static_cast<uint8_t>(deltas[i - 1] + deltas[i] - 128);
+    }
+    std::vector<uint8_t> output(outputSize);
+    size_t halfSize = (outputSize + 1) / 2;
+    for (size_t i = 0; i < outputSize; i++) {
+        output[i] = deltas[(i % 2 == 0 ? 0 : halfSize) + i / 2];
+    }
+    return output;
+}
+
+bool readExr(const std::vector<uint8_t>& file, size_t bytesPerValue, ExrImage& image) {
+    if (file.size() < 8 || readLittleEndian<uint32_t>(file.data()) != 20000630 || file[4] != 2) {
+        return false;
+    }
+
+    size_t position = 8;
+    while (position < file.size() && file[position] != 0) {
+        std::string name(reinterpret_cast<const char*>(&file[position]));
+        position += name.size() + 1;
+        std::string type(reinterpret_cast<const char*>(&file[position]));
+        position += type.size() + 1;
+        int32_t size = readLittleEndian<int32_t>(&file[position]);
+        position += 4;
+        image.attributes[name].assign(&file[position], &file[position] + size);
+        position += size;
+    }
+    position++;
+
+    for (const char* name : { "channels", "compression", "dataWindow", "displayWindow", "lineOrder",
+            "pixelAspectRatio", "screenWindowCenter", "screenWindowWidth" }) {
+        if (image.attributes.count(name) == 0) {
+            return false;
+        }
+    }
+    std::memcpy(image.dataWindow, image.attributes["dataWindow"].data(), sizeof(image.dataWindow));
+    std::memcpy(image.displayWindow, image.attributes["displayWindow"].data(), sizeof(image.displayWindow));
+
+    size_t width = image.dataWindow[2] - image.dataWindow[0] + 1;
+    size_t height = image.dataWindow[3] - image.dataWindow[1] + 1;
+    size_t lineSize = width * 3 * bytesPerValue;
+    for (size_t y = 0; y < height; y++) {
+        uint64_t offset = readLittleEndian<uint64_t>(&file[position + y * 8]);
+        if (offset + 8 > file.size() || readLittleEndian<int32_t>(&file[offset]) != image.dataWindow[1] + int32_t(y)) {
+            return false;
+        }
+        size_t size = readLittleEndian<int32_t>(&file[offset + 4]);
+        const uint8_t* data = &file[offset + 8];
+        if (offset + 8 + size > file.size()) {
+            return false;
+        }
+        image.lines.push_back(size < lineSize ? decompressExrRle(data, size, lineSize) : std::vector<uint8_t>(data, data + size));
+        if (image.lines.back().size() != lineSize) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+TEST_CASE("Deflate") {
+    SECTION("Round trip of a single chunk") {
+        auto data = createTestData(100000, 1);
+        auto compressed = pt::deflateChunk(data.data(), data.size(), true);
+        CHECK(compressed.size() < data.size() / 2);
+
+        std::vector<uint8_t> decompressed;
+        Inflater inflater(compressed);
+        REQUIRE(inflater.inflate(decompressed));
+        CHECK(inflater.getBytesRead() == compressed.size());
+        CHECK(decompressed == data);
+    }
+
+    SECTION("Concatenated chunks form one stream") {
+        auto data = createTestData(50000, 2);
+        std::vector<uint8_t> compressed;
+        const size_t chunkSizes[] = { 1, 20000, 0, 29999 };
+        size_t offset = 0;
+        for (size_t i = 0; i < std::size(chunkSizes); i++) {
+            auto chunk = pt::deflateChunk(data.data() + offset, chunkSizes[i], i + 1 == std::size(chunkSizes));
+            compressed.insert(compressed.end(), chunk.begin(), chunk.end());
+            offset += chunkSizes[i];
+        }
+
+        std::vector<uint8_t> decompressed;
+        Inflater inflater(compressed);
+        REQUIRE(inflater.inflate(decompressed));
+        CHECK(decompressed == data);
+    }
+
+    SECTION("Long runs") {
+        std::vector<uint8_t> data(70000, 42);
+        auto compressed = pt::deflateChunk(data.data(), data.size(), true);
+        CHECK(compressed.size() < 1000);
+
+        std::vector<uint8_t> decompressed;
+        Inflater inflater(compressed);
+        REQUIRE(inflater.inflate(decompressed));
+        CHECK(decompressed == data);
+    }
+}
+
+TEST_CASE("Checksums") {
+    const std::string text = "Wikipedia";
+    const auto* bytes = reinterpret_cast<const uint8_t*>(text.data());
+    CHECK(pt::adler32(bytes, text.size()) == 0x11e60398u);
+    CHECK(pt::crc32(bytes, text.size()) == 0xadaac02eu);
+
+    auto data = createTestData(123456, 3);
+    for (size_t split : { size_t(0), size_t(1), size_t(65521), size_t(100000) }) {
+        uint32_t first = pt::adler32(data.data(), split);
+        uint32_t second = pt::adler32(data.data() + split, data.size() - split);
+        CHECK(pt::adler32Combine(first, second, data.size() - split) == pt::adler32(data.data(), data.size()));
+    }
+}
+
+TEST_CASE("PNG Writer") {
+    const uint32_t width = 301;
+    const uint32_t height = 1000; // More than one block of rows
+    pt::RandomSeries rng;
+    std::vector<uint8_t> image(width * height * 3);
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width * 3; x++) {
+            image[y * width * 3 + x] = static_cast<uint8_t>(x / 3 + y + (rng.uniformUint32() % 4));
+        }
+    }
+
+    const char* path = "image_writer_test.png";
+    REQUIRE(pt::writePng(path, width, height, image, 3));
+    auto png = readAndRemoveFile(path);
+
+    // Walk the chunks, check their CRCs and collect the zlib stream
+    REQUIRE(png.size() > 8);
+    CHECK(png[0] == 0x89);
+    CHECK(std::string(png.begin() + 1, png.begin() + 4) == "PNG");
+    std::vector<uint8_t> zlibStream;
+    std::string lastChunk;
+    for (size_t offset = 8; offset + 12 <= png.size();) {
+        uint32_t length = readUint32(&png[offset]);
+        REQUIRE(offset + 12 + length <= png.size());
+        const uint8_t* type = &png[offset + 4];
+        CHECK(pt::crc32(type, length + 4) == readUint32(type + 4 + length));
+        lastChunk.assign(type, type + 4);
+        if (lastChunk == "IHDR") {
+            CHECK(readUint32(type + 4) == width);
+            CHECK(readUint32(type + 8) == height);
+        }
+        else if (lastChunk == "IDAT") {
+            zlibStream.insert(zlibStream.end(), type + 4, type + 4 + length);
+        }
+        offset += 12 + length;
+    }
+    CHECK(lastChunk == "IEND");
+
+    REQUIRE(zlibStream.size() > 6);
+    CHECK((zlibStream[0] * 256 + zlibStream[1]) % 31 == 0);
+    std::vector<uint8_t> deflateStream(zlibStream.begin() + 2, zlibStream.end() - 4);
+    std::vector<uint8_t> filtered;
+    REQUIRE(Inflater(deflateStream).inflate(filtered));
+    REQUIRE(filtered.size() == (width * 3 + 1) * height);
+    CHECK(pt::adler32(filtered.data(), filtered.size()) == readUint32(&zlibStream[zlibStream.size() - 4]));
+
+    // Undo the filters
+    const size_t rowSize = width * 3;
+    std::vector<uint8_t> decoded(image.size());
+    for (size_t y = 0; y < height; y++) {
+        uint8_t filter = filtered[y * (rowSize + 1)];
+        const uint8_t* input = &filtered[y * (rowSize + 1) + 1];
+        uint8_t* row = &decoded[y * rowSize];
+        const uint8_t* previousRow = y > 0 ? row - rowSize : nullptr;
+        REQUIRE(filter <= 4);
+        for (size_t i = 0; i < rowSize; i++) {
+            int a = i >= 3 ? row[i - 3] : 0;
+            int b = previousRow ? previousRow[i] : 0;
+            int c = i >= 3 && previousRow ? previousRow[i - 3] : 0;
+            int p = a + b - c;
+            int predictions[] = { 0, a, b, (a + b) >> 1,
+                std::abs(p - a) <= std::abs(p - b) && std::abs(p - a) <= std::abs(p - c) ? a :
+                (std::abs(p - b) <= std::abs(p - c) ? b : c) };
+            row[i] = static_cast<uint8_t>(input[i] + predictions[filter]);
+        }
+    }
+    CHECK(decoded == image);
+}
+
+TEST_CASE("Film Image Buffer") {
+    // The sRGB conversion uses a table, which may be off by one at most
+    pt::RandomSeries rng;
+    pt::Film film(64, 64);
+    std::vector<pt::Vec3> colors;
+    for (uint32_t y = 0; y < 64; y++) {
+        for (uint32_t x = 0; x < 64; x++) {
+            // From 2^-14 to 2^6, beyond both ends of the table
+            float scale = std::pow(2.0f, static_cast<float>(x + y) / 126.0f * 20.0f - 14.0f);
+            colors.push_back(pt::Vec3(rng.uniformFloat(), rng.uniformFloat(), rng.uniformFloat()) * scale);
+            film.addSample(x, y, colors.back());
+        }
+    }
+
+    for (bool tonemap : { false, true }) {
+        auto image = film.getImageBuffer(tonemap);
+        REQUIRE(image.size() == 64 * 64 * 3);
+        int maxDifference = 0;
+        for (uint32_t y = 0; y < 64; y++) {
+            for (uint32_t x = 0; x < 64; x++) {
+                pt::Vec3 color = pt::linearToSRGB(colors[y * 64 + x]);
+                color = tonemap ? pt::tonemapACES(color) : pt::saturate(color);
+                for (int c = 0; c < 3; c++) {
+                    int expected = static_cast<int>(color[c] * 255.0f + 0.5f);
+                    maxDifference = std::max(maxDifference, std::abs(expected - image[(y * 64 + x) * 3 + c]));
+                }
+            }
+        }
+        CHECK(maxDifference <= 1);
+    }
+}
+
+TEST_CASE("Half Floats") {
+    CHECK(pt::floatToHalf(0.0f) == 0x0000);
+    CHECK(pt::floatToHalf(-0.0f) == 0x8000);
+    CHECK(pt::floatToHalf(1.0f) == 0x3c00);
+    CHECK(pt::floatToHalf(-2.0f) == 0xc000);
+    CHECK(pt::floatToHalf(0.1f) == 0x2e66);
+    CHECK(pt::floatToHalf(65504.0f) == 0x7bff);
+    CHECK(pt::floatToHalf(1e6f) == 0x7bff);
+    CHECK(pt::floatToHalf(std::pow(2.0f, -14.0f)) == 0x0400); // Smallest normal
+    CHECK(pt::floatToHalf(std::pow(2.0f, -24.0f)) == 0x0001); // Smallest denormal
+    CHECK(pt::floatToHalf(std::pow(2.0f, -26.0f)) == 0x0000);
+    CHECK(pt::floatToHalf(1.0f + std::pow(2.0f, -11.0f)) == 0x3c00); // Tie, rounds to even
+    CHECK(pt::floatToHalf(1.0f + 3.0f * std::pow(2.0f, -11.0f)) == 0x3c02); // Tie, rounds to even
+    CHECK(pt::floatToHalf(2047.5f) == 0x67ff + 1); // Carry into the exponent
+}
+
+TEST_CASE("HDR Film Output") {
+    const uint32_t width = 300;
+    const uint32_t height = 20;
+    pt::Film film(width, height);
+    pt::RandomSeries rng;
+    std::vector<pt::Vec3> colors;
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            // Flat areas to get runs and noisy ones that don't compress
+            pt::Vec3 color = x < 100 ? pt::Vec3(1.0f, 2.0f, 0.5f) : pt::Vec3(rng.uniformFloat(), rng.uniformFloat(), 8.0f);
+            colors.push_back(color * static_cast<float>(y + 1));
+            film.addSample(x, y, colors.back());
+        }
+    }
+
+    SECTION("PFM") {
+        REQUIRE(film.saveToFile("film_test.pfm"));
+        auto pfm = readAndRemoveFile("film_test.pfm");
+        const std::string header = "PF\n300 20\n-1.0\n";
+        REQUIRE(pfm.size() == header.size() + width * height * 3 * sizeof(float));
+        CHECK(std::string(pfm.begin(), pfm.begin() + header.size()) == header);
+
+        // Bottom row first
+        const uint8_t* data = &pfm[header.size()];
+        CHECK(readLittleEndian<float>(data) == pt::Approx(20.0f));
+        CHECK(readLittleEndian<float>(data + 4) == pt::Approx(40.0f));
+        CHECK(readLittleEndian<float>(data + 8) == pt::Approx(10.0f));
+        data += (height - 1) * width * 3 * sizeof(float);
+        CHECK(readLittleEndian<float>(data) == pt::Approx(1.0f));
+        CHECK(readLittleEndian<float>(data + 4) == pt::Approx(2.0f));
+        CHECK(readLittleEndian<float>(data + 8) == pt::Approx(0.5f));
+    }
+
+    for (auto compression : { pt::ExrCompression::None, pt::ExrCompression::Rle }) {
+        for (auto pixelType : { pt::ExrPixelType::Half, pt::ExrPixelType::Float }) {
+            bool isHalf = pixelType == pt::ExrPixelType::Half;
+            size_t bytesPerValue = isHalf ? 2 : 4;
+            DYNAMIC_SECTION("EXR " << (isHalf ? "half" : "float") << (compression == pt::ExrCompression::Rle ? " RLE" : "")) {
+                film.setCropWindow({ 10, 2, 209, 13 });
+                REQUIRE(film.saveExr("film_test.exr", pixelType, compression));
+                auto file = readAndRemoveFile("film_test.exr");
+                ExrImage image;
+                REQUIRE(readExr(file, bytesPerValue, image));
+                CHECK(image.attributes["compression"][0] == (compression == pt::ExrCompression::Rle ? 1 : 0));
+                CHECK(image.dataWindow[0] == 10);
+                CHECK(image.dataWindow[1] == 2);
+                CHECK(image.dataWindow[2] == 209);
+                CHECK(image.dataWindow[3] == 13);
+                CHECK(image.displayWindow[2] == width - 1);
+                CHECK(image.displayWindow[3] == height - 1);
+                if (compression == pt::ExrCompression::Rle) {
+                    CHECK(file.size() < 200 * 12 * 3 * bytesPerValue);
+                }
+
+                bool allEqual = true;
+                for (uint32_t y = 0; y < 12; y++) {
+                    for (uint32_t x = 0; x < 200; x++) {
+                        for (int c = 0; c < 3; c++) {
+                            // Channels are stored in the order B, G, R
+                            const uint8_t* value = &image.lines[y][((2 - c) * 200 + x) * bytesPerValue];
+                            float expected = colors[(y + 2) * width + x + 10][c];
+                            // The mean of the film may be off by one ulp
+                            allEqual &= isHalf
+                                ? std::abs(readLittleEndian<uint16_t>(value) - pt::floatToHalf(expected)) <= 1
+                                : readLittleEndian<float>(value) == pt::Approx(expected);
+                        }
+                    }
+                }
+                CHECK(allEqual);
+            }
+        }
+    }
+}
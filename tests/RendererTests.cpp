@@ -0,0 +1,510 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "TestHelpers.h"
+#include "Renderer.h"
+#include "Scene.h"
+#include "Camera.h"
+#include "Film.h"
+#include "Sphere.h"
+#include "Triangle.h"
+#include "Material.h"
+#include "RandomSampler.h"
+#include "CMJSampler.h"
+#include "CameraPath.h"
+#include "RenderSession.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct TestScene {
+    TestScene()
+        : white(pt::Vec3(0.8f), 1.0f, 0.0f)
+        , metal(pt::Vec3(0.9f), 0.3f, 1.0f)
+        , light(pt::Vec3(1.0f), 1.0f, 0.0f, 0.0f, 1.5f, pt::Vec3(10.0f))
+        , camera(pt::radians(60.0f), 1.5f, 0.0f, 0.0f,
+            pt::lookAt(pt::Vec3(0.0f, 0.0f, 4.0f), pt::Vec3(0.0f), pt::Vec3(0.0f, 1.0f, 0.0f)))
+    {
+        spheres.emplace_back(pt::Vec3(0.0f, 2.0f, 0.0f), 0.5f, light);
+        spheres.emplace_back(pt::Vec3(-0.5f, -0.5f, 0.0f), 0.5f, metal);
+        triangles.emplace_back(pt::Vec3(-2, -1, 2), pt::Vec3(2, -1, 2), pt::Vec3(2, -1, -2), white);
+        triangles.emplace_back(pt::Vec3(-2, -1, 2), pt::Vec3(2, -1, -2), pt::Vec3(-2, -1, -2), white);
+        for (const auto& shape : spheres) {
+            scene.add(shape);
+        }
+        for (const auto& shape : triangles) {
+            scene.add(shape);
+        }
+        scene.compile();
+    }
+
+    pt::Material white, metal, light;
+    std::vector<pt::Sphere> spheres;
+    std::vector<pt::Triangle> triangles;
+    pt::Scene scene;
+    pt::Camera camera;
+};
+
+// Lights of different size and power around a diffuse sphere on the floor,
+// outside of the view so the image only shows the light they cast
+struct MultiLightScene {
+    MultiLightScene()
+        : white(pt::Vec3(0.8f), 1.0f, 0.0f)
+        , dimLight(pt::Vec3(1.0f), 1.0f, 0.0f, 0.0f, 1.5f, pt::Vec3(2.0f))
+        , mediumLight(pt::Vec3(1.0f), 1.0f, 0.0f, 0.0f, 1.5f, pt::Vec3(8.0f, 6.0f, 4.0f))
+        , brightLight(pt::Vec3(1.0f), 1.0f, 0.0f, 0.0f, 1.5f, pt::Vec3(40.0f))
+        , camera(pt::radians(60.0f), 1.5f, 0.0f, 0.0f,
+            pt::lookAt(pt::Vec3(0.0f, 0.2f, 2.5f), pt::Vec3(0.0f, -1.0f, 0.0f), pt::Vec3(0.0f, 1.0f, 0.0f)))
+    {
+        spheres.emplace_back(pt::Vec3(-1.5f, 1.0f, -0.5f), 0.3f, dimLight);
+        spheres.emplace_back(pt::Vec3(0.0f, 1.5f, -1.0f), 0.4f, mediumLight);
+        spheres.emplace_back(pt::Vec3(1.5f, 0.6f, 0.5f), 0.1f, brightLight);
+        spheres.emplace_back(pt::Vec3(0.0f, -0.5f, 0.0f), 0.5f, white);
+        triangles.emplace_back(pt::Vec3(-2, -1, 2), pt::Vec3(2, -1, 2), pt::Vec3(2, -1, -2), white);
+        triangles.emplace_back(pt::Vec3(-2, -1, 2), pt::Vec3(2, -1, -2), pt::Vec3(-2, -1, -2), white);
+        for (const auto& shape : spheres) {
+            scene.add(shape);
+        }
+        for (const auto& shape : triangles) {
+            scene.add(shape);
+        }
+        scene.compile();
+    }
+
+    pt::Material white, dimLight, mediumLight, brightLight;
+    std::vector<pt::Sphere> spheres;
+    std::vector<pt::Triangle> triangles;
+    pt::Scene scene;
+    pt::Camera camera;
+};
+
+bool filmsAreIdentical(const pt::Film& a, const pt::Film& b) {
+    for (uint32_t y = 0; y < a.getHeight(); y++) {
+        for (uint32_t x = 0; x < a.getWidth(); x++) {
+            if (a.getNumSamples(x, y) != b.getNumSamples(x, y)
+                    || a.getRelativeError(x, y) != b.getRelativeError(x, y)) {
+                return false;
+            }
+        }
+    }
+    return a.getImageBuffer(false) == b.getImageBuffer(false);
+}
+
+pt::Vec3 getMeanRadiance(const pt::Film& film) {
+    pt::Vec3 sum(0.0f);
+    std::vector<float> row(3 * film.getWidth());
+    for (uint32_t y = 0; y < film.getHeight(); y++) {
+        film.getRadianceRow(y, 0, film.getWidth() - 1, row.data());
+        for (uint32_t x = 0; x < film.getWidth(); x++) {
+            sum += pt::Vec3(row[3 * x], row[3 * x + 1], row[3 * x + 2]);
+        }
+    }
+    return sum / static_cast<float>(film.getWidth() * film.getHeight());
+}
+
+} // namespace
+
+TEST_CASE("Deterministic Rendering") {
+    TestScene testScene;
+    std::function<std::unique_ptr<pt::Sampler>(uint64_t)> createSampler;
+    SECTION("Random sampler") {
+        createSampler = [](uint64_t seed) { return std::make_unique<pt::RandomSampler>(8, seed); };
+    }
+    SECTION("CMJ sampler") {
+        createSampler = [](uint64_t seed) { return std::make_unique<pt::CMJSampler>(9, seed); };
+    }
+
+    auto renderFilm = [&](uint32_t numThreads, uint32_t tileSize, float adaptiveThreshold, uint64_t seed = 42) {
+        pt::Film film(24, 16);
+        pt::Renderer renderer;
+        renderer.setNumThreads(numThreads);
+        renderer.setTileSize(tileSize, tileSize);
+        renderer.setAdaptiveThreshold(adaptiveThreshold);
+        renderer.render(testScene.scene, testScene.camera, film, *createSampler(seed));
+        return film;
+    };
+
+    pt::Film referenceFilm = renderFilm(1, 8, 0.0f);
+    CHECK(referenceFilm.getTotalSamples() == 24 * 16 * createSampler(42)->getSamplesPerPixel());
+    CHECK(filmsAreIdentical(referenceFilm, renderFilm(3, 8, 0.0f)));
+    CHECK(filmsAreIdentical(referenceFilm, renderFilm(4, 5, 0.0f)));
+    CHECK(!filmsAreIdentical(referenceFilm, renderFilm(1, 8, 0.0f, 43)));
+
+    pt::Film adaptiveFilm = renderFilm(1, 8, 0.05f);
+    CHECK(filmsAreIdentical(adaptiveFilm, renderFilm(3, 4, 0.05f)));
+}
+
+TEST_CASE("Noise-aware Tile Scheduling") {
+    TestScene testScene;
+    const uint32_t spp = 16;
+    const uint64_t sampleBudget = 24 * 16 * spp;
+    auto renderFilm = [&](uint32_t numThreads, std::vector<size_t>& renderedTiles) {
+        pt::Film film(24, 16);
+        pt::CMJSampler sampler(spp, 11);
+        pt::Renderer renderer;
+        renderer.setTileScheduling(pt::TileScheduling::NoiseAware);
+        renderer.setNumThreads(numThreads);
+        renderer.setTileSize(8, 8);
+        renderer.setShowProgress(false);
+        std::mutex mutex;
+        renderer.setTileCallback([&](const pt::Film&, const pt::Film::Tile& tile) {
+            std::lock_guard<std::mutex> lock(mutex);
+            renderedTiles.push_back(tile.startX / 8 + 3 * (tile.startY / 8));
+        });
+        renderer.render(testScene.scene, testScene.camera, film, sampler);
+        return film;
+    };
+
+    // Tiles are handed out until the budget is spent, every worker can add at
+    // most one step of samples to a tile after that
+    std::vector<size_t> renderedTiles;
+    pt::Film film = renderFilm(1, renderedTiles);
+    CHECK(film.getTotalSamples() >= sampleBudget);
+    CHECK(film.getTotalSamples() <= sampleBudget + 64);
+    std::vector<size_t> threadedRenderedTiles;
+    pt::Film threadedFilm = renderFilm(3, threadedRenderedTiles);
+    CHECK(threadedFilm.getTotalSamples() >= sampleBudget);
+    CHECK(threadedFilm.getTotalSamples() <= sampleBudget + 3 * 64);
+
+    // Black tiles have no error to reduce, so they only get the first pass and
+    // their samples go to the noisy tiles
+    uint32_t numBlackTiles = 0;
+    uint32_t maxTileSamples = 0;
+    for (const pt::Film::Tile& tile : film.getTiles(8, 8)) {
+        bool isBlack = true;
+        uint32_t numSamples = film.getNumSamples(tile.startX, tile.startY);
+        std::vector<float> row(3 * 8);
+        for (uint32_t y = tile.startY; y <= tile.endY; y++) {
+            film.getRadianceRow(y, tile.startX, tile.endX, row.data());
+            for (float value : row) {
+                isBlack = isBlack && value == 0.0f;
+            }
+        }
+        size_t tileIndex = tile.startX / 8 + 3 * (tile.startY / 8);
+        size_t numRenders = std::count(renderedTiles.begin(), renderedTiles.end(), tileIndex);
+        if (isBlack) {
+            numBlackTiles++;
+            CHECK(numRenders == 1);
+            CHECK(numSamples == 2);
+        }
+        maxTileSamples = std::max(maxTileSamples, numSamples);
+    }
+    CHECK(numBlackTiles > 0);
+    CHECK(maxTileSamples > spp);
+}
+
+TEST_CASE("Out-of-core Rendering") {
+    TestScene testScene;
+    pt::CMJSampler sampler(4, 7);
+    pt::Renderer renderer;
+    renderer.setNumThreads(3);
+    renderer.setTileSize(5, 5);
+    renderer.setShowProgress(false);
+
+    pt::Film referenceFilm(24, 16);
+    referenceFilm.setCropWindow({ 3, 2, 20, 12 });
+    renderer.render(testScene.scene, testScene.camera, referenceFilm, sampler);
+
+    pt::Film layoutFilm(24, 16, { 0, 0, 0, 0 });
+    layoutFilm.setCropWindow(referenceFilm.getCropWindow());
+    pt::Film collectedFilm(24, 16);
+    collectedFilm.setCropWindow(referenceFilm.getCropWindow());
+    std::mutex mutex;
+    renderer.renderOutOfCore(testScene.scene, testScene.camera, layoutFilm, sampler,
+        [&](const pt::Film& tileFilm, const pt::Film::Tile& tile) {
+            std::lock_guard<std::mutex> lock(mutex);
+            collectedFilm.addTileData(tile, tileFilm.getTileData(tile));
+        });
+
+    CHECK(collectedFilm.getTotalSamples() == referenceFilm.getTotalSamples());
+    CHECK(filmsAreIdentical(referenceFilm, collectedFilm));
+}
+
+TEST_CASE("Resampled Direct Lighting") {
+    MultiLightScene testScene;
+    auto renderMean = [&](pt::LightSampling lightSampling, uint32_t candidates) {
+        pt::Film film(24, 16);
+        pt::CMJSampler sampler(256, 5);
+        pt::Renderer renderer;
+        renderer.setLightSampling(lightSampling);
+        renderer.setDirectLightCandidates(candidates);
+        renderer.setShowProgress(false);
+        renderer.render(testScene.scene, testScene.camera, film, sampler);
+        return getMeanRadiance(film);
+    };
+
+    // Resampling the light samples only changes the noise, with either way of
+    // picking the candidates
+    REQUIRE(testScene.scene.getNumLights() == 3);
+    pt::Vec3 reference = renderMean(pt::LightSampling::Power, 1);
+    for (pt::LightSampling lightSampling : { pt::LightSampling::Power, pt::LightSampling::BVH }) {
+        for (uint32_t candidates : { 1u, 8u }) {
+            pt::Vec3 mean = renderMean(lightSampling, candidates);
+            for (int i = 0; i < 3; i++) {
+                CHECK(mean[i] == pt::Approx(reference[i]).epsilon(0.02f * reference[i]));
+            }
+        }
+    }
+}
+
+TEST_CASE("Wavefront Rendering") {
+    TestScene testScene;
+    auto renderFilm = [&](pt::Integrator integrator, uint32_t numThreads, uint32_t tileSize,
+            float adaptiveThreshold = 0.0f) {
+        pt::Film film(24, 16);
+        pt::CMJSampler sampler(16, 3);
+        pt::Renderer renderer;
+        renderer.setIntegrator(integrator);
+        renderer.setNumThreads(numThreads);
+        renderer.setTileSize(tileSize, tileSize);
+        renderer.setAdaptiveThreshold(adaptiveThreshold);
+        renderer.setShowProgress(false);
+        renderer.render(testScene.scene, testScene.camera, film, sampler);
+        return film;
+    };
+    pt::Film wavefrontFilm = renderFilm(pt::Integrator::Wavefront, 1, 8);
+    CHECK(wavefrontFilm.getTotalSamples() == 24 * 16 * 16);
+    CHECK(filmsAreIdentical(wavefrontFilm, renderFilm(pt::Integrator::Wavefront, 3, 5)));
+
+    // The paths use the same samples, so only the rounding of the float math differs
+    pt::Vec3 reference = getMeanRadiance(renderFilm(pt::Integrator::Megakernel, 1, 8));
+    pt::Vec3 wavefront = getMeanRadiance(wavefrontFilm);
+    for (int i = 0; i < 3; i++) {
+        CHECK(wavefront[i] == pt::Approx(reference[i]).epsilon(0.01f * reference[i]));
+    }
+
+    pt::Film adaptiveFilm = renderFilm(pt::Integrator::Wavefront, 1, 8, 0.05f);
+    CHECK(filmsAreIdentical(adaptiveFilm, renderFilm(pt::Integrator::Wavefront, 3, 4, 0.05f)));
+}
+
+TEST_CASE("Path Guiding") {
+    TestScene testScene;
+    auto renderFilm = [&](bool pathGuiding, pt::Integrator integrator, uint32_t numThreads, uint32_t tileSize) {
+        pt::Film film(24, 16);
+        pt::CMJSampler sampler(256, 5);
+        pt::Renderer renderer;
+        renderer.setPathGuiding(pathGuiding);
+        renderer.setIntegrator(integrator);
+        renderer.setNumThreads(numThreads);
+        renderer.setTileSize(tileSize, tileSize);
+        renderer.setShowProgress(false);
+        renderer.render(testScene.scene, testScene.camera, film, sampler);
+        return film;
+    };
+
+    // The guiding field learns the same from any order of the records
+    pt::Film guidedFilm = renderFilm(true, pt::Integrator::Megakernel, 1, 8);
+    CHECK(guidedFilm.getTotalSamples() == 24 * 16 * 256);
+    CHECK(filmsAreIdentical(guidedFilm, renderFilm(true, pt::Integrator::Megakernel, 3, 5)));
+
+    // Guiding only changes the noise
+    pt::Vec3 reference = getMeanRadiance(renderFilm(false, pt::Integrator::Megakernel, 1, 8));
+    pt::Vec3 guided = getMeanRadiance(guidedFilm);
+    pt::Vec3 guidedWavefront = getMeanRadiance(renderFilm(true, pt::Integrator::Wavefront, 1, 8));
+    for (int i = 0; i < 3; i++) {
+        CHECK(guided[i] == pt::Approx(reference[i]).epsilon(0.02f * reference[i]));
+        CHECK(guidedWavefront[i] == pt::Approx(reference[i]).epsilon(0.02f * reference[i]));
+    }
+}
+
+TEST_CASE("Camera Path") {
+    pt::CameraPath path(1.5f);
+    CHECK(path.isEmpty());
+
+    const pt::Vec3 positions[] = { pt::Vec3(0.0f, 0.0f, 4.0f), pt::Vec3(2.0f, 1.0f, 3.0f), pt::Vec3(3.0f, 0.0f, 0.0f) };
+    const float frames[] = { 0.0f, 10.0f, 30.0f };
+    for (int i = 2; i >= 0; i--) {
+        pt::CameraKeyframe keyframe;
+        keyframe.frame = frames[i];
+        keyframe.position = positions[i];
+        keyframe.target = pt::Vec3(0.0f);
+        keyframe.fovY = 40.0f + 10.0f * i;
+        path.addKeyframe(keyframe);
+    }
+    CHECK(path.getFirstFrame() == 0.0f);
+    CHECK(path.getLastFrame() == 30.0f);
+
+    SECTION("Passes through the keyframes") {
+        for (int i = 0; i < 3; i++) {
+            pt::CameraKeyframe keyframe = path.evaluate(frames[i]);
+            CHECK(keyframe.position.x == pt::Approx(positions[i].x));
+            CHECK(keyframe.position.y == pt::Approx(positions[i].y));
+            CHECK(keyframe.position.z == pt::Approx(positions[i].z));
+            CHECK(keyframe.fovY == pt::Approx(40.0f + 10.0f * i));
+        }
+        CHECK(path.evaluate(20.0f).fovY == pt::Approx(55.0f));
+    }
+
+    SECTION("Clamps to the ends") {
+        CHECK(path.evaluate(-5.0f).position.z == pt::Approx(4.0f));
+        CHECK(path.evaluate(45.0f).position.x == pt::Approx(3.0f));
+    }
+
+    SECTION("Is continuous") {
+        for (float frame = 0.5f; frame < 30.0f; frame += 0.5f) {
+            pt::Vec3 step = path.evaluate(frame).position - path.evaluate(frame - 0.5f).position;
+            CHECK(pt::length(step) < 0.5f);
+        }
+    }
+
+    SECTION("Frames match single renders") {
+        TestScene testScene;
+        pt::Renderer renderer;
+        renderer.setNumThreads(2);
+        renderer.setTileSize(8, 8);
+        renderer.setShowProgress(false);
+        pt::CMJSampler sampler(4, 7);
+
+        // Renders the whole path with one scene, like a sequence
+        std::vector<pt::Film> frameFilms;
+        for (float frame : { 0.0f, 15.0f }) {
+            frameFilms.emplace_back(24, 16);
+            renderer.render(testScene.scene, path.getCamera(frame), frameFilms.back(), sampler);
+        }
+
+        pt::Film singleFilm(24, 16);
+        renderer.render(testScene.scene, path.getCamera(15.0f), singleFilm, sampler);
+        CHECK(filmsAreIdentical(frameFilms[1], singleFilm));
+        CHECK(!filmsAreIdentical(frameFilms[0], singleFilm));
+    }
+}
+
+TEST_CASE("Render Session") {
+    // Same scene as TestScene, but owned by the session
+    std::vector<pt::Material> materials = {
+        pt::Material(pt::Vec3(0.8f), 1.0f, 0.0f),
+        pt::Material(pt::Vec3(0.9f), 0.3f, 1.0f),
+        pt::Material(pt::Vec3(1.0f), 1.0f, 0.0f, 0.0f, 1.5f, pt::Vec3(10.0f))
+    };
+    std::vector<pt::Sphere> spheres;
+    spheres.emplace_back(pt::Vec3(0.0f, 2.0f, 0.0f), 0.5f, materials[2]);
+    spheres.emplace_back(pt::Vec3(-0.5f, -0.5f, 0.0f), 0.5f, materials[1]);
+    std::vector<pt::Triangle> triangles;
+    triangles.emplace_back(pt::Vec3(-2, -1, 2), pt::Vec3(2, -1, 2), pt::Vec3(2, -1, -2), materials[0]);
+    triangles.emplace_back(pt::Vec3(-2, -1, 2), pt::Vec3(2, -1, -2), pt::Vec3(-2, -1, -2), materials[0]);
+
+    TestScene testScene;
+    pt::Renderer renderer;
+    renderer.setNumThreads(2);
+    renderer.setTileSize(8, 8);
+    renderer.setShowProgress(false);
+    auto renderReference = [&](const pt::Camera& camera) {
+        pt::Film film(24, 16);
+        pt::CMJSampler sampler(4, 7);
+        renderer.render(testScene.scene, camera, film, sampler);
+        return film;
+    };
+
+    pt::Renderer sessionRenderer;
+    sessionRenderer.setNumThreads(2);
+    sessionRenderer.setTileSize(8, 8);
+    sessionRenderer.setShowProgress(false);
+    pt::RenderSession session(std::move(spheres), std::move(triangles), std::move(materials), testScene.camera,
+        pt::Film(24, 16), std::make_unique<pt::CMJSampler>(4, 7), std::move(sessionRenderer));
+    session.setMaxSamplesPerPass(4);
+    REQUIRE(session.getNumSceneBuilds() == 1);
+    CHECK(session.getScene().getNumLights() == 1);
+
+    // Passes of 1, 2 and the remaining sample of the 4 samples per pixel
+    while (session.renderPass()) {
+    }
+    CHECK(session.getNumPasses() == 3);
+    CHECK(session.isComplete());
+    CHECK(filmsAreIdentical(session.getFilm(), renderReference(testScene.camera)));
+
+    SECTION("Camera edits keep the scene") {
+        pt::Camera camera(pt::radians(50.0f), 1.5f, 0.0f, 0.0f,
+            pt::lookAt(pt::Vec3(1.0f, 0.5f, 4.0f), pt::Vec3(0.0f), pt::Vec3(0.0f, 1.0f, 0.0f)));
+        session.setCamera(camera);
+        CHECK_FALSE(session.isComplete());
+        REQUIRE(session.renderPass());
+        CHECK(session.getFilm().getTotalSamples() == 24 * 16);
+        while (session.renderPass()) {
+        }
+        CHECK(session.getNumSceneBuilds() == 1);
+        CHECK(filmsAreIdentical(session.getFilm(), renderReference(camera)));
+    }
+
+    SECTION("Material edits update the lights") {
+        testScene.metal = pt::Material(pt::Vec3(0.9f), 0.3f, 1.0f, 0.0f, 1.5f, pt::Vec3(2.0f));
+        testScene.scene.updateLights();
+        session.setMaterial(1, testScene.metal);
+        while (session.renderPass()) {
+        }
+        CHECK(session.getNumSceneBuilds() == 1);
+        CHECK(session.getScene().getNumLights() == 2);
+        // Both spheres have the same area, the lights are picked by emittance
+        const pt::Scene& scene = session.getScene();
+        CHECK(scene.getLightProbability(scene.getLights()[0]) == pt::Approx(10.0f / 12.0f));
+        CHECK(scene.getLightProbability(scene.getLights()[1]) == pt::Approx(2.0f / 12.0f));
+        CHECK(filmsAreIdentical(session.getFilm(), renderReference(testScene.camera)));
+    }
+
+    SECTION("Geometry edits rebuild the scene") {
+        session.editSpheres().pop_back();
+        while (session.renderPass()) {
+        }
+        CHECK(session.getNumSceneBuilds() == 2);
+        CHECK(!filmsAreIdentical(session.getFilm(), renderReference(testScene.camera)));
+    }
+}
+
+TEST_CASE("Preview Passes") {
+    TestScene testScene;
+    pt::Renderer renderer;
+    renderer.setNumThreads(2);
+    renderer.setTileSize(8, 8);
+    renderer.setShowProgress(false);
+    std::atomic<uint32_t> numTileCallbacks = 0;
+    renderer.setTileCallback([&](const pt::Film&, const pt::Film::Tile&) { numTileCallbacks++; });
+
+    pt::Film referenceFilm(48, 32);
+    renderer.render(testScene.scene, testScene.camera, referenceFilm, *std::make_unique<pt::CMJSampler>(4, 7));
+    uint32_t numReferenceTileCallbacks = numTileCallbacks.exchange(0);
+
+    std::vector<std::pair<uint32_t, uint32_t>> previewSizes;
+    renderer.setPreviewCallback([&](const pt::Film& previewFilm) {
+        previewSizes.emplace_back(previewFilm.getWidth(), previewFilm.getHeight());
+        CHECK(previewFilm.getTotalSamples() == previewFilm.getCropWindowArea());
+    });
+    pt::Film film(48, 32);
+    pt::CMJSampler sampler(4, 7);
+    renderer.render(testScene.scene, testScene.camera, film, sampler);
+
+    CHECK(previewSizes == std::vector<std::pair<uint32_t, uint32_t>>{ { 6, 4 }, { 12, 8 }, { 24, 16 } });
+    CHECK(numTileCallbacks == numReferenceTileCallbacks);
+    CHECK(filmsAreIdentical(film, referenceFilm));
+
+    SECTION("Crop windows are covered") {
+        previewSizes.clear();
+        pt::Film croppedFilm(48, 32);
+        croppedFilm.setCropWindow({ 13, 5, 30, 20 });
+        renderer.setPreviewCallback([&](const pt::Film& previewFilm) {
+            // The preview window maps onto the crop window, rounded outwards
+            const pt::Film::Tile& window = previewFilm.getCropWindow();
+            float scaleX = (previewFilm.getWidth() - 1) / 47.0f;
+            float scaleY = (previewFilm.getHeight() - 1) / 31.0f;
+            CHECK(window.startX <= 13 * scaleX);
+            CHECK(window.endX >= 30 * scaleX);
+            CHECK(window.startY <= 5 * scaleY);
+            CHECK(window.endY >= 20 * scaleY);
+            CHECK(window.endX < previewFilm.getWidth());
+            CHECK(window.endY < previewFilm.getHeight());
+            previewSizes.emplace_back(previewFilm.getWidth(), previewFilm.getHeight());
+        });
+        renderer.render(testScene.scene, testScene.camera, croppedFilm, sampler);
+        CHECK(previewSizes.size() == 3);
+    }
+
+    SECTION("Resumed renders skip the preview") {
+        previewSizes.clear();
+        renderer.render(testScene.scene, testScene.camera, film, sampler);
+        CHECK(previewSizes.empty());
+    }
+}
@@ -4,10 +4,19 @@
 #include "TestHelpers.h"
 #include "RandomSeries.h"
 #include "CMJSampler.h"
+#include "SobolSampler.h"
+#include "ZSobolSampler.h"
+#include "RandomSampler.h"
+#include "BufferedSampler.h"
+#include "AliasTable.h"
+#include "GuidingField.h"
+#include "BSDF.h"
 
 #include <array>
 #include <vector>
 #include <algorithm>
+#include <cmath>
+#include <functional>
 
 TEST_CASE("RandomSeries Uniform Sampling") {
     constexpr int numSamples = 1000000;
@@ -86,3 +95,502 @@ TEST_CASE("CMJ Sampling") {
         for (uint32_t count : substrataCols2D) CHECK(count == 1);
     }
 }
+
+TEST_CASE("CMJ Sample Index Jumps") {
+    constexpr uint32_t N = 16;
+    pt::CMJSampler sampler(N);
+    pt::CMJSampler jumpSampler(N);
+
+    sampler.startPixel(7);
+    for (uint32_t sampleIndex = 0; sampleIndex < 3 * N; sampleIndex++) {
+        float sample1D = sampler.get1D();
+        pt::Vec2 sample2D = sampler.get2D();
+
+        jumpSampler.startPixel(7);
+        jumpSampler.startSample(sampleIndex);
+        CHECK(jumpSampler.get1D() == sample1D);
+        pt::Vec2 jumpSample2D = jumpSampler.get2D();
+        CHECK(jumpSample2D.x == sample2D.x);
+        CHECK(jumpSample2D.y == sample2D.y);
+
+        sampler.startNextSample();
+    }
+}
+
+TEST_CASE("RandomSeries Advance") {
+    pt::RandomSeries rng;
+    pt::RandomSeries jumpRng;
+    jumpRng.advance(1000);
+    for (int i = 0; i < 1000; i++) {
+        rng.uniformUint32();
+    }
+    CHECK(jumpRng.uniformUint32() == rng.uniformUint32());
+}
+
+TEST_CASE("Alias Table Sampling") {
+    constexpr int numSamples = 1000000;
+    constexpr double significance = 0.05;
+
+    // Zero weights are never picked, a single large weight fills many bins
+    const std::vector<float> weights = { 1.0f, 0.0f, 7.5f, 0.25f, 3.0f, 0.0f, 100.0f, 2.0f, 0.01f, 4.0f };
+    double sum = 0.0;
+    for (float weight : weights) {
+        sum += weight;
+    }
+
+    pt::AliasTable table(weights);
+    REQUIRE(table.size() == weights.size());
+    std::vector<int> frequencies(weights.size(), 0);
+    pt::RandomSeries rng;
+    for (int i = 0; i < numSamples; i++) {
+        float probability;
+        size_t index = table.sample(rng.uniformFloat(), &probability);
+        REQUIRE(index < weights.size());
+        REQUIRE(probability == table.getProbability(index));
+        frequencies[index]++;
+    }
+
+    int dof = -1;
+    double criticalValue = 0.0;
+    for (size_t i = 0; i < weights.size(); i++) {
+        CHECK(table.getProbability(i) == pt::Approx(weights[i] / sum));
+        if (weights[i] == 0.0f) {
+            CHECK(frequencies[i] == 0);
+            continue;
+        }
+        double expected = weights[i] / sum * numSamples;
+        double diff = frequencies[i] - expected;
+        criticalValue += diff * diff / expected;
+        dof++;
+    }
+    double p = 1.0 - pt::chi2cdf(dof, criticalValue);
+    CHECK(p > significance);
+
+    SECTION("Zero weights are uniform") {
+        pt::AliasTable uniformTable(std::vector<float>(4, 0.0f));
+        for (int i = 0; i < 4; i++) {
+            CHECK(uniformTable.getProbability(i) == 0.25f);
+            CHECK(uniformTable.sample((i + 0.5f) / 4.0f) == static_cast<size_t>(i));
+        }
+        CHECK(uniformTable.sample(0.99999994f) == 3);
+    }
+}
+
+TEST_CASE("Guiding Field") {
+    pt::GuidingField field(pt::BoundingBox(pt::Vec3(-1.0f), pt::Vec3(1.0f)));
+    pt::RandomSeries rng;
+
+    SECTION("Directional Distribution") {
+        pt::Vec3 p(0.25f, -0.5f, 0.5f);
+        CHECK(field.getDistribution(p) == nullptr);
+
+        // Light from a cone around +z and a little from every other direction.
+        // Every update refines the quadtree where the last records had light.
+        auto isInCone = [](const pt::Vec3& direction) { return direction.z > 0.9f; };
+        for (int update = 0; update < 4; update++) {
+            for (int i = 0; i < 10000; i++) {
+                pt::Vec3 direction = pt::sampleUniformSphere(rng.uniformFloat(), rng.uniformFloat());
+                field.record(p, direction, isInCone(direction) ? 100.0f : 1.0f);
+            }
+            field.update();
+        }
+        CHECK(field.getNumRegions() == 1);
+
+        const pt::DirectionalQuadtree* distribution = field.getDistribution(p);
+        REQUIRE(distribution != nullptr);
+        CHECK(distribution->getNumNodes() > 1);
+
+        // The samples agree with the PDF (except for a few on the borders of the
+        // quadrants and at the poles), which integrates to one
+        constexpr int numSamples = 100000;
+        int numInCone = 0;
+        int numPdfMismatches = 0;
+        double pdfIntegral = 0.0;
+        for (int i = 0; i < numSamples; i++) {
+            float pdf;
+            pt::Vec3 direction = distribution->sample(rng.uniformFloat(), rng.uniformFloat(), pdf);
+            REQUIRE(pt::length(direction) == pt::Approx(1.0f));
+            if (std::abs(pdf - distribution->pdf(direction)) > 1e-3f * pdf) {
+                numPdfMismatches++;
+            }
+            numInCone += isInCone(direction) ? 1 : 0;
+
+            pt::Vec3 uniformDirection = pt::sampleUniformSphere(rng.uniformFloat(), rng.uniformFloat());
+            pdfIntegral += distribution->pdf(uniformDirection) * 4.0 * pt::pi<double> / numSamples;
+        }
+        CHECK(numPdfMismatches < numSamples / 1000);
+        CHECK(pdfIntegral == pt::Approx(1.0).epsilon(0.02));
+        // The cone covers 5% of the sphere and gets 84% of the light
+        CHECK(numInCone > 0.75 * numSamples);
+    }
+
+    SECTION("Spatial Splits") {
+        // The children of a split region start with its distribution
+        auto recordOctant = [&](int numRecords) {
+            for (int i = 0; i < numRecords; i++) {
+                pt::Vec3 point(rng.uniformFloat(), rng.uniformFloat(), rng.uniformFloat());
+                field.record(point, pt::Vec3(0.0f, 0.0f, 1.0f), 1.0f);
+            }
+            field.update();
+        };
+        recordOctant(20000);
+        CHECK(field.getNumRegions() == 8);
+        CHECK(field.getDistribution(pt::Vec3(0.5f)) != nullptr);
+        CHECK(field.getDistribution(pt::Vec3(-0.5f)) != nullptr);
+
+        // Below the limit of the second update, which is higher by sqrt(2)
+        recordOctant(10000);
+        CHECK(field.getNumRegions() == 8);
+        CHECK(field.getDistribution(pt::Vec3(0.5f)) != nullptr);
+        CHECK(field.getDistribution(pt::Vec3(-0.5f)) == nullptr);
+    }
+}
+
+TEST_CASE("Batched Sample Generation") {
+    // Camera and two bounces like in the renderer
+    pt::SampleLayout layout;
+    layout.add2D();
+    layout.add2D();
+    layout.endGroup();
+    for (int i = 0; i < 2; i++) {
+        layout.add1D();
+        layout.add2D();
+        layout.add2D();
+        layout.add1D();
+        layout.endGroup();
+    }
+    REQUIRE(layout.getNumCalls() == 10);
+    REQUIRE(layout.getNumFloats() == 16);
+
+    // The batch crosses the samples per pixel into the next pattern
+    constexpr uint32_t firstSample = 5;
+    constexpr uint32_t numSamples = 20;
+    auto checkSampler = [&](pt::Sampler& sampler) {
+        sampler.startPixel(37);
+        // The values of every float for all samples
+        std::vector<float> expected(numSamples * layout.getNumFloats());
+        for (uint32_t s = 0; s < numSamples; s++) {
+            sampler.startSample(firstSample + s);
+            for (uint32_t call = 0; call < layout.getNumCalls(); call++) {
+                size_t index = layout.getFloatOffset(call) * numSamples + s;
+                if (layout.getCallSize(call) == 1) {
+                    expected[index] = sampler.get1D();
+                }
+                else {
+                    pt::Vec2 value = sampler.get2D();
+                    expected[index] = value.x;
+                    expected[index + numSamples] = value.y;
+                }
+            }
+        }
+
+        std::vector<float> samples(numSamples * layout.getNumFloats());
+        sampler.startPixel(37);
+        sampler.generateSamples(layout, 0, layout.getNumCalls(), firstSample, numSamples, samples.data(), numSamples);
+        CHECK(samples == expected);
+
+        // Groups are generated on demand, sample by sample the values are the same
+        pt::BufferedSampler<pt::Sampler> bufferedSampler(sampler, layout);
+        bufferedSampler.startPixel(37);
+        bufferedSampler.startSamples(firstSample, numSamples);
+        for (uint32_t s = 0; s < numSamples; s++) {
+            // Later samples end the path early
+            uint32_t numCalls = s < 3 ? layout.getNumCalls() : 2;
+            for (uint32_t call = 0; call < numCalls; call++) {
+                size_t index = layout.getFloatOffset(call) * numSamples + s;
+                if (layout.getCallSize(call) == 1) {
+                    CHECK(bufferedSampler.get1D() == expected[index]);
+                }
+                else {
+                    pt::Vec2 value = bufferedSampler.get2D();
+                    CHECK(value.x == expected[index]);
+                    CHECK(value.y == expected[index + numSamples]);
+                }
+            }
+            bufferedSampler.startNextSample();
+        }
+    };
+
+    SECTION("Random") {
+        pt::RandomSampler sampler(8, 3);
+        checkSampler(sampler);
+    }
+    SECTION("CMJ") {
+        pt::CMJSampler sampler(9, 3);
+        checkSampler(sampler);
+    }
+    SECTION("Sobol") {
+        pt::SobolSampler sampler(8, 3);
+        checkSampler(sampler);
+    }
+    SECTION("ZSobol") {
+        pt::ZSobolSampler sampler(8, 16, 16, 3);
+        checkSampler(sampler);
+    }
+}
+
+TEST_CASE("Sobol Sampling") {
+    constexpr uint32_t log2N = 8;
+    constexpr uint32_t N = 1 << log2N;
+
+    // Every 2D dimension is a (0, 8, 2)-net: each elementary interval of area
+    // 1/N contains exactly one sample, for all shapes 2^k x 2^(8-k)
+    pt::SobolSampler sampler(N, 3);
+    std::vector<float> samples1D(N);
+    std::vector<pt::Vec2> samples2D(N);
+    for (uint32_t pixelIndex = 0; pixelIndex < 10; pixelIndex++) {
+        for (uint32_t dimension = 0; dimension < 4; dimension++) {
+            sampler.startPixel(pixelIndex);
+            for (uint32_t sampleIndex = 0; sampleIndex < N; sampleIndex++) {
+                // Skips the dimensions before the tested one
+                for (uint32_t i = 0; i < dimension; i++) {
+                    sampler.get1D();
+                    sampler.get2D();
+                }
+                samples1D[sampleIndex] = sampler.get1D();
+                samples2D[sampleIndex] = sampler.get2D();
+                sampler.startNextSample();
+            }
+
+            std::vector<uint32_t> strata(N, 0);
+            for (float sample : samples1D) {
+                REQUIRE(sample >= 0.0f);
+                REQUIRE(sample < 1.0f);
+                strata[static_cast<uint32_t>(sample * N)]++;
+            }
+            CHECK(std::all_of(strata.begin(), strata.end(), [](uint32_t count) { return count == 1; }));
+
+            for (uint32_t log2X = 0; log2X <= log2N; log2X++) {
+                uint32_t numX = 1 << log2X;
+                uint32_t numY = N >> log2X;
+                std::fill(strata.begin(), strata.end(), 0);
+                for (const pt::Vec2& sample : samples2D) {
+                    REQUIRE(sample.x < 1.0f);
+                    REQUIRE(sample.y < 1.0f);
+                    strata[static_cast<uint32_t>(sample.x * numX) + static_cast<uint32_t>(sample.y * numY) * numX]++;
+                }
+                CHECK(std::all_of(strata.begin(), strata.end(), [](uint32_t count) { return count == 1; }));
+            }
+        }
+    }
+}
+
+TEST_CASE("Sobol Sample Index Jumps") {
+    constexpr uint32_t N = 16;
+    pt::SobolSampler sampler(N);
+    pt::SobolSampler jumpSampler(N);
+
+    sampler.startPixel(7);
+    for (uint32_t sampleIndex = 0; sampleIndex < 3 * N; sampleIndex++) {
+        float sample1D = sampler.get1D();
+        pt::Vec2 sample2D = sampler.get2D();
+
+        jumpSampler.startPixel(7);
+        jumpSampler.startSample(sampleIndex);
+        CHECK(jumpSampler.get1D() == sample1D);
+        pt::Vec2 jumpSample2D = jumpSampler.get2D();
+        CHECK(jumpSample2D.x == sample2D.x);
+        CHECK(jumpSample2D.y == sample2D.y);
+
+        sampler.startNextSample();
+    }
+
+    // Clones start with the same samples, other pixels and seeds get different ones
+    auto clone = sampler.clone();
+    clone->startPixel(7);
+    sampler.startPixel(7);
+    CHECK(clone->get1D() == sampler.get1D());
+    sampler.startPixel(8);
+    clone = pt::SobolSampler(N, 1).clone();
+    clone->startPixel(7);
+    pt::SobolSampler other(N);
+    other.startPixel(7);
+    float first = other.get1D();
+    CHECK(sampler.get1D() != first);
+    CHECK(clone->get1D() != first);
+}
+
+namespace {
+
+// RMSE of the per-pixel estimates of the integral of f over [0, 1)^2. The 2D
+// dimension is the given one of the sampler, to cover deep paths as well.
+double computeIntegrationRmse(pt::Sampler& sampler, uint32_t dimension,
+        const std::function<double(float, float)>& f, double expected) {
+    constexpr uint32_t numPixels = 512;
+    double sumSquaredError = 0.0;
+    for (uint32_t pixelIndex = 0; pixelIndex < numPixels; pixelIndex++) {
+        sampler.startPixel(pixelIndex);
+        double sum = 0.0;
+        for (uint32_t s = 0; s < sampler.getSamplesPerPixel(); s++) {
+            for (uint32_t i = 0; i < dimension; i++) {
+                sampler.get2D();
+            }
+            pt::Vec2 u = sampler.get2D();
+            sum += f(u.x, u.y);
+            sampler.startNextSample();
+        }
+        double error = sum / sampler.getSamplesPerPixel() - expected;
+        sumSquaredError += error * error;
+    }
+    return std::sqrt(sumSquaredError / numPixels);
+}
+
+} // namespace
+
+TEST_CASE("Sampler Convergence") {
+    // A smooth integrand and a discontinuous one like the visibility of a light
+    auto smooth = [](float x, float y) { return x * x * y + std::sin(pt::pi<float> * y) * x; };
+    const double smoothIntegral = 1.0 / 6.0 + 1.0 / pt::pi<double>;
+    auto disk = [](float x, float y) { return x * x + y * y < 1.0f ? 1.0 : 0.0; };
+    const double diskIntegral = pt::pi<double> / 4.0;
+
+    for (uint32_t dimension : { 0u, 20u }) {
+        double smoothRmse[2], diskRmse[2];
+        for (int i = 0; i < 2; i++) {
+            uint32_t N = i == 0 ? 16 : 256;
+            pt::SobolSampler sobol(N);
+            pt::RandomSampler random(N);
+            pt::CMJSampler cmj(N);
+            smoothRmse[i] = computeIntegrationRmse(sobol, dimension, smooth, smoothIntegral);
+            diskRmse[i] = computeIntegrationRmse(sobol, dimension, disk, diskIntegral);
+
+            // Far better than random and on par with CMJ
+            CHECK(smoothRmse[i] < 0.25 * computeIntegrationRmse(random, dimension, smooth, smoothIntegral));
+            CHECK(diskRmse[i] < 0.6 * computeIntegrationRmse(random, dimension, disk, diskIntegral));
+            CHECK(smoothRmse[i] < 1.25 * computeIntegrationRmse(cmj, dimension, smooth, smoothIntegral));
+            CHECK(diskRmse[i] < 1.25 * computeIntegrationRmse(cmj, dimension, disk, diskIntegral));
+        }
+
+        // Owen scrambling converges with O(N^-1.5) for smooth integrands and about
+        // O(N^-0.75) for discontinuities, random sampling only with O(N^-0.5)
+        CHECK(smoothRmse[0] / smoothRmse[1] > 32.0);
+        CHECK(diskRmse[0] / diskRmse[1] > 6.0);
+    }
+}
+
+TEST_CASE("ZSobol Sampling") {
+    for (uint32_t log2N : { 4u, 5u }) {
+        const uint32_t N = 1 << log2N;
+
+        // The samples of every pixel are a (0, log2N, 2)-net in every dimension
+        pt::ZSobolSampler sampler(N, 7, 5, 11);
+        CHECK(sampler.getSamplesPerPixel() == N);
+        std::vector<pt::Vec2> samples(N);
+        for (uint32_t pixelIndex = 0; pixelIndex < 35; pixelIndex++) {
+            for (uint32_t dimension = 0; dimension < 4; dimension++) {
+                sampler.startPixel(pixelIndex);
+                for (uint32_t sampleIndex = 0; sampleIndex < N; sampleIndex++) {
+                    for (uint32_t i = 0; i < dimension; i++) {
+                        sampler.get2D();
+                    }
+                    samples[sampleIndex] = sampler.get2D();
+                    sampler.startNextSample();
+                }
+
+                bool isStratified = true;
+                for (uint32_t log2X = 0; log2X <= log2N; log2X++) {
+                    uint32_t numX = 1 << log2X;
+                    uint32_t numY = N >> log2X;
+                    std::vector<uint32_t> strata(N, 0);
+                    for (const pt::Vec2& sample : samples) {
+                        REQUIRE(sample.x < 1.0f);
+                        REQUIRE(sample.y < 1.0f);
+                        strata[static_cast<uint32_t>(sample.x * numX) + static_cast<uint32_t>(sample.y * numY) * numX]++;
+                    }
+                    isStratified &= std::all_of(strata.begin(), strata.end(), [](uint32_t count) { return count == 1; });
+                }
+                CHECK(isStratified);
+            }
+        }
+    }
+
+    SECTION("Samples per pixel are rounded up to powers of two") {
+        CHECK(pt::ZSobolSampler(5, 8, 8).getSamplesPerPixel() == 8);
+        CHECK(pt::ZSobolSampler(1, 8, 8).getSamplesPerPixel() == 1);
+    }
+
+    SECTION("Sample index jumps") {
+        pt::ZSobolSampler sampler(8, 16, 16);
+        auto jumpSampler = sampler.clone();
+        sampler.startPixel(37);
+        for (uint32_t sampleIndex = 0; sampleIndex < 24; sampleIndex++) {
+            float sample1D = sampler.get1D();
+            pt::Vec2 sample2D = sampler.get2D();
+
+            jumpSampler->startPixel(37);
+            jumpSampler->startSample(sampleIndex);
+            CHECK(jumpSampler->get1D() == sample1D);
+            pt::Vec2 jumpSample2D = jumpSampler->get2D();
+            CHECK(jumpSample2D.x == sample2D.x);
+            CHECK(jumpSample2D.y == sample2D.y);
+
+            sampler.startNextSample();
+        }
+    }
+}
+
+namespace {
+
+// RMSE of the per-pixel estimates of an integral over an image, and of the
+// averages of 4x4 pixel blocks, i.e. of the low frequencies of the error
+void computeImageErrors(pt::Sampler& sampler, uint32_t size, const std::function<double(float, float)>& f,
+        double expected, double& pixelRmse, double& blockRmse) {
+    std::vector<double> errors(size * size);
+    for (uint32_t pixelIndex = 0; pixelIndex < size * size; pixelIndex++) {
+        sampler.startPixel(pixelIndex);
+        double sum = 0.0;
+        for (uint32_t s = 0; s < sampler.getSamplesPerPixel(); s++) {
+            sampler.get2D(); // Like the pixel offset of the renderer
+            pt::Vec2 u = sampler.get2D();
+            sum += f(u.x, u.y);
+            sampler.startNextSample();
+        }
+        errors[pixelIndex] = sum / sampler.getSamplesPerPixel() - expected;
+    }
+
+    double sumSquared = 0.0;
+    double blockSumSquared = 0.0;
+    for (uint32_t blockY = 0; blockY < size; blockY += 4) {
+        for (uint32_t blockX = 0; blockX < size; blockX += 4) {
+            double blockError = 0.0;
+            for (uint32_t y = blockY; y < blockY + 4; y++) {
+                for (uint32_t x = blockX; x < blockX + 4; x++) {
+                    blockError += errors[x + y * size] / 16.0;
+                    sumSquared += errors[x + y * size] * errors[x + y * size];
+                }
+            }
+            blockSumSquared += blockError * blockError;
+        }
+    }
+    pixelRmse = std::sqrt(sumSquared / (size * size));
+    blockRmse = std::sqrt(blockSumSquared / (size * size / 16));
+}
+
+} // namespace
+
+TEST_CASE("ZSobol Blue Noise Error") {
+    // The error of each pixel is about as large as with independent pixels, but
+    // neighbors compensate each other, so little error is left in low frequencies.
+    // A block has the error of 16 times the samples in one sequence, which helps
+    // smooth integrands much more than discontinuous ones. All pixels share the
+    // coarse levels of the scrambling, so their error varies more with the seed.
+    auto smooth = [](float x, float y) { return x * x * y + std::sin(pt::pi<float> * y) * x; };
+    const double smoothIntegral = 1.0 / 6.0 + 1.0 / pt::pi<double>;
+    auto disk = [](float x, float y) { return x * x + y * y < 1.0f ? 1.0 : 0.0; };
+    const double diskIntegral = pt::pi<double> / 4.0;
+
+    for (uint32_t N : { 1u, 4u, 16u }) {
+        pt::ZSobolSampler zsobol(N, 64, 64, 3);
+        pt::SobolSampler sobol(N, 3);
+        double zsobolPixelRmse, zsobolBlockRmse, sobolPixelRmse, sobolBlockRmse;
+        computeImageErrors(zsobol, 64, smooth, smoothIntegral, zsobolPixelRmse, zsobolBlockRmse);
+        computeImageErrors(sobol, 64, smooth, smoothIntegral, sobolPixelRmse, sobolBlockRmse);
+        CHECK(zsobolPixelRmse < 1.5 * sobolPixelRmse);
+        CHECK(zsobolBlockRmse < 0.25 * sobolBlockRmse);
+
+        computeImageErrors(zsobol, 64, disk, diskIntegral, zsobolPixelRmse, zsobolBlockRmse);
+        computeImageErrors(sobol, 64, disk, diskIntegral, sobolPixelRmse, sobolBlockRmse);
+        CHECK(zsobolPixelRmse < 1.5 * sobolPixelRmse);
+        CHECK(zsobolBlockRmse < 0.75 * sobolBlockRmse);
+    }
+}
@@ -6,7 +6,9 @@
 #include "Sphere.h"
 #include "Triangle.h"
 #include "BVH.h"
+#include "LightBVH.h"
 #include "RandomSeries.h"
+#include "RayStream.h"
 #include "BSDF.h"
 
 #include <vector>
@@ -257,6 +259,20 @@ TEST_CASE("Triangle") {
         REQUIRE(box.max == pt::ApproxVec3(1.0f, 1.0f, 0.0f));
     }
 
+    SECTION("Direction Sampling") {
+        REQUIRE(triangle.getArea() == pt::Approx(2.0f));
+
+        // The sampled PDF in solid angle matches the one of the direction
+        pt::RandomSeries rng;
+        pt::Vec3 p(0.2f, 0.1f, 1.5f);
+        for (int i = 0; i < 1000; i++) {
+            float pdf;
+            pt::Vec3 dir = triangle.sampleDirection(p, rng.uniformFloat(), rng.uniformFloat(), &pdf);
+            REQUIRE(pdf > 0.0f);
+            REQUIRE(pdf == pt::Approx(triangle.pdf(p, dir)).epsilon(1e-3f));
+        }
+    }
+
     /*SECTION("Watertight") {
         constexpr float radius = 100.0f;
         constexpr size_t numSlices = 128;
@@ -368,4 +384,198 @@ TEST_CASE("Bounding Volume Hierarchy") {
             }
         }
     }
+
+    SECTION("Ray Streams") {
+        pt::RandomSeries rng;
+        std::vector<pt::Ray> rays;
+        for (int i = 0; i < 200; i++) {
+            pt::Vec3 origin(rng.uniformFloat() * 40.0f - 15.0f, rng.uniformFloat() * 4.0f - 2.0f, 5.0f);
+            pt::Vec3 target(rng.uniformFloat() * 30.0f - 10.0f, rng.uniformFloat() * 2.0f - 1.0f, 0.0f);
+            rays.emplace_back(origin, pt::normalize(target - origin));
+        }
+
+        // Traces every other ray, so the stream also covers rays that are left out
+        pt::RayStream stream;
+        stream.resize(rays.size());
+        std::vector<uint32_t> indices;
+        for (uint32_t i = 0; i < rays.size(); i += 2) {
+            indices.push_back(i);
+        }
+
+        for (int maxShapesPerLeaf = 1; maxShapesPerLeaf < 3; maxShapesPerLeaf++) {
+            pt::BVH bvh(shapes, maxShapesPerLeaf);
+            for (size_t i = 0; i < rays.size(); i++) {
+                stream.setRay(i, rays[i]);
+                stream.hitShapes[i] = &spheres.front();
+            }
+            bvh.intersect(stream, indices);
+            for (size_t i = 0; i < rays.size(); i++) {
+                if (i % 2 == 1) {
+                    REQUIRE(stream.hitShapes[i] == &spheres.front());
+                    continue;
+                }
+                pt::RayHit hit = bvh.intersect(rays[i]);
+                REQUIRE(stream.hitShapes[i] == hit.shape);
+                if (hit.shape) {
+                    REQUIRE(stream.hitDistances[i] == pt::Approx(hit.t));
+                }
+            }
+
+            // Nothing is in front of the closest hit, but the hit itself occludes a longer ray
+            for (size_t i = 0; i < rays.size(); i++) {
+                pt::Ray ray = rays[i];
+                pt::RayHit hit = bvh.intersect(ray);
+                ray.tmax = hit.shape ? 0.99f * hit.t : pt::inf<float>;
+                stream.setRay(i, ray);
+            }
+            bvh.intersectAny(stream, indices);
+            for (uint32_t i : indices) {
+                REQUIRE(stream.hitShapes[i] == nullptr);
+            }
+
+            for (size_t i = 0; i < rays.size(); i++) {
+                stream.setRay(i, rays[i]);
+            }
+            bvh.intersectAny(stream, indices);
+            for (uint32_t i : indices) {
+                REQUIRE((stream.hitShapes[i] != nullptr) == (bvh.intersect(rays[i]).shape != nullptr));
+            }
+        }
+    }
+}
+
+
+TEST_CASE("Direction Cone") {
+    pt::DirectionCone x(pt::Vec3(1.0f, 0.0f, 0.0f), 1.0f);
+    pt::DirectionCone y(pt::Vec3(0.0f, 1.0f, 0.0f), 1.0f);
+
+    // Two directions 90 degrees apart are 45 degrees from the new axis
+    pt::DirectionCone cone = pt::merge(x, y);
+    CHECK(cone.axis == pt::ApproxVec3(std::sqrt(0.5f), std::sqrt(0.5f), 0.0f));
+    CHECK(cone.cosTheta == pt::Approx(std::sqrt(0.5f)));
+
+    // A cone within the other one doesn't change it
+    pt::DirectionCone wide(pt::Vec3(1.0f, 0.0f, 0.0f), 0.0f);
+    CHECK(std::abs(pt::merge(wide, cone).cosTheta) < 1e-6f);
+    CHECK(pt::merge(cone, wide).axis == pt::ApproxVec3(1.0f, 0.0f, 0.0f));
+
+    // Opposite directions need the whole sphere
+    pt::DirectionCone minusX(pt::Vec3(-1.0f, 0.0f, 0.0f), 1.0f);
+    CHECK(pt::merge(x, minusX).cosTheta == -1.0f);
+    CHECK(pt::merge(x, pt::DirectionCone::entireSphere()).cosTheta == -1.0f);
+}
+
+
+TEST_CASE("Light BVH") {
+    pt::Material bright(pt::Vec3(1.0f), 1.0f, 0.0f, 0.0f, 1.5f, pt::Vec3(20.0f));
+    pt::Material dim(pt::Vec3(1.0f), 1.0f, 0.0f, 0.0f, 1.5f, pt::Vec3(0.5f, 1.0f, 2.0f));
+
+    // A grid of small triangles facing up or down with a few stacked on top of
+    // each other, and a spherical light
+    std::vector<pt::Triangle> triangles;
+    for (int z = 0; z < 8; z++) {
+        for (int x = 0; x < 8; x++) {
+            pt::Vec3 v0(x - 4.0f, 0.0f, z - 4.0f);
+            pt::Vec3 v1 = v0 + pt::Vec3(0.0f, 0.0f, 0.5f);
+            pt::Vec3 v2 = v0 + pt::Vec3(0.5f, 0.0f, 0.0f);
+            const pt::Material& material = (x + z) % 3 == 0 ? bright : dim;
+            if (x == 7) {
+                triangles.emplace_back(v0, v2, v1, material);
+            }
+            else {
+                triangles.emplace_back(v0, v1, v2, material);
+            }
+        }
+    }
+    for (int i = 0; i < 4; i++) {
+        triangles.emplace_back(pt::Vec3(0.0f, 2.0f, 0.0f), pt::Vec3(0.0f, 2.0f, 1.0f), pt::Vec3(1.0f, 2.0f, 0.0f), dim);
+    }
+    pt::Sphere sphere(pt::Vec3(3.0f, 3.0f, -2.0f), 0.5f, bright);
+
+    std::vector<const pt::Shape*> lights;
+    for (const auto& triangle : triangles) {
+        lights.push_back(&triangle);
+    }
+    lights.push_back(&sphere);
+    pt::LightBVH bvh(lights);
+    REQUIRE(bvh.getNumNodes() == 2 * lights.size() - 1);
+
+    const pt::Vec3 points[] = { pt::Vec3(0.3f, 1.0f, 0.2f), pt::Vec3(-3.0f, 0.5f, 3.0f), pt::Vec3(10.0f, 4.0f, -7.0f) };
+    const pt::Vec3 normals[] = { pt::Vec3(0.0f, -1.0f, 0.0f), pt::Vec3(0.0f, 0.0f, 1.0f), pt::normalize(pt::Vec3(-1.0f, -1.0f, 0.0f)) };
+
+    SECTION("Probabilities") {
+        // Nodes can reach a point when none of their lights do, that
+        // probability is lost and no light is sampled
+        for (int i = 0; i < 3; i++) {
+            float sum = 0.0f;
+            for (uint32_t lightIndex = 0; lightIndex < lights.size(); lightIndex++) {
+                sum += bvh.getProbability(points[i], normals[i], lightIndex);
+            }
+            CHECK(sum > 0.9f);
+            CHECK(sum <= 1.0f + 1e-5f);
+        }
+
+        // Only the triangles facing down reach a point below the grid, their
+        // probability falls off with the distance
+        pt::Vec3 below(-3.4f, -0.5f, -3.4f);
+        for (uint32_t lightIndex = 0; lightIndex < triangles.size(); lightIndex++) {
+            bool isFacingDown = lightIndex % 8 == 7;
+            CHECK((bvh.getProbability(below, pt::Vec3(0.0f, 1.0f, 0.0f), lightIndex) > 0.0f) == isFacingDown);
+        }
+        CHECK(bvh.getProbability(below, pt::Vec3(0.0f, 1.0f, 0.0f), 7) > bvh.getProbability(below, pt::Vec3(0.0f, 1.0f, 0.0f), 63));
+    }
+
+    SECTION("Sampling") {
+        constexpr int numSamples = 200000;
+        constexpr double significance = 0.01;
+
+        pt::RandomSeries rng;
+        for (int i = 0; i < 3; i++) {
+            // The last bin counts the samples without a light
+            std::vector<int> frequencies(lights.size() + 1, 0);
+            for (int s = 0; s < numSamples; s++) {
+                uint32_t lightIndex;
+                float probability;
+                if (!bvh.sample(points[i], normals[i], rng.uniformFloat(), lightIndex, probability)) {
+                    frequencies.back()++;
+                    continue;
+                }
+                REQUIRE(lightIndex < lights.size());
+                REQUIRE(probability == pt::Approx(bvh.getProbability(points[i], normals[i], lightIndex)));
+                frequencies[lightIndex]++;
+            }
+
+            int dof = -1;
+            double criticalValue = 0.0;
+            double sum = 0.0;
+            for (uint32_t bin = 0; bin <= lights.size(); bin++) {
+                double probability = bin < lights.size() ? bvh.getProbability(points[i], normals[i], bin) : 1.0 - sum;
+                sum += probability;
+                double expected = probability * numSamples;
+                if (expected < 1.0) {
+                    CHECK(frequencies[bin] <= 2);
+                    continue;
+                }
+                double diff = frequencies[bin] - expected;
+                criticalValue += diff * diff / expected;
+                dof++;
+            }
+            double p = 1.0 - pt::chi2cdf(dof, criticalValue);
+            CHECK(p > significance);
+        }
+    }
+
+    SECTION("Lights out of reach") {
+        // Behind the only light
+        pt::LightBVH singleLight({ &triangles[0] });
+        uint32_t lightIndex;
+        float probability;
+        CHECK(singleLight.sample(pt::Vec3(0.0f, 1.0f, 0.0f), pt::Vec3(0.0f), 0.5f, lightIndex, probability));
+        CHECK(probability == 1.0f);
+        CHECK_FALSE(singleLight.sample(pt::Vec3(0.0f, -1.0f, 0.0f), pt::Vec3(0.0f), 0.5f, lightIndex, probability));
+        CHECK(singleLight.getProbability(pt::Vec3(0.0f, -1.0f, 0.0f), pt::Vec3(0.0f), 0) == 0.0f);
+
+        pt::LightBVH noLights(std::vector<const pt::Shape*>{});
+        CHECK_FALSE(noLights.sample(pt::Vec3(0.0f), pt::Vec3(0.0f), 0.5f, lightIndex, probability));
+    }
 }
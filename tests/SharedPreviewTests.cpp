@@ -0,0 +1,181 @@
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "Film.h"
+#include "SharedPreview.h"
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+
+TEST_CASE("Shared Preview") {
+    const std::string name = "/pt_shared_preview_test";
+    pt::Film film(40, 30);
+    for (uint32_t y = 0; y < 30; y++) {
+        for (uint32_t x = 0; x < 40; x++) {
+            film.addSample(x, y, pt::Vec3(x / 40.0f, y / 30.0f, 0.5f));
+        }
+    }
+
+    SECTION("Tonemapped") {
+        pt::SharedPreviewPublisher publisher(name, 40, 30, pt::PreviewFormat::Tonemapped);
+        REQUIRE(publisher.isValid());
+
+        pt::SharedPreviewReader reader;
+        REQUIRE(reader.open(name));
+        CHECK(reader.getWidth() == 40);
+        CHECK(reader.getHeight() == 30);
+        CHECK(reader.getFormat() == pt::PreviewFormat::Tonemapped);
+
+        std::vector<uint8_t> pixels;
+        uint64_t generation;
+        REQUIRE(reader.read(pixels, generation));
+        CHECK(generation == 0);
+        CHECK(pixels == std::vector<uint8_t>(40 * 30 * 3, 0));
+
+        publisher.publishTile(film, { 8, 4, 15, 11 });
+        REQUIRE(reader.read(pixels, generation));
+        CHECK(generation == 1);
+        auto image = film.getImageBuffer();
+        bool isTileEqual = true;
+        for (uint32_t y = 0; y < 30; y++) {
+            for (uint32_t x = 0; x < 40; x++) {
+                bool isInTile = x >= 8 && x <= 15 && y >= 4 && y <= 11;
+                for (int c = 0; c < 3; c++) {
+                    size_t index = (y * 40 + x) * 3 + c;
+                    isTileEqual &= pixels[index] == (isInTile ? image[index] : 0);
+                }
+            }
+        }
+        CHECK(isTileEqual);
+
+        CHECK_FALSE(reader.isFinished());
+        publisher.publishFilm(film);
+        publisher.setFinished();
+        REQUIRE(reader.read(pixels, generation));
+        CHECK(pixels == image);
+        CHECK(reader.isFinished());
+    }
+
+    SECTION("Radiance") {
+        pt::SharedPreviewPublisher publisher(name, 40, 30, pt::PreviewFormat::Radiance);
+        REQUIRE(publisher.isValid());
+        publisher.publishFilm(film);
+
+        pt::SharedPreviewReader reader;
+        REQUIRE(reader.open(name));
+        std::vector<uint8_t> pixels;
+        uint64_t generation;
+        REQUIRE(reader.read(pixels, generation));
+        REQUIRE(pixels.size() == 40 * 30 * 3 * sizeof(float));
+
+        std::vector<float> row(40 * 3);
+        film.getRadianceRow(17, 0, 39, row.data());
+        CHECK(std::memcmp(row.data(), &pixels[17 * row.size() * sizeof(float)], row.size() * sizeof(float)) == 0);
+    }
+
+    SECTION("Upsampled preview films") {
+        pt::SharedPreviewPublisher publisher(name, 40, 30, pt::PreviewFormat::Radiance);
+        REQUIRE(publisher.isValid());
+
+        // Every pixel of the preview film has a unique value
+        pt::Film previewFilm(5, 4);
+        for (uint32_t y = 0; y < 4; y++) {
+            for (uint32_t x = 0; x < 5; x++) {
+                previewFilm.addSample(x, y, pt::Vec3(static_cast<float>(x), static_cast<float>(y), 1.0f));
+            }
+        }
+        publisher.publishUpsampled(previewFilm, { 0, 0, 39, 29 });
+
+        pt::SharedPreviewReader reader;
+        REQUIRE(reader.open(name));
+        std::vector<uint8_t> pixels;
+        uint64_t generation;
+        REQUIRE(reader.read(pixels, generation));
+        const float* values = reinterpret_cast<const float*>(pixels.data());
+        auto getPreviewPixel = [&](uint32_t x, uint32_t y) {
+            const float* pixel = values + (y * 40 + x) * 3;
+            return std::make_pair(static_cast<int>(pixel[0] + 0.5f), static_cast<int>(pixel[1] + 0.5f));
+        };
+
+        // The corners map onto each other, the rest to the nearest pixel
+        CHECK(getPreviewPixel(0, 0) == std::make_pair(0, 0));
+        CHECK(getPreviewPixel(39, 29) == std::make_pair(4, 3));
+        CHECK(getPreviewPixel(4, 4) == std::make_pair(0, 0));
+        CHECK(getPreviewPixel(5, 5) == std::make_pair(1, 1));
+        CHECK(getPreviewPixel(20, 15) == std::make_pair(2, 2));
+
+        // Regions leave the rest of the image alone
+        publisher.publishFilm(film);
+        previewFilm.setCropWindow({ 1, 1, 3, 2 });
+        publisher.publishUpsampled(previewFilm, { 10, 10, 29, 19 });
+        REQUIRE(reader.read(pixels, generation));
+        std::vector<float> row(40 * 3);
+        film.getRadianceRow(9, 0, 39, row.data());
+        CHECK(std::memcmp(row.data(), &pixels[9 * row.size() * sizeof(float)], row.size() * sizeof(float)) == 0);
+        CHECK(getPreviewPixel(10, 10) == std::make_pair(1, 1));
+        CHECK(getPreviewPixel(29, 19) == std::make_pair(3, 2));
+        CHECK(getPreviewPixel(9, 10).first == 0);
+    }
+
+    SECTION("Rows are consistent while publishing") {
+        pt::SharedPreviewPublisher publisher(name, 40, 30, pt::PreviewFormat::Radiance);
+        REQUIRE(publisher.isValid());
+        pt::SharedPreviewReader reader;
+        REQUIRE(reader.open(name));
+
+        // Every update fills the whole film with one value, a torn row would mix
+        // them. The expected rows come from the film, whose conversion may differ
+        // in the last bit between pixels.
+        const uint32_t numUpdates = 2000;
+        std::vector<pt::Film> films;
+        std::vector<std::vector<float>> expectedRows;
+        for (uint32_t i = 0; i <= numUpdates; i++) {
+            films.emplace_back(40, 30);
+            for (uint32_t y = 0; y < 30; y++) {
+                for (uint32_t x = 0; x < 40; x++) {
+                    films.back().addSample(x, y, pt::Vec3(static_cast<float>(i)));
+                }
+            }
+            expectedRows.emplace_back(40 * 3);
+            films.back().getRadianceRow(0, 0, 39, expectedRows.back().data());
+        }
+
+        std::atomic<bool> isDone = false;
+        std::thread writer([&] {
+            for (uint32_t i = 1; i <= numUpdates; i++) {
+                publisher.publishTile(films[i], { 0, 0, 39, 29 });
+            }
+            isDone = true;
+        });
+
+        bool areRowsConsistent = true;
+        uint64_t previousGeneration = 0;
+        bool isGenerationIncreasing = true;
+        std::vector<uint8_t> pixels;
+        while (!isDone) {
+            uint64_t generation;
+            REQUIRE(reader.read(pixels, generation));
+            isGenerationIncreasing &= generation >= previousGeneration;
+            previousGeneration = generation;
+
+            const float* values = reinterpret_cast<const float*>(pixels.data());
+            for (uint32_t y = 0; y < 30; y++) {
+                const float* row = values + y * 40 * 3;
+                uint32_t update = static_cast<uint32_t>(row[0] + 0.5f);
+                areRowsConsistent &= update <= numUpdates &&
+                    std::memcmp(row, expectedRows[update].data(), 40 * 3 * sizeof(float)) == 0;
+            }
+        }
+        writer.join();
+
+        CHECK(areRowsConsistent);
+        CHECK(isGenerationIncreasing);
+    }
+
+    SECTION("Missing segments can't be opened") {
+        pt::SharedPreviewReader reader;
+        CHECK_FALSE(reader.open(name + "_missing"));
+        CHECK(reader.getWidth() == 0);
+    }
+}